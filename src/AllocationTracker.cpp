@@ -0,0 +1,129 @@
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "GLErrors.h"
+
+static std::atomic<uint64_t> allocationCount{ 0 };
+static std::atomic<uint64_t> allocationBytes{ 0 };
+static thread_local uint64_t threadAllocationCount = 0;
+
+static void* trackedAllocate(std::size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	threadAllocationCount++;
+
+	// malloc(0) may return nullptr, operator new mustn't
+	void* pointer = std::malloc(size != 0 ? size : 1);
+	if (pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+static void* trackedAllocateAligned(std::size_t size, std::size_t alignment)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	threadAllocationCount++;
+
+	if (size == 0)
+	{
+		size = 1;
+	}
+#if defined(_MSC_VER)
+	void* pointer = _aligned_malloc(size, alignment);
+#else
+	void* pointer = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+	if (pointer == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+static void trackedFreeAligned(void* pointer)
+{
+#if defined(_MSC_VER)
+	_aligned_free(pointer);
+#else
+	std::free(pointer);
+#endif
+}
+
+void* operator new(std::size_t size) { return trackedAllocate(size); }
+void* operator new[](std::size_t size) { return trackedAllocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try { return trackedAllocate(size); }
+	catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	try { return trackedAllocate(size); }
+	catch (...) { return nullptr; }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) { return trackedAllocateAligned(size, (std::size_t)alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return trackedAllocateAligned(size, (std::size_t)alignment); }
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, std::align_val_t) noexcept { trackedFreeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { trackedFreeAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { trackedFreeAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { trackedFreeAligned(pointer); }
+
+uint64_t AllocationTracker::getCount()
+{
+	return allocationCount.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationTracker::getBytes()
+{
+	return allocationBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationTracker::getThreadCount()
+{
+	return threadAllocationCount;
+}
+
+void SteadyStateAllocations::begin(uint64_t count)
+{
+	m_start = count;
+}
+
+void SteadyStateAllocations::end(uint64_t count, bool loading)
+{
+	m_last = (unsigned int)(count - m_start);
+	m_frame = loading ? 0 : m_frame + 1;
+
+	if (m_last == 0 || m_frame <= ALLOCATION_WARMUP_FRAMES)
+	{
+		return;
+	}
+
+	m_violations++;
+	if (m_check)
+	{
+		std::cout << "Steady state frame " << m_frame << " made " << m_last << " heap allocations" << std::endl;
+#ifndef NDEBUG
+		// the debugger now has the frame, set a breakpoint in trackedAllocate() and continue to see the culprit
+		ASSERT(false);
+#endif
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+// frames the steady state check lets pass first, caches and command lists grow to their working size during these
+#define ALLOCATION_WARMUP_FRAMES 120
+
+/*
+* Counts heap allocations made through the global operator new, which AllocationTracker.cpp replaces
+* Counters are relaxed atomics, so tracking costs one uncontended increment per allocation and is always on, plus a
+* thread local count so one thread's allocations can be told apart from, say, the asset loader's.
+* Allocations that bypass operator new (malloc in C libraries, driver internals) aren't seen.
+*/
+class AllocationTracker
+{
+public:
+	// allocations/bytes since startup, all threads
+	static uint64_t getCount();
+	static uint64_t getBytes();
+	// allocations since startup of the calling thread only
+	static uint64_t getThreadCount();
+};
+
+// counts the allocations of one span of every frame (simulation + recording + submission) and, when checking,
+// complains about any made once the warm-up frames are over, breaking into the debugger in debug builds
+// counts come from the caller (see Scene::getAllocationCount()), so threads outside the frame don't show up
+class SteadyStateAllocations
+{
+private:
+	bool m_check;
+	unsigned int m_frame = 0;
+	uint64_t m_start = 0;
+	unsigned int m_last = 0;
+	unsigned int m_violations = 0;
+
+public:
+	explicit SteadyStateAllocations(bool check) : m_check(check) {}
+
+	void begin(uint64_t count);
+	// frames that were still loading aren't steady state, the warm-up starts over after them
+	void end(uint64_t count, bool loading);
+
+	// allocations in the span of the last frame
+	unsigned int getLast() const { return m_last; }
+	// steady state frames that allocated
+	unsigned int getViolations() const { return m_violations; }
+};
@@ -0,0 +1,312 @@
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+#include "BodyCatalog.h"
+#include "MeshCache.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "Skybox.h"
+#include "TextureCache.h"
+
+// the one mount() opens, read only once loading starts so the workers can look in it without locking
+static AssetArchive s_mounted;
+
+bool AssetArchive::open(const std::string& path)
+{
+	PROFILE_ZONE("AssetArchive::open");
+
+	m_header = nullptr;
+	m_entries = nullptr;
+	m_names = nullptr;
+
+	if (!m_file.open(path))
+	{
+		return false;
+	}
+
+	const uint8_t* data = m_file.getData();
+	size_t size = m_file.getSize();
+	const ArchiveHeader* header = (const ArchiveHeader*)data;
+
+	bool valid = size >= sizeof(ArchiveHeader) && header->magic == ASSET_ARCHIVE_MAGIC && header->version == ASSET_ARCHIVE_VERSION
+		&& header->size == size && header->entryCount <= (size - sizeof(ArchiveHeader)) / sizeof(ArchiveEntry)
+		&& header->namesSize <= size - sizeof(ArchiveHeader) - size_t(header->entryCount) * sizeof(ArchiveEntry);
+
+	const ArchiveEntry* entries = (const ArchiveEntry*)(data + sizeof(ArchiveHeader));
+	const char* names = (const char*)(entries + (valid ? header->entryCount : 0));
+	for (uint32_t i = 0; valid && i < header->entryCount; i++)
+	{
+		const ArchiveEntry& entry = entries[i];
+		valid = uint64_t(entry.nameOffset) + entry.nameLength <= header->namesSize
+			&& entry.offset % ASSET_ARCHIVE_ALIGNMENT == 0 && entry.offset <= size && size - entry.offset >= entry.size;
+
+		// find() relies on the order
+		if (valid && i > 0)
+		{
+			const ArchiveEntry& previous = entries[i - 1];
+			valid = std::string(names + previous.nameOffset, previous.nameLength) < std::string(names + entry.nameOffset, entry.nameLength);
+		}
+	}
+
+	if (!valid)
+	{
+		std::cout << "Not an asset archive of this version: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	m_header = header;
+	m_entries = entries;
+	m_names = names;
+	return true;
+}
+
+bool AssetArchive::find(const std::string& path, const uint8_t*& data, size_t& size) const
+{
+	if (m_header == nullptr)
+	{
+		return false;
+	}
+
+	std::string key = getKey(path);
+	const ArchiveEntry* end = m_entries + m_header->entryCount;
+	const ArchiveEntry* entry = std::lower_bound(m_entries, end, key, [this](const ArchiveEntry& entry, const std::string& key)
+	{
+		return key.compare(0, std::string::npos, m_names + entry.nameOffset, entry.nameLength) > 0;
+	});
+
+	if (entry == end || key.compare(0, std::string::npos, m_names + entry->nameOffset, entry->nameLength) != 0)
+	{
+		return false;
+	}
+
+	data = m_file.getData() + entry->offset;
+	size = size_t(entry->size);
+	return true;
+}
+
+std::string AssetArchive::getKey(const std::string& path)
+{
+	std::string key;
+	size_t start = 0;
+	while (start <= path.size())
+	{
+		size_t end = path.find_first_of("/\\", start);
+		if (end == std::string::npos)
+		{
+			end = path.size();
+		}
+
+		std::string segment = path.substr(start, end - start);
+		if (!segment.empty() && segment != ".")
+		{
+			if (!key.empty())
+			{
+				key.push_back('/');
+			}
+			key += segment;
+		}
+		start = end + 1;
+	}
+	return key;
+}
+
+bool AssetArchive::mount(const std::string& path)
+{
+	if (!s_mounted.open(path))
+	{
+		return false;
+	}
+
+	std::cout << "Mounted asset archive " << path << ": " << s_mounted.getFileCount() << " files, "
+		<< s_mounted.getSize() / 1024 << " KB" << std::endl;
+	return true;
+}
+
+bool findArchivedFile(const std::string& path, const uint8_t*& data, size_t& size)
+{
+	return s_mounted.find(path, data, size);
+}
+
+// a file going into the archive under its key
+struct PackedFile
+{
+	std::string key;
+	std::vector<uint8_t> data;
+};
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& data)
+{
+	MappedFile file;
+	if (!file.open(path))
+	{
+		return false;
+	}
+	data.assign(file.getData(), file.getData() + file.getSize());
+	return true;
+}
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + ASSET_ARCHIVE_ALIGNMENT - 1) / ASSET_ARCHIVE_ALIGNMENT * ASSET_ARCHIVE_ALIGNMENT;
+}
+
+static bool writeArchive(std::vector<PackedFile>& files, const std::string& outputPath)
+{
+	std::sort(files.begin(), files.end(), [](const PackedFile& a, const PackedFile& b) { return a.key < b.key; });
+
+	ArchiveHeader header = {};
+	header.magic = ASSET_ARCHIVE_MAGIC;
+	header.version = ASSET_ARCHIVE_VERSION;
+	header.entryCount = (uint32_t)files.size();
+
+	std::vector<ArchiveEntry> entries(files.size());
+	std::string names;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		entries[i].nameOffset = (uint32_t)names.size();
+		entries[i].nameLength = (uint32_t)files[i].key.size();
+		names += files[i].key;
+	}
+	header.namesSize = (uint32_t)names.size();
+
+	uint64_t offset = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry) + names.size();
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		entries[i].offset = alignOffset(offset);
+		entries[i].size = files[i].data.size();
+		offset = entries[i].offset + entries[i].size;
+	}
+	header.size = offset;
+
+	std::ofstream out(outputPath, std::ios::binary);
+	if (!out)
+	{
+		std::cout << "Failed to write asset archive: " << outputPath << std::endl;
+		return false;
+	}
+
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)entries.data(), entries.size() * sizeof(ArchiveEntry));
+	out.write(names.data(), names.size());
+
+	const char padding[ASSET_ARCHIVE_ALIGNMENT] = {};
+	uint64_t written = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry) + names.size();
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		out.write(padding, std::streamsize(entries[i].offset - written));
+		out.write((const char*)files[i].data.data(), files[i].data.size());
+		written = entries[i].offset + entries[i].size;
+	}
+	return bool(out);
+}
+
+bool packAssets(const SceneDirectories& directories, const std::string& outputPath)
+{
+	PROFILE_ZONE("packAssets");
+
+	std::vector<PackedFile> files;
+	// keys already packed, textures are shared between models
+	std::unordered_set<std::string> packed;
+
+	auto addFile = [&](const std::string& path, std::vector<uint8_t>&& data)
+	{
+		std::string key = AssetArchive::getKey(path);
+		if (packed.insert(key).second)
+		{
+			files.push_back({ key, std::move(data) });
+		}
+	};
+
+	// every shader, whichever the scene ends up using
+	std::error_code error;
+	for (const auto& item : std::filesystem::directory_iterator(directories.shaders, error))
+	{
+		std::vector<uint8_t> data;
+		if (item.is_regular_file() && readFile(directories.shaders + item.path().filename().string(), data))
+		{
+			addFile(directories.shaders + item.path().filename().string(), std::move(data));
+		}
+	}
+	if (error)
+	{
+		std::cout << "Failed to list shaders: " << directories.shaders << std::endl;
+		return false;
+	}
+
+	// compiled, whether the catalog file is text or not
+	BodyCatalog catalog;
+	std::vector<std::string> models = { directories.models + "asteroid.obj" };
+	if (catalog.load(directories.catalog))
+	{
+		addFile(directories.catalog, std::vector<uint8_t>(catalog.getData(), catalog.getData() + catalog.getSize()));
+		std::vector<std::string> catalogModels = getCatalogModels(catalog, directories.models);
+		models.insert(models.end(), catalogModels.begin(), catalogModels.end());
+	}
+
+	// the mesh caches as ModelData::load() leaves them, and the textures their meshes name
+	for (const std::string& model : models)
+	{
+		ModelData data;
+		std::vector<uint8_t> cache;
+		if (!data.load(model) || !readFile(model + MESH_CACHE_EXTENSION, cache))
+		{
+			std::cout << "Failed to pack model: " << model << std::endl;
+			return false;
+		}
+		addFile(model + MESH_CACHE_EXTENSION, std::move(cache));
+
+		std::string directory = model.substr(0, model.find_last_of('/') + 1);
+		for (size_t i = 0; i < data.getMeshes().size(); i++)
+		{
+			std::string texturePath = directory + data.getTexture(i);
+			if (packed.count(AssetArchive::getKey(texturePath + TEXTURE_CACHE_EXTENSION)) != 0)
+			{
+				continue;
+			}
+
+			// left out, the scene is drawn without it either way
+			CompressedTexture texture;
+			if (!texture.load(texturePath, true))
+			{
+				std::cout << "Failed to pack texture, skipped: " << texturePath << std::endl;
+				continue;
+			}
+			addFile(texturePath + TEXTURE_CACHE_EXTENSION, std::vector<uint8_t>(texture.getBlob(), texture.getBlob() + texture.getBlobSize()));
+		}
+	}
+
+	// cube map faces are only ever sampled at full size, the same as AssetLoader loads them
+	std::string faces[6];
+	Skybox::getTexturePaths(directories.skybox, faces);
+	for (const std::string& face : faces)
+	{
+		CompressedTexture texture;
+		if (!texture.load(face, false))
+		{
+			std::cout << "Failed to pack texture: " << face << std::endl;
+			return false;
+		}
+		addFile(face + TEXTURE_CACHE_EXTENSION, std::vector<uint8_t>(texture.getBlob(), texture.getBlob() + texture.getBlobSize()));
+	}
+
+	if (!writeArchive(files, outputPath))
+	{
+		return false;
+	}
+
+	size_t size = 0;
+	for (const PackedFile& file : files)
+	{
+		size += file.data.size();
+	}
+	std::cout << "Packed " << files.size() << " files (" << size << " bytes): " << outputPath << std::endl;
+	return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.h"
+
+#define ASSET_ARCHIVE_MAGIC 0x4B415041u // "APAK" little-endian
+// bump whenever ArchiveHeader, ArchiveEntry or the layout changes
+#define ASSET_ARCHIVE_VERSION 1u
+// of every file's data, the mesh and texture caches it holds are read in place and their own alignment is relative
+#define ASSET_ARCHIVE_ALIGNMENT 16
+
+// at the start of the archive, followed by entryCount ArchiveEntry sorted by name, then the names, then the data
+struct ArchiveHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t namesSize;
+	// of the whole archive
+	uint64_t size;
+};
+
+struct ArchiveEntry
+{
+	// from the start of the archive
+	uint64_t offset;
+	uint64_t size;
+	// into the names, not null terminated
+	uint32_t nameOffset;
+	uint32_t nameLength;
+};
+
+static_assert(sizeof(ArchiveHeader) == 24, "archive header layout is part of the file format");
+static_assert(sizeof(ArchiveEntry) == 24, "archive entry layout is part of the file format");
+
+/*
+* Every file the scene loads at startup packed into one, mapped and read in place
+* The shaders, the compiled catalog and the mesh and texture caches are written by packAssets() into a single file
+* with a sorted index at its front. Opening it is one mapping instead of an open and read per file, and the caches
+* inside it are viewed straight out of the mapping like their loose counterparts.
+* Files are looked up by their path as the loaders name them, see getKey(). Archived caches aren't checked against
+* their sources, the archive is what ships instead of them, so it's only mounted when asked for (--archive): one left
+* next to sources edited since it was packed would otherwise keep shadowing them.
+*/
+class AssetArchive
+{
+private:
+	MappedFile m_file;
+	const ArchiveHeader* m_header = nullptr;
+	const ArchiveEntry* m_entries = nullptr;
+	const char* m_names = nullptr;
+
+public:
+	AssetArchive() = default;
+
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive& operator=(const AssetArchive&) = delete;
+
+	// maps and validates the archive, prints why and returns false if it can't be used
+	bool open(const std::string& path);
+
+	// view of a file in the archive, valid as long as the archive is open
+	bool find(const std::string& path, const uint8_t*& data, size_t& size) const;
+
+	bool isOpen() const { return m_header != nullptr; }
+	uint32_t getFileCount() const { return m_header != nullptr ? m_header->entryCount : 0; }
+	size_t getSize() const { return m_file.getSize(); }
+
+	// '/' separated, without "." segments or a leading "./", so "./resources//a.png" and "resources/a.png" match
+	static std::string getKey(const std::string& path);
+
+	// opens the archive every loader looks in before the file system, once at startup before any loading starts
+	static bool mount(const std::string& path);
+};
+
+// view of the file in the mounted archive, false if there's no archive or the file isn't in it
+bool findArchivedFile(const std::string& path, const uint8_t*& data, size_t& size);
+
+struct SceneDirectories;
+
+// builds the caches of everything the scene in directories loads at startup and writes them with the shaders and the
+// compiled catalog into one archive, no GL needed
+bool packAssets(const SceneDirectories& directories, const std::string& outputPath);
@@ -0,0 +1,488 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#include <stb/stb_image.h>
+
+#include "GLErrors.h"
+#include "Profiler.h"
+#include "Skybox.h"
+#include "StartupTimeline.h"
+
+AssetLoader::AssetLoader(JobSystem& jobs, ResourceRegistry& resources)
+	: m_jobs(jobs), m_resources(resources)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+	// destroyed while still loading, the workers have to be done with this before it goes
+	if (m_dispatcher.joinable())
+	{
+		m_dispatcher.join();
+	}
+	for (DecodedImage& image : m_ready)
+	{
+		stbi_image_free(image.pixels);
+	}
+	// faces of cube maps that never got all six in
+	for (std::vector<DecodedImage>& faces : m_cubeMapDecoded)
+	{
+		for (DecodedImage& image : faces)
+		{
+			stbi_image_free(image.pixels);
+		}
+	}
+
+	// meshes built from the models hold references of their own
+	for (unsigned int texture : m_textures)
+	{
+		m_resources.releaseTexture(texture);
+	}
+}
+
+unsigned int AssetLoader::addModel(const std::string& path)
+{
+	auto it = std::find(m_modelPaths.begin(), m_modelPaths.end(), path);
+	if (it != m_modelPaths.end())
+	{
+		return (unsigned int)(it - m_modelPaths.begin());
+	}
+	m_modelPaths.push_back(path);
+	return (unsigned int)m_modelPaths.size() - 1;
+}
+
+unsigned int AssetLoader::addCubeMap(const std::string faces[6])
+{
+	m_cubeMapFaces.insert(m_cubeMapFaces.end(), faces, faces + 6);
+	return (unsigned int)m_cubeMapFaces.size() / 6 - 1;
+}
+
+const ModelData* AssetLoader::getModel(const std::string& path) const
+{
+	auto it = std::find(m_modelPaths.begin(), m_modelPaths.end(), path);
+	size_t model = size_t(it - m_modelPaths.begin());
+	if (it == m_modelPaths.end() || model >= m_models.size())
+	{
+		return nullptr;
+	}
+
+	// a worker may still be writing it otherwise
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_parsed[model] ? m_models[model].get() : nullptr;
+}
+
+void AssetLoader::setModelPriority(unsigned int model, float priority)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_priorities[model] = priority;
+}
+
+void AssetLoader::setCubeMapPriority(unsigned int cubeMap, float priority)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (unsigned int face = 0; face < 6; face++)
+	{
+		m_priorities[m_modelPaths.size() + cubeMap * 6 + face] = priority;
+	}
+}
+
+bool AssetLoader::isModelReady(unsigned int model)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_parsed[model])
+	{
+		return false;
+	}
+
+	// a texture shared with another model may be uploaded as part of that one
+	for (const std::string& texture : m_modelTextures[model])
+	{
+		if (m_uploaded.count(texture) == 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool AssetLoader::isCubeMapReady(unsigned int cubeMap) const
+{
+	return m_facesUploaded[cubeMap] == 6;
+}
+
+void AssetLoader::loadJob(void* context, unsigned int /*index*/, unsigned int /*slot*/)
+{
+	AssetLoader& loader = *(AssetLoader*)context;
+
+	// the index only counts the jobs, which one runs is whatever matters most right now
+	unsigned int job;
+	{
+		std::lock_guard<std::mutex> lock(loader.m_mutex);
+		auto best = std::max_element(loader.m_queued.begin(), loader.m_queued.end(), [&loader](unsigned int a, unsigned int b)
+		{
+			return loader.m_priorities[a] < loader.m_priorities[b];
+		});
+		job = *best;
+		*best = loader.m_queued.back();
+		loader.m_queued.pop_back();
+	}
+
+	if (job < loader.m_modelPaths.size())
+	{
+		loader.parseModel(job);
+		return;
+	}
+
+	unsigned int face = job - (unsigned int)loader.m_modelPaths.size();
+	loader.decodeImage(loader.m_cubeMapFaces[face], int(face / 6), int(face % 6), job);
+}
+
+void AssetLoader::parseModel(unsigned int model)
+{
+	PROFILE_ZONE("AssetLoader::parseModel");
+
+	const std::string& path = m_modelPaths[model];
+	STARTUP_ASSET("AssetLoader::parseModel", path);
+	uint64_t start = Profiler::now();
+
+	auto data = std::make_unique<ModelData>();
+	bool loaded = data->load(path);
+
+	uint64_t end = Profiler::now();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_parseEnd = std::max(m_parseEnd, end);
+		m_parseBusy += end - start;
+	}
+
+	if (!loaded)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_parsed[model] = true;
+		return;
+	}
+
+	// the same directory loadModel() looks for the textures in
+	std::string directory = path.substr(0, path.find_last_of('/') + 1);
+	std::vector<std::string> textures;
+	for (size_t i = 0; i < data->getMeshes().size(); i++)
+	{
+		textures.push_back(directory + data->getTexture(i));
+	}
+
+	// the model counts as parsed before its textures are decoded, they're what it waits for then
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_models[model] = std::move(data);
+		m_modelTextures[model] = textures;
+		m_parsed[model] = true;
+	}
+
+	for (const std::string& texturePath : textures)
+	{
+		bool claimed;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			claimed = m_claimed.insert(texturePath).second;
+		}
+		if (claimed)
+		{
+			decodeImage(texturePath, -1, 0, model);
+		}
+	}
+}
+
+// when there's no texture cache, or it has nothing for the image
+static void decodePixels(DecodedImage& image)
+{
+	StartupTimeline::addFileRead(image.path);
+	image.pixels = stbi_load(image.path.c_str(), &image.width, &image.height, &image.channels, 0);
+}
+
+void AssetLoader::decodeImage(const std::string& path, int cubeMap, int face, unsigned int job)
+{
+	PROFILE_ZONE("AssetLoader::decodeImage");
+	STARTUP_ASSET("AssetLoader::decodeImage", path);
+
+	DecodedImage image;
+	image.path = path;
+	image.cubeMap = cubeMap;
+	image.face = face;
+	image.job = job;
+
+	uint64_t start = Profiler::now();
+	if (m_compress)
+	{
+		// cube map faces are only ever sampled at full size
+		image.compressed = std::make_unique<CompressedTexture>();
+		if (!image.compressed->load(path, cubeMap < 0))
+		{
+			image.compressed.reset();
+		}
+	}
+	if (image.compressed == nullptr)
+	{
+		decodePixels(image);
+	}
+	uint64_t end = Profiler::now();
+
+	bool loaded = image.compressed != nullptr || image.pixels != nullptr;
+	if (!loaded)
+	{
+		std::cout << "Failed to load texture: " << path << std::endl;
+	}
+
+	// the worker decoding the last face of a cube map hands all six over
+	std::vector<DecodedImage> faces;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decodeStart = m_decodeStart == 0 ? start : std::min(m_decodeStart, start);
+		m_decodeEnd = std::max(m_decodeEnd, end);
+		m_decodeBusy += end - start;
+		if (cubeMap < 0)
+		{
+			// a failed one too, so whatever waits for it isn't waiting forever
+			m_ready.push_back(std::move(image));
+		}
+		else
+		{
+			m_cubeMapDecoded[cubeMap].push_back(std::move(image));
+			if (m_cubeMapDecoded[cubeMap].size() == 6)
+			{
+				faces.swap(m_cubeMapDecoded[cubeMap]);
+			}
+		}
+	}
+
+	if (cubeMap >= 0)
+	{
+		if (faces.empty())
+		{
+			return;
+		}
+
+		// a face the texture cache had nothing for makes the whole cube map uncompressed, the faces it did have are
+		// decoded again
+		bool uncompressed = std::any_of(faces.begin(), faces.end(), [](const DecodedImage& decoded)
+		{
+			return decoded.compressed == nullptr;
+		});
+		if (uncompressed)
+		{
+			start = Profiler::now();
+			for (DecodedImage& decoded : faces)
+			{
+				if (decoded.compressed != nullptr)
+				{
+					decoded.compressed.reset();
+					decodePixels(decoded);
+				}
+			}
+			end = Profiler::now();
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (uncompressed)
+		{
+			m_decodeEnd = std::max(m_decodeEnd, end);
+			m_decodeBusy += end - start;
+		}
+		for (DecodedImage& decoded : faces)
+		{
+			m_ready.push_back(std::move(decoded));
+		}
+	}
+	m_decoded.notify_one();
+}
+
+void AssetLoader::uploadImage(DecodedImage& image)
+{
+	PROFILE_ZONE("AssetLoader::uploadImage");
+	STARTUP_ASSET("AssetLoader::uploadImage", image.path);
+
+	if (image.cubeMap < 0)
+	{
+		m_uploaded.insert(image.path);
+	}
+	else
+	{
+		m_facesUploaded[image.cubeMap]++;
+	}
+	if (image.compressed == nullptr && image.pixels == nullptr)
+	{
+		return;
+	}
+	m_times.images++;
+
+	size_t size = size_t(image.width) * image.height * image.channels;
+	if (image.cubeMap < 0)
+	{
+		unsigned int texture = image.compressed != nullptr ? m_resources.acquireTexture(image.path, *image.compressed, &m_ring)
+			: m_resources.acquireTexture(image.path, image.pixels, image.width, image.height, image.channels, &m_ring);
+		m_textures.push_back(texture);
+	}
+	else
+	{
+		GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X + image.face;
+		GLCall(glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubeMaps[image.cubeMap]));
+		if (image.compressed != nullptr)
+		{
+			uploadCompressedLevels(face, *image.compressed, &m_ring);
+		}
+		else
+		{
+			m_ring.texImage2D(face, image.width, image.height, image.pixels, size);
+		}
+		GLCall(glBindTexture(GL_TEXTURE_CUBE_MAP, 0));
+	}
+
+	// the mapping or the pixels aren't needed once they're on the GPU
+	image.compressed.reset();
+	stbi_image_free(image.pixels);
+	image.pixels = nullptr;
+}
+
+void AssetLoader::start()
+{
+	PROFILE_ZONE("AssetLoader::start");
+	STARTUP_PHASE("AssetLoader::start");
+
+	m_start = Profiler::now();
+	m_parseEnd = m_parseBusy = m_decodeStart = m_decodeEnd = m_decodeBusy = 0;
+	m_uploadStart = m_uploadEnd = m_uploadBusy = 0;
+	m_finished = false;
+	m_done = false;
+	m_times = AssetLoadTimes();
+	m_models.clear();
+	m_models.resize(m_modelPaths.size());
+	m_parsed.assign(m_modelPaths.size(), false);
+	m_modelTextures.assign(m_modelPaths.size(), {});
+
+	// textures made here so the faces have somewhere to go when they arrive
+	for (size_t i = m_cubeMaps.size(); i < m_cubeMapFaces.size() / 6; i++)
+	{
+		m_cubeMaps.push_back(Skybox::createCubeMapTexture());
+	}
+	m_facesUploaded.assign(m_cubeMaps.size(), 0);
+	m_cubeMapDecoded.clear();
+	m_cubeMapDecoded.resize(m_cubeMaps.size());
+
+	// the flag is global to stb_image, set it before any worker decodes
+	stbi_set_flip_vertically_on_load(false);
+	m_compress = m_resources.compressesTextures();
+
+	unsigned int jobs = (unsigned int)(m_modelPaths.size() + m_cubeMapFaces.size());
+	m_priorities.resize(jobs, 0.0f);
+	m_queued.clear();
+	for (unsigned int job = 0; job < jobs; job++)
+	{
+		m_queued.push_back(job);
+	}
+
+	// parallelFor only returns when every job is done, dispatching from a thread of its own leaves this one free to
+	// upload while the workers decode
+	m_dispatcher = std::thread([this, jobs]()
+	{
+		Profiler::setThreadName("Asset loader");
+		m_jobs.parallelFor(jobs, loadJob, this);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_finished = true;
+		}
+		m_decoded.notify_one();
+	});
+}
+
+bool AssetLoader::poll(uint64_t budget, bool wait)
+{
+	PROFILE_ZONE("AssetLoader::poll");
+
+	if (m_done)
+	{
+		return true;
+	}
+
+	uint64_t pollStart = Profiler::now();
+	while (true)
+	{
+		DecodedImage image;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (wait)
+			{
+				m_decoded.wait(lock, [this] { return m_finished || !m_ready.empty(); });
+			}
+			if (m_ready.empty())
+			{
+				if (m_finished)
+				{
+					break;
+				}
+				return false;
+			}
+
+			// the image of whatever matters most now, which may have changed since it was decoded
+			auto best = std::max_element(m_ready.begin(), m_ready.end(), [this](const DecodedImage& a, const DecodedImage& b)
+			{
+				return m_priorities[a.job] < m_priorities[b.job];
+			});
+			image = std::move(*best);
+			*best = std::move(m_ready.back());
+			m_ready.pop_back();
+		}
+
+		uint64_t start = Profiler::now();
+		uploadImage(image);
+		m_uploadEnd = Profiler::now();
+		m_uploadStart = m_uploadStart == 0 ? start : m_uploadStart;
+		m_uploadBusy += m_uploadEnd - start;
+
+		if (m_uploadEnd - pollStart >= budget)
+		{
+			return false;
+		}
+	}
+
+	finish();
+	return true;
+}
+
+void AssetLoader::finish()
+{
+	m_dispatcher.join();
+	m_done = true;
+
+	uint64_t end = Profiler::now();
+	auto toMs = [](uint64_t nanoseconds) { return double(nanoseconds) / 1e6; };
+
+	m_times.models = (unsigned int)m_modelPaths.size();
+	m_times.threads = m_jobs.getNumWorkers() + (m_jobs.callerParticipates() ? 1 : 0);
+	m_times.parseWall = toMs(m_parseEnd > m_start ? m_parseEnd - m_start : 0);
+	m_times.parseBusy = toMs(m_parseBusy);
+	m_times.decodeWall = toMs(m_decodeEnd - m_decodeStart);
+	m_times.decodeBusy = toMs(m_decodeBusy);
+	m_times.uploadWall = toMs(m_uploadEnd - m_uploadStart);
+	m_times.uploadBusy = toMs(m_uploadBusy);
+	m_times.total = toMs(end - m_start);
+}
+
+void AssetLoader::load()
+{
+	PROFILE_ZONE("AssetLoader::load");
+
+	start();
+	while (!poll(UINT64_MAX, true))
+	{
+	}
+}
+
+void AssetLoader::printTimes() const
+{
+	std::cout << "Assets: " << m_times.models << " models, " << m_times.images << " images on " << m_times.threads << " threads; parse "
+		<< m_times.parseWall << " ms (" << m_times.parseBusy << " busy), decode " << m_times.decodeWall << " ms ("
+		<< m_times.decodeBusy << " busy), upload " << m_times.uploadWall << " ms (" << m_times.uploadBusy << " busy); total "
+		<< m_times.total << " ms" << std::endl;
+}
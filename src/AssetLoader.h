@@ -0,0 +1,174 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "JobSystem.h"
+#include "MeshCache.h"
+#include "PixelUploadRing.h"
+#include "ResourceRegistry.h"
+#include "TextureCache.h"
+
+// a model texture or cube map face decoded on a worker, waiting for the GL thread to upload it
+struct DecodedImage
+{
+	std::string path;
+	// from the texture cache when the context supports it, otherwise the pixels
+	std::unique_ptr<CompressedTexture> compressed;
+	// from stbi_load, freed once uploaded
+	unsigned char* pixels = nullptr;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	// -1 for a model texture, otherwise which cube map and face it goes into
+	int cubeMap = -1;
+	int face = 0;
+	// the job that decoded it, whose priority it's uploaded by
+	unsigned int job = 0;
+};
+
+// how long each phase of AssetLoader::load() took, in milliseconds
+// wall is from the first to the last time anything of the phase ran, busy adds up every thread's time in it
+struct AssetLoadTimes
+{
+	double parseWall = 0.0;
+	double parseBusy = 0.0;
+	// texture cache loads included
+	double decodeWall = 0.0;
+	double decodeBusy = 0.0;
+	double uploadWall = 0.0;
+	double uploadBusy = 0.0;
+	double total = 0.0;
+
+	unsigned int models = 0;
+	unsigned int images = 0;
+	// threads the parse and decode ran on
+	unsigned int threads = 0;
+};
+
+/*
+* Loads every model, model texture and cube map of a scene at once
+* Models are parsed (ModelData::load(), the mesh cache or an import) and their textures and the cube map faces are
+* loaded from the texture cache (CompressedTexture::load()) or decoded on the job system's workers. The thread with the
+* GL context uploads each image through a PixelUploadRing as soon as it's ready, so uploads overlap with the decoding
+* still going on: either all at once in load(), or a frame's budget at a time in poll() while the scene is already
+* drawn. Workers take the model or cube map with the highest priority next and the most important ready image is
+* uploaded first, priorities can change while loading.
+* Model textures go into the registry under their path, so Mesh construction afterwards finds them without decoding
+* again. The loader holds a reference to them until it's destroyed.
+*/
+class AssetLoader
+{
+private:
+	JobSystem& m_jobs;
+	ResourceRegistry& m_resources;
+	PixelUploadRing m_ring;
+
+	// by index in the order they were added
+	std::vector<std::string> m_modelPaths;
+	std::vector<std::unique_ptr<ModelData>> m_models;
+	// 6 faces per cube map, in the GL_TEXTURE_CUBE_MAP_POSITIVE_X + face order
+	std::vector<std::string> m_cubeMapFaces;
+	std::vector<unsigned int> m_cubeMaps;
+
+	// model textures acquired from the registry, released in the destructor
+	std::vector<unsigned int> m_textures;
+
+	// runs the job system's parallelFor, so the GL thread is free to upload
+	std::thread m_dispatcher;
+
+	// shared between the workers and the uploading thread
+	mutable std::mutex m_mutex;
+	std::condition_variable m_decoded;
+	std::vector<DecodedImage> m_ready;
+	bool m_finished = false;
+	// texture paths some worker is decoding or has decoded, so a texture shared by models is decoded once
+	std::unordered_set<std::string> m_claimed;
+	// images come from the texture cache, decided on the GL thread before the workers start
+	bool m_compress = false;
+	// cube map faces decoded so far, held back until all six are so that a cube map is compressed as a whole or not
+	// at all; sampling one that mixes formats across its faces is undefined
+	std::vector<std::vector<DecodedImage>> m_cubeMapDecoded;
+	// by job (models, then cube maps faces), higher goes first
+	std::vector<float> m_priorities;
+	// jobs no worker has taken yet
+	std::vector<unsigned int> m_queued;
+	// by model, set once a worker is done with it, failed or not, with the textures its meshes use
+	std::vector<bool> m_parsed;
+	std::vector<std::vector<std::string>> m_modelTextures;
+
+	// only touched on the GL thread: textures uploaded (or that failed to load) and faces uploaded per cube map
+	std::unordered_set<std::string> m_uploaded;
+	std::vector<unsigned int> m_facesUploaded;
+	bool m_done = false;
+
+	// Profiler::now() timestamps and sums, guarded by m_mutex while the workers run
+	uint64_t m_start = 0;
+	uint64_t m_parseEnd = 0;
+	uint64_t m_parseBusy = 0;
+	uint64_t m_decodeStart = 0;
+	uint64_t m_decodeEnd = 0;
+	uint64_t m_decodeBusy = 0;
+	// GL thread only
+	uint64_t m_uploadStart = 0;
+	uint64_t m_uploadEnd = 0;
+	uint64_t m_uploadBusy = 0;
+	AssetLoadTimes m_times;
+
+	// takes the queued job with the highest priority, models first, then the cube map faces
+	static void loadJob(void* context, unsigned int index, unsigned int slot);
+	void parseModel(unsigned int model);
+	void decodeImage(const std::string& path, int cubeMap, int face, unsigned int job);
+	// on the GL thread
+	void uploadImage(DecodedImage& image);
+	void finish();
+
+public:
+	AssetLoader(JobSystem& jobs, ResourceRegistry& resources);
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// queues a model and the textures its materials name, adding one twice loads it once, returns what the model is
+	// known by to the priority and readiness calls
+	unsigned int addModel(const std::string& path);
+	// queues a cube map from 6 faces (right, left, top, bottom, back, front), returns what getCubeMap() takes
+	unsigned int addCubeMap(const std::string faces[6]);
+
+	// starts parsing and decoding everything queued on the workers and returns, the cube map textures exist from here
+	// on but are black until their faces are uploaded; must be called on the thread with the GL context
+	void start();
+	// uploads the most important images that are ready, for up to budget nanoseconds (at least one if there is one),
+	// wait blocks until one is ready instead of returning with nothing; true once everything is on the GPU
+	// must be called on the thread with the GL context
+	bool poll(uint64_t budget, bool wait = false);
+	// start() and poll() until everything queued is on the GPU
+	void load();
+
+	// higher is loaded and uploaded sooner, 0 for all of them until set, after start()
+	void setModelPriority(unsigned int model, float priority);
+	void setCubeMapPriority(unsigned int cubeMap, float priority);
+
+	// parsed (or failed to) and all its textures uploaded, getModel() then has it
+	bool isModelReady(unsigned int model);
+	// all 6 faces uploaded
+	bool isCubeMapReady(unsigned int cubeMap) const;
+
+	// nullptr if the model wasn't added, isn't ready yet or failed to load, valid as long as the loader
+	const ModelData* getModel(const std::string& path) const;
+	// texture ID of a cube map, whoever draws it owns it
+	unsigned int getCubeMap(unsigned int cubeMap) const { return m_cubeMaps[cubeMap]; }
+
+	// complete once poll() returned true
+	const AssetLoadTimes& getTimes() const { return m_times; }
+	// one line: counts, per phase wall and busy time, total
+	void printTimes() const;
+};
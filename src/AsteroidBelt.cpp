@@ -0,0 +1,181 @@
+#include "AsteroidBelt.h"
+
+#include <algorithm>
+
+// rng to generate number between -1 and 1
+float randfloat()
+{
+	return -1.0f + (rand() / (RAND_MAX / 2.0f));
+}
+
+// rng to generate number between -1 to -0.3 or 0.3 to 1
+float randscale()
+{
+	return (0.3f + (rand() / RAND_MAX * 0.7f)) * ((rand() % 2) * 2 - 1);
+}
+
+std::vector<glm::mat4> genAsteroidModels(const unsigned int numberAsteroids, double radius, double radiusDeviation)
+{
+	// holds different transformations for each asteroid
+	std::vector<glm::mat4> instanceMatrix;
+
+	// additional scaling
+	glm::mat4 addScale = glm::scale(glm::mat4(1.0f), glm::vec3(0.5f, 0.5f, 0.5f)); 
+
+	for (unsigned int i = 0; i < numberAsteroids; i++)
+	{
+		// using equation x^2 + y^2 = radius^2 (circle)
+		float x = randfloat(); // -1 to 1
+		float finalRadius = radius + randfloat() * radiusDeviation;
+		float y = ((rand() % 2) * 2 - 1) * sqrt(1.0f - x * x); // +/- sqrt(1-x^2) -> -1 to 1
+
+		glm::vec3 tempTranslation;
+		glm::quat tempRotation;
+		glm::vec3 tempScale;
+
+		// makes the random distribution more even
+		if (randfloat() > 0.5f)
+		{
+			tempTranslation = glm::vec3(y * finalRadius, randfloat(), x * finalRadius);
+		}
+		else
+		{
+			tempTranslation = glm::vec3(x * finalRadius, randfloat(), y * finalRadius);
+		}
+		// random rotations
+		tempRotation = glm::quat(1.0f, randfloat(), randfloat(), randfloat());
+		// random scales
+		tempScale = 0.1f * glm::vec3(randscale(), randscale(), randscale());
+
+		// model matrix components
+		glm::mat4 trans = glm::translate(glm::mat4(1.0f), tempTranslation);
+		glm::mat4 rot = glm::mat4_cast(tempRotation);
+		glm::mat4 sca = glm::scale(glm::mat4(1.0f), tempScale);
+
+		instanceMatrix.push_back(trans * rot * sca * addScale);
+	}
+
+	return instanceMatrix;
+}
+
+double sceneDistance(double au)
+{
+	// semi-major axes of mercury to neptune in AU, and the a of their orbit in the catalog
+	static const double planetAU[] = { 0.0, 0.387, 0.723, 1.0, 1.524, 5.203, 9.537, 19.19, 30.07 };
+	static const double planetScene[] = { 0.0, 340.0, 380.0, 420.0, 460.0, 650.0, 800.0, 900.0, 970.0 };
+	const int count = sizeof(planetAU) / sizeof(planetAU[0]);
+
+	int i = 1;
+	while (i < count - 1 && au > planetAU[i])
+	{
+		i++;
+	}
+
+	double t = (au - planetAU[i - 1]) / (planetAU[i] - planetAU[i - 1]);
+	return planetScene[i - 1] + t * (planetScene[i] - planetScene[i - 1]);
+}
+
+glm::vec3 minorPlanetPosition(const OrbitalElements& elements)
+{
+	glm::dvec3 position = getEclipticPosition(elements);
+	double distance = glm::length(position);
+
+	// the ecliptic is the scene's xz plane
+	return glm::vec3(glm::dvec3(position.x, position.z, position.y) * (sceneDistance(distance) / distance));
+}
+
+float minorPlanetScale(double magnitude)
+{
+	// H of 3 (ceres) to 18 (a kilometer or so) spans the random belt's 0.3 to 1 scales
+	float brightness = std::min(std::max(float(18.0 - magnitude) / 15.0f, 0.0f), 1.0f);
+	return 0.1f * 0.5f * (0.3f + 0.7f * brightness);
+}
+
+// -1 to 1 from a hash of index and component
+static float hashfloat(uint64_t index, uint32_t component)
+{
+	uint64_t x = index * 0x9E3779B97F4A7C15ull + component * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return float(x >> 40) / float(1 << 23) - 1.0f;
+}
+
+glm::mat4 minorPlanetModel(const OrbitalElements& elements, uint64_t index)
+{
+	glm::mat4 trans = glm::translate(glm::mat4(1.0f), minorPlanetPosition(elements));
+	glm::mat4 rot = glm::mat4_cast(glm::normalize(glm::quat(1.0f, hashfloat(index, 0), hashfloat(index, 1), hashfloat(index, 2))));
+	glm::mat4 sca = glm::scale(glm::mat4(1.0f), glm::vec3(minorPlanetScale(elements.magnitude)));
+
+	return trans * rot * sca;
+}
+
+std::vector<glm::mat4> genMinorPlanetModels(const MinorPlanetCatalog& minorPlanets)
+{
+	std::vector<glm::mat4> instanceMatrix;
+	instanceMatrix.reserve(minorPlanets.getCount());
+
+	for (uint32_t i = 0; i < minorPlanets.getCount(); i++)
+	{
+		instanceMatrix.push_back(minorPlanetModel(minorPlanets.getElements(i), i));
+	}
+
+	return instanceMatrix;
+}
+
+std::vector<BeltChunk> buildBeltChunks(std::vector<glm::mat4>& instanceMatrix, unsigned int numberChunks)
+{
+	std::vector<BeltChunk> chunks;
+	if (instanceMatrix.empty() || numberChunks == 0)
+	{
+		return chunks;
+	}
+
+	// order the asteroids around the belt so neighbours end up in the same chunk, angles computed once rather than
+	// in every comparison since the real population is over a million instances
+	std::vector<std::pair<float, unsigned int>> angles(instanceMatrix.size());
+	for (unsigned int i = 0; i < instanceMatrix.size(); i++)
+	{
+		angles[i] = std::make_pair(std::atan2(instanceMatrix[i][3].z, instanceMatrix[i][3].x), i);
+	}
+	std::sort(angles.begin(), angles.end());
+
+	std::vector<glm::mat4> sorted(instanceMatrix.size());
+	for (unsigned int i = 0; i < angles.size(); i++)
+	{
+		sorted[i] = instanceMatrix[angles[i].second];
+	}
+	instanceMatrix.swap(sorted);
+
+	unsigned int total = (unsigned int)instanceMatrix.size();
+	numberChunks = std::min(numberChunks, total);
+
+	for (unsigned int i = 0; i < numberChunks; i++)
+	{
+		BeltChunk chunk;
+		chunk.firstInstance = total * i / numberChunks;
+		chunk.instanceCount = total * (i + 1) / numberChunks - chunk.firstInstance;
+
+		// center of the positions, then the furthest asteroid gives the radius
+		glm::vec3 sum(0.0f);
+		for (unsigned int j = 0; j < chunk.instanceCount; j++)
+		{
+			sum += glm::vec3(instanceMatrix[chunk.firstInstance + j][3]);
+		}
+		chunk.center = sum / float(chunk.instanceCount);
+
+		chunk.radius = 0.0f;
+		chunk.maxScale = 0.0f;
+		for (unsigned int j = 0; j < chunk.instanceCount; j++)
+		{
+			const glm::mat4& model = instanceMatrix[chunk.firstInstance + j];
+			chunk.radius = std::max(chunk.radius, glm::length(glm::vec3(model[3]) - chunk.center));
+			chunk.maxScale = std::max(chunk.maxScale, std::max(glm::length(glm::vec3(model[0])),
+				std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])))));
+		}
+
+		chunks.push_back(chunk);
+	}
+
+	return chunks;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+#include "MinorPlanets.h"
+
+// rng to generate number between -1 and 1
+float randfloat();
+
+// rng to generate number between -1 to -0.3 or 0.3 to 1
+float randscale();
+
+// generates model matrices for random asteroids
+std::vector<glm::mat4> genAsteroidModels(const unsigned int numberAsteroids, double radius, double radiusDeviation);
+
+// distance from the sun in AU to scene units, piecewise linear through the planets' orbits of the shipped catalog
+// (whose distances are compressed), extrapolated past neptune
+double sceneDistance(double au);
+
+// scene position of a minor planet at its epoch, distances compressed like the planets' are
+glm::vec3 minorPlanetPosition(const OrbitalElements& elements);
+
+// brighter objects (lower H) are drawn bigger
+float minorPlanetScale(double magnitude);
+
+// model matrix of a minor planet, the rotation is picked from its index so any thread building any subset of the
+// population gets the same matrices
+glm::mat4 minorPlanetModel(const OrbitalElements& elements, uint64_t index);
+
+// model matrices for the whole minor planet population
+std::vector<glm::mat4> genMinorPlanetModels(const MinorPlanetCatalog& minorPlanets);
+
+// belt chunks are sized for about this many instances, never fewer than 16 chunks
+#define BELT_CHUNK_INSTANCES 4096u
+
+// contiguous range of belt instances that is culled and drawn as a unit
+struct BeltChunk
+{
+	unsigned int firstInstance;
+	unsigned int instanceCount;
+
+	// bounding sphere of the asteroid positions in the chunk
+	glm::vec3 center;
+	float radius;
+
+	// largest scale of any asteroid in the chunk, times the mesh radius this pads the bounding sphere
+	float maxScale;
+};
+
+// sorts the instance matrices by angle around the sun and splits them into numberChunks arcs,
+// so each chunk is a contiguous range of the instance buffer
+std::vector<BeltChunk> buildBeltChunks(std::vector<glm::mat4>& instanceMatrix, unsigned int numberChunks);
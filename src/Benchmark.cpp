@@ -0,0 +1,333 @@
+#include "Benchmark.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "HeadlessContext.h"
+#include "Framebuffer.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "GpuTimer.h"
+#include "GLErrors.h"
+#include "ShaderCache.h"
+#include "GUIParams.h"
+#include "Profiler.h"
+#include "StartupTimeline.h"
+#include "AllocationTracker.h"
+
+// measurements of one scene
+struct BenchmarkResult
+{
+	std::string name;
+	unsigned int frames = 0;
+	unsigned int stalls = 0;
+	TimingStats cpu;
+	TimingStats gpu;
+	TimingStats passes[(int)RenderPass::Count];
+	double drawCallsAvg = 0.0;
+	unsigned int drawCallsMax = 0;
+	double trianglesAvg = 0.0;
+	unsigned long long trianglesMax = 0;
+	// heap allocations made by the simulation/recording/submission over every measured frame
+	unsigned long long allocations = 0;
+};
+
+// keyframe at position looking at target
+static CameraKey lookAtKey(float time, const glm::vec3& position, const glm::vec3& target)
+{
+	return { time, position, glm::normalize(target - position) };
+}
+
+// point on the asteroid belt's center line at the given angle (degrees), the belt is 530 +/- 40 around the sun
+static glm::vec3 beltPoint(float angle, float radius, float height)
+{
+	return glm::vec3(radius * std::sin(glm::radians(angle)), height, radius * std::cos(glm::radians(angle)));
+}
+
+// the fixed benchmark paths, changing them invalidates comparisons with older results
+static std::vector<BenchmarkScene> getBenchmarkScenes()
+{
+	std::vector<BenchmarkScene> scenes(3);
+
+	// whole system from high above, a half circle around the sun while slowly descending
+	BenchmarkScene& overview = scenes[0];
+	overview.name = "overview";
+	for (int i = 0; i <= 6; i++)
+	{
+		overview.path.addKey(lookAtKey(2.0f * i, beltPoint(30.0f * i, 1300.0f, 700.0f - 40.0f * i), glm::vec3(0.0f)));
+	}
+
+	// drops from outside the system into the belt plane, then flies along the belt through the asteroids
+	BenchmarkScene& belt = scenes[1];
+	belt.name = "belt";
+	belt.path.addKey(lookAtKey(0.0f, glm::vec3(0.0f, 250.0f, 1150.0f), beltPoint(0.0f, 530.0f, 0.0f)));
+	belt.path.addKey(lookAtKey(3.0f, glm::vec3(0.0f, 60.0f, 750.0f), beltPoint(0.0f, 530.0f, 0.0f)));
+	for (int i = 0; i <= 5; i++)
+	{
+		float angle = 12.0f * i;
+		belt.path.addKey(lookAtKey(6.0f + 2.0f * i, beltPoint(angle, 545.0f, 4.0f), beltPoint(angle + 10.0f, 530.0f, 0.0f)));
+	}
+
+	// close orbit around Jupiter, spiralling in through its moons' orbits
+	BenchmarkScene& jupiter = scenes[2];
+	jupiter.name = "jupiter";
+	jupiter.anchor = "jupiter";
+	jupiter.startDay = 2.5;
+	for (int i = 0; i <= 6; i++)
+	{
+		jupiter.path.addKey(lookAtKey(2.0f * i, beltPoint(40.0f * i, 110.0f - 8.0f * i, 25.0f - 2.0f * i), glm::vec3(0.0f)));
+	}
+
+	return scenes;
+}
+
+// moves the camera to its place on the path, relative to the anchor body if there is one
+static void placeCamera(const BenchmarkScene& benchmarkScene, const Scene& scene, BodyId anchor, float time, Camera& camera)
+{
+	benchmarkScene.path.sample(time, camera.m_position, camera.m_orientation);
+	if (anchor != INVALID_BODY)
+	{
+		camera.m_position += scene.m_bodies.getTransform(anchor).world;
+	}
+}
+
+static void renderFrame(Scene& scene, Camera& camera, Framebuffer& framebuffer, GpuTimer& gpuTimer)
+{
+	framebuffer.bind();
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	scene.render(camera, &gpuTimer);
+	scene.framePresented();
+}
+
+static bool runScene(const BenchmarkScene& benchmarkScene, const AppOptions& options, Framebuffer& framebuffer, BenchmarkResult& result)
+{
+	PROFILE_ZONE("BenchmarkScene");
+
+	// same belt every run, and the simulation starts from the same day
+	std::srand(BENCHMARK_SEED);
+	Scene scene{ getSceneDirectories(options), options.populationBudget };
+	// measured frames are of the finished scene, not of its placeholders
+	scene.finishLoading();
+	scene.update(benchmarkScene.startDay);
+
+	BodyId anchor = INVALID_BODY;
+	if (!benchmarkScene.anchor.empty() && (anchor = scene.m_bodies.findBody(findName(benchmarkScene.anchor))) == INVALID_BODY)
+	{
+		std::cout << "Benchmark scene " << benchmarkScene.name << ": no body named " << benchmarkScene.anchor << std::endl;
+		return false;
+	}
+
+	// the path runs to its end unless a frame count was given explicitly
+	int frames = options.frames;
+	if (!options.framesGiven)
+	{
+		frames = int(std::ceil(benchmarkScene.path.getDuration() * options.fps)) + 1;
+	}
+
+	Camera camera(options.width, options.height, 45.f, 0.1f, 10000.f, CAMERA_START_POSITION, CAMERA_START_ORIENTATION);
+	GpuTimer gpuTimer(frames);
+
+	// warm up at the first keyframe without advancing the simulation, then throw those timings away
+	placeCamera(benchmarkScene, scene, anchor, 0.0f, camera);
+	for (int frame = 0; frame < BENCHMARK_WARMUP_FRAMES; frame++)
+	{
+		gpuTimer.beginFrame();
+		renderFrame(scene, camera, framebuffer, gpuTimer);
+		gpuTimer.endFrame(0.0f);
+	}
+	glFinish();
+	gpuTimer.finish();
+	gpuTimer.clear();
+
+	const double step = 1.0 / options.fps;
+	unsigned long long drawCalls = 0;
+	unsigned long long triangles = 0;
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		PROFILE_ZONE("Frame");
+		uint64_t frameStart = Profiler::now();
+
+		gpuTimer.beginFrame();
+
+		uint64_t allocationsBefore = AllocationTracker::getCount();
+
+		// the first measured frame is at the start day exactly
+		if (frame > 0)
+		{
+			scene.update(step * BENCHMARK_DAYS_PER_SECOND);
+		}
+		placeCamera(benchmarkScene, scene, anchor, float(frame * step), camera);
+
+		renderFrame(scene, camera, framebuffer, gpuTimer);
+
+		result.allocations += AllocationTracker::getCount() - allocationsBefore;
+
+		gpuTimer.endFrame(float((Profiler::now() - frameStart) / 1.0e6));
+
+		const RenderStats& stats = scene.getRenderStats();
+		drawCalls += stats.drawCalls;
+		triangles += stats.triangles;
+		result.drawCallsMax = std::max(result.drawCallsMax, stats.drawCalls);
+		result.trianglesMax = std::max(result.trianglesMax, stats.triangles);
+	}
+
+	glFinish();
+	gpuTimer.finish();
+
+	result.name = benchmarkScene.name;
+	result.frames = gpuTimer.getFrameCount();
+	result.stalls = gpuTimer.getStalls();
+	result.cpu = gpuTimer.getCpuStats();
+	result.gpu = gpuTimer.getGpuTotalStats();
+	for (int pass = 0; pass < (int)RenderPass::Count; pass++)
+	{
+		result.passes[pass] = gpuTimer.getPassStats(RenderPass(pass));
+	}
+	result.drawCallsAvg = double(drawCalls) / frames;
+	result.trianglesAvg = double(triangles) / frames;
+
+	return true;
+}
+
+// quoted, with the characters JSON can't take raw escaped
+static void writeJSONString(std::ostream& out, const char* text)
+{
+	out << '"';
+	for (const char* c = text; c != nullptr && *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			out << '\\' << *c;
+		}
+		else if ((unsigned char)*c >= 0x20)
+		{
+			out << *c;
+		}
+	}
+	out << '"';
+}
+
+static bool writeResults(const std::string& path, const AppOptions& options, const HeadlessContext& context,
+	const std::vector<BenchmarkResult>& results)
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cout << "Failed to write benchmark results: " << path << std::endl;
+		return false;
+	}
+
+#ifdef NDEBUG
+	const char* build = "release";
+#else
+	const char* build = "debug";
+#endif
+
+	out << "{\n  \"build\": \"" << build << "\",\n  \"context\": \"" << context.getBackendName() << "\",\n  \"gl_vendor\": ";
+	writeJSONString(out, (const char*)glGetString(GL_VENDOR));
+	out << ",\n  \"gl_renderer\": ";
+	writeJSONString(out, (const char*)glGetString(GL_RENDERER));
+	out << ",\n  \"gl_version\": ";
+	writeJSONString(out, (const char*)glGetString(GL_VERSION));
+	out << ",\n  \"width\": " << options.width << ",\n  \"height\": " << options.height << ",\n  \"fps\": " << options.fps
+		<< ",\n  \"seed\": " << BENCHMARK_SEED << ",\n  \"warmup_frames\": " << BENCHMARK_WARMUP_FRAMES
+		<< ",\n  \"days_per_second\": " << BENCHMARK_DAYS_PER_SECOND << ",\n  \"scenes\": [";
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+		out << (i == 0 ? "\n    {" : ",\n    {") << "\n      \"name\": \"" << result.name << "\",\n      \"frames\": " << result.frames
+			<< ",\n      \"readback_stalls\": " << result.stalls << ",\n      \"cpu_ms\": ";
+		GpuTimer::writeStatsJSON(out, result.cpu);
+		out << ",\n      \"gpu_ms\": ";
+		GpuTimer::writeStatsJSON(out, result.gpu);
+		out << ",\n      \"passes_ms\": {";
+		for (int pass = 0; pass < (int)RenderPass::Count; pass++)
+		{
+			out << (pass == 0 ? "\n        \"" : ",\n        \"") << GpuTimer::getPassName(RenderPass(pass)) << "\": ";
+			GpuTimer::writeStatsJSON(out, result.passes[pass]);
+		}
+		out << "\n      },\n      \"draw_calls\": {\"avg\":" << result.drawCallsAvg << ",\"max\":" << result.drawCallsMax << "}"
+			<< ",\n      \"triangles\": {\"avg\":" << result.trianglesAvg << ",\"max\":" << result.trianglesMax << "}"
+			<< ",\n      \"heap_allocations\": " << result.allocations << "\n    }";
+	}
+	out << "\n  ]\n}\n";
+
+	std::cout << "Wrote benchmark results: " << path << std::endl;
+	return true;
+}
+
+int runBenchmark(const AppOptions& options)
+{
+	std::vector<BenchmarkScene> scenes = getBenchmarkScenes();
+	if (!options.benchmarkScene.empty())
+	{
+		auto match = std::find_if(scenes.begin(), scenes.end(),
+			[&](const BenchmarkScene& scene) { return scene.name == options.benchmarkScene; });
+		if (match == scenes.end())
+		{
+			std::cout << "Unknown benchmark scene: " << options.benchmarkScene << std::endl;
+			return -1;
+		}
+		scenes = { *match };
+	}
+
+	HeadlessContext context;
+	{
+		STARTUP_PHASE("HeadlessContext::create");
+		if (!context.create())
+		{
+			return -1;
+		}
+	}
+
+	{
+		STARTUP_PHASE("GL extensions");
+		initGLDebugOutput(context.getLoader(), options.glDebugSynchronous, options.glGetErrorChecks);
+		initShaderCompile(context.getLoader());
+	}
+
+	// everything moves and the orbit lines are drawn, whatever the interactive defaults are
+	enableOrbitalMotion = true;
+	enableRotationalMotion = true;
+	enableOrbitalPath = true;
+
+	Framebuffer framebuffer(options.width, options.height);
+
+	std::vector<BenchmarkResult> results;
+	for (const auto& benchmarkScene : scenes)
+	{
+		BenchmarkResult result;
+		if (!runScene(benchmarkScene, options, framebuffer, result))
+		{
+			return -1;
+		}
+
+		std::cout << result.name << ": " << result.frames << " frames"
+			<< "  cpu ms p50/p95/p99 " << result.cpu.p50 << " / " << result.cpu.p95 << " / " << result.cpu.p99
+			<< "  gpu ms p50/p95/p99 " << result.gpu.p50 << " / " << result.gpu.p95 << " / " << result.gpu.p99
+			<< "  draws " << result.drawCallsAvg << "  triangles " << result.trianglesAvg << std::endl;
+
+		results.push_back(result);
+	}
+
+	if (!writeResults(options.timingsPath.empty() ? "benchmark.json" : options.timingsPath, options, context, results))
+	{
+		return -1;
+	}
+	if (options.profile)
+	{
+		Profiler::writeChromeTrace(options.tracePath);
+	}
+
+	return 0;
+}
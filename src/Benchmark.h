@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+#include "CommandLine.h"
+#include "Timeline.h"
+
+// seed for the asteroid belt, every scene is built from the same one
+#define BENCHMARK_SEED 1234u
+// frames rendered at the first keyframe before measuring, lets drivers finish lazy allocations and shader variants
+#define BENCHMARK_WARMUP_FRAMES 30
+// simulated days per second of path time, independent of the GUI setting so results stay comparable across builds
+#define BENCHMARK_DAYS_PER_SECOND 1.0
+
+// a camera path through the scene, with the simulation started at a fixed day
+struct BenchmarkScene
+{
+	std::string name;
+	// body the path is relative to (keys are offsets from its position), empty for world space
+	std::string anchor;
+	double startDay = 0.0;
+	Timeline path;
+};
+
+/*
+* Headless flythrough benchmark
+* Every scene is rebuilt from BENCHMARK_SEED and advanced to its start day, warmed up, then rendered along its path
+* at a fixed simulation step of 1/fps. Orbital motion, rotation and orbit lines are all on.
+* Writes CPU/GPU frame time percentiles, per pass GPU times, draw calls and triangles per scene as JSON
+* (--timings, default benchmark.json), returns the process exit code
+*/
+int runBenchmark(const AppOptions& options);
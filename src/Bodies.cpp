@@ -0,0 +1,186 @@
+#include "Bodies.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "GLErrors.h"
+
+BodyId BodyStore::createBody(BodyId parent, NameId name)
+{
+	BodyId body = (BodyId)m_parents.size();
+	ASSERT(parent == INVALID_BODY || parent < body);
+
+	BodyType type = BodyType::Star;
+	if (parent != INVALID_BODY)
+	{
+		type = m_parents[parent] == INVALID_BODY ? BodyType::Planet : BodyType::Satellite;
+	}
+
+	m_parents.push_back(parent);
+	m_types.push_back(type);
+	m_names.push_back(name);
+	m_transforms.push_back(Transform());
+	return body;
+}
+
+void BodyStore::reserve(size_t bodies)
+{
+	m_parents.reserve(bodies);
+	m_types.reserve(bodies);
+	m_names.reserve(bodies);
+	m_transforms.reserve(bodies);
+}
+
+void BodyStore::addOrbit(BodyId body, const Orbit& orbit)
+{
+	m_orbits.add(body, Orbit(orbit));
+
+	// starting position
+	size_t slot = m_orbits.size() - 1;
+	updateOrbits(0.0, slot, slot + 1);
+}
+
+void BodyStore::addSpin(BodyId body, const Spin& spin)
+{
+	m_spins.add(body, Spin(spin));
+}
+
+const Mesh* BodyStore::addMesh(std::unique_ptr<Mesh> mesh)
+{
+	m_meshes.push_back(std::move(mesh));
+	return m_meshes.back().get();
+}
+
+void BodyStore::addRenderProxy(BodyId body, const Mesh* mesh, float scale)
+{
+	RenderProxy proxy;
+	proxy.mesh = mesh;
+	proxy.scale = scale;
+	proxy.boundingRadius = mesh->getBoundingRadius() * scale;
+	m_renderProxies.add(body, std::move(proxy));
+}
+
+void BodyStore::replaceMesh(const Mesh* mesh, const Mesh* replacement)
+{
+	for (size_t slot = 0; slot < m_renderProxies.size(); slot++)
+	{
+		RenderProxy& proxy = m_renderProxies[slot];
+		if (proxy.mesh == mesh)
+		{
+			proxy.mesh = replacement;
+			proxy.boundingRadius = replacement->getBoundingRadius() * proxy.scale;
+		}
+	}
+
+	// streamed models replace placeholder spheres, which would otherwise keep their geometry and texture for good
+	auto it = std::find_if(m_meshes.begin(), m_meshes.end(), [mesh](const std::unique_ptr<Mesh>& owned) { return owned.get() == mesh; });
+	if (it != m_meshes.end())
+	{
+		m_meshes.erase(it);
+	}
+}
+
+void BodyStore::addOrbitVisual(BodyId body)
+{
+	const Orbit* orbit = m_orbits.find(body);
+	ASSERT(orbit != nullptr);
+
+	OrbitVisual visual;
+	visual.ellipse = std::make_unique<OrbitalEllipse>(float(orbit->a), float(orbit->b));
+	visual.radius = float(std::max(orbit->a, orbit->b));
+	m_orbitVisuals.add(body, std::move(visual));
+}
+
+BodyId BodyStore::findBody(NameId name) const
+{
+	if (name == INVALID_NAME_ID)
+	{
+		return INVALID_BODY;
+	}
+
+	auto it = std::find(m_names.begin(), m_names.end(), name);
+	return it != m_names.end() ? BodyId(it - m_names.begin()) : INVALID_BODY;
+}
+
+void BodyStore::updateOrbits(double days, size_t begin, size_t end)
+{
+	for (size_t slot = begin; slot < end; slot++)
+	{
+		Orbit& orbit = m_orbits[slot];
+		orbit.angle += days / orbit.period * 360;
+
+		float x = float(orbit.a * std::sin(PI * 2 * orbit.angle / 360));
+		float y = float(orbit.b * std::cos(PI * 2 * orbit.angle / 360));
+		m_transforms[m_orbits.getOwner(slot)].local = glm::vec3(x, 0.0f, y);
+	}
+}
+
+void BodyStore::updateSpins(double days)
+{
+	for (size_t slot = 0; slot < m_spins.size(); slot++)
+	{
+		m_spins[slot].angle += days * m_spins[slot].rotationSpeed;
+	}
+}
+
+void BodyStore::updateTransforms()
+{
+	// parents come before their children, so their world position is already up to date
+	for (size_t body = 0; body < m_transforms.size(); body++)
+	{
+		Transform& transform = m_transforms[body];
+		BodyId parent = m_parents[body];
+		transform.world = parent == INVALID_BODY ? transform.local : m_transforms[parent].world + transform.local;
+	}
+}
+
+glm::mat4 BodyStore::getModelMatrix(BodyId body) const
+{
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), m_transforms[body].world);
+
+	// axial tilt is constant, then the current rotation angle
+	if (const Spin* spin = m_spins.find(body))
+	{
+		model = glm::rotate(model, glm::radians(float(spin->axialTilt)), glm::vec3(0.f, 0.f, 1.f));
+		model = glm::rotate(model, glm::radians(float(spin->angle)), glm::vec3(0.f, 1.f, 0.f));
+	}
+
+	if (const RenderProxy* proxy = m_renderProxies.find(body))
+	{
+		model = glm::scale(model, glm::vec3(proxy->scale));
+	}
+
+	return model;
+}
+
+void BodyStore::recordBody(size_t slot, CommandList& list, const ProgramSlot& program, const Camera& camera, const Frustum& frustum) const
+{
+	const RenderProxy& proxy = m_renderProxies[slot];
+	BodyId body = m_renderProxies.getOwner(slot);
+	const glm::vec3& position = m_transforms[body].world;
+
+	if (!frustum.intersectsSphere(position, proxy.boundingRadius))
+	{
+		return;
+	}
+
+	glm::mat4 model = getModelMatrix(body);
+	proxy.mesh->record(list, program, RenderLayer::Opaque, RenderPass::Bodies, &model, camera.getNormalizedDepth(position));
+}
+
+void BodyStore::recordOrbit(size_t slot, CommandList& list, const ProgramSlot& program, const Frustum& frustum) const
+{
+	const OrbitVisual& visual = m_orbitVisuals[slot];
+	BodyId parent = m_parents[m_orbitVisuals.getOwner(slot)];
+
+	// the ellipse is centered on what the body orbits
+	glm::vec3 center = parent == INVALID_BODY ? glm::vec3(0.0f) : m_transforms[parent].world;
+	if (!frustum.intersectsSphere(center, visual.radius))
+	{
+		return;
+	}
+
+	visual.ellipse->record(list, program, glm::translate(glm::mat4(1.0f), center));
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Mesh.h"
+#include "OrbitalEllipse.h"
+#include "NameTable.h"
+#include "CommandList.h"
+#include "Camera.h"
+#include "Frustum.h"
+
+// index of a body in its BodyStore
+typedef uint32_t BodyId;
+
+#define INVALID_BODY 0xFFFFFFFFu
+
+// what a body orbits decides how it's drawn, tagged once when it's created so frames never compare names
+enum class BodyType
+{
+	Star, // orbits nothing, emits the light
+	Planet, // orbits a star
+	Satellite // orbits a planet
+};
+
+// orbital elements of an ellipse around the parent and where along it the body currently is, angle in degrees
+struct Orbit
+{
+	double a = 0.0;
+	double b = 0.0;
+	// days per revolution
+	double period = 1.0;
+	double angle = 0.0;
+};
+
+// rotation about the body's own axis, degrees and degrees per day
+struct Spin
+{
+	double axialTilt = 0.0;
+	double rotationSpeed = 0.0;
+	double angle = 0.0;
+};
+
+// position relative to the parent, and in the world (parent's world + local)
+struct Transform
+{
+	glm::vec3 local = glm::vec3(0.0f);
+	glm::vec3 world = glm::vec3(0.0f);
+};
+
+// what it takes to draw a body, the mesh is owned by the store and may be shared with other bodies
+struct RenderProxy
+{
+	const Mesh* mesh = nullptr;
+	float scale = 1.0f;
+	// of the scaled mesh, for culling
+	float boundingRadius = 0.0f;
+};
+
+// line loop of the orbit, drawn around the parent
+struct OrbitVisual
+{
+	std::unique_ptr<OrbitalEllipse> ellipse;
+	// max(a, b), for culling
+	float radius = 0.0f;
+};
+
+/*
+* Optional component, packed densely so systems iterate only the bodies that have it
+* m_owners maps a dense slot back to its body, m_slots maps a body to its dense slot (or INVALID_BODY). Components
+* are never removed, bodies live as long as the store.
+*/
+template <typename T>
+class ComponentArray
+{
+private:
+	std::vector<T> m_data;
+	std::vector<BodyId> m_owners;
+	std::vector<uint32_t> m_slots;
+
+public:
+	T& add(BodyId body, T&& component)
+	{
+		if (body >= m_slots.size())
+		{
+			m_slots.resize(body + 1, INVALID_BODY);
+		}
+		m_slots[body] = (uint32_t)m_data.size();
+		m_owners.push_back(body);
+		m_data.push_back(std::move(component));
+		return m_data.back();
+	}
+
+	void reserve(size_t count)
+	{
+		m_data.reserve(count);
+		m_owners.reserve(count);
+	}
+
+	// nullptr if the body doesn't have the component
+	const T* find(BodyId body) const
+	{
+		return body < m_slots.size() && m_slots[body] != INVALID_BODY ? &m_data[m_slots[body]] : nullptr;
+	}
+
+	size_t size() const { return m_data.size(); }
+
+	T& operator[](size_t slot) { return m_data[slot]; }
+	const T& operator[](size_t slot) const { return m_data[slot]; }
+	BodyId getOwner(size_t slot) const { return m_owners[slot]; }
+};
+
+/*
+* Every body of the scene (sun, planets, satellites and anything lighter) as dense component arrays
+* Each body has a parent, type, name and transform, the rest is optional: a body without a mesh, orbit line, spin
+* or name pays nothing for them, so millions of point-mass bodies are just an orbit and a transform each.
+* Parents must be created before their children, which lets updateTransforms() run in a single forward pass.
+*/
+class BodyStore
+{
+private:
+	// one entry per body
+	std::vector<BodyId> m_parents;
+	std::vector<BodyType> m_types;
+	std::vector<NameId> m_names;
+	std::vector<Transform> m_transforms;
+
+	ComponentArray<Orbit> m_orbits;
+	ComponentArray<Spin> m_spins;
+	ComponentArray<RenderProxy> m_renderProxies;
+	ComponentArray<OrbitVisual> m_orbitVisuals;
+
+	std::vector<std::unique_ptr<Mesh>> m_meshes;
+
+public:
+	// parent is INVALID_BODY for the root (star), name is optional
+	BodyId createBody(BodyId parent, NameId name = INVALID_NAME_ID);
+	void reserve(size_t bodies);
+
+	// places the body on its orbit right away, call updateTransforms() once done adding bodies
+	void addOrbit(BodyId body, const Orbit& orbit);
+	void addSpin(BodyId body, const Spin& spin);
+	// the store keeps the mesh alive, any number of bodies can be drawn with it
+	const Mesh* addMesh(std::unique_ptr<Mesh> mesh);
+	// mesh from addMesh(), scale is applied to it when drawn
+	void addRenderProxy(BodyId body, const Mesh* mesh, float scale);
+	// every body drawn with one mesh is drawn with the other from now on, both from addMesh(); the replaced mesh is
+	// released, so nothing else may still point at it
+	void replaceMesh(const Mesh* mesh, const Mesh* replacement);
+	// line loop along the body's orbit, needs GL and an orbit
+	void addOrbitVisual(BodyId body);
+
+	size_t getBodyCount() const { return m_parents.size(); }
+
+	// first body with the name, INVALID_BODY if none
+	BodyId findBody(NameId name) const;
+
+	BodyId getParent(BodyId body) const { return m_parents[body]; }
+	BodyType getType(BodyId body) const { return m_types[body]; }
+	NameId getNameId(BodyId body) const { return m_names[body]; }
+	const Transform& getTransform(BodyId body) const { return m_transforms[body]; }
+
+	const ComponentArray<Orbit>& getOrbits() const { return m_orbits; }
+	const ComponentArray<RenderProxy>& getRenderProxies() const { return m_renderProxies; }
+	const ComponentArray<OrbitVisual>& getOrbitVisuals() const { return m_orbitVisuals; }
+
+	// systems, the ranges are dense slots of the component so jobs can split the work
+	// advances every orbit by the given number of days, writes the local positions
+	void updateOrbits(double days) { updateOrbits(days, 0, m_orbits.size()); }
+	void updateOrbits(double days, size_t begin, size_t end);
+	void updateSpins(double days);
+	// world positions from the local ones, after the orbits moved
+	void updateTransforms();
+
+	// translation * axial tilt * spin * scale
+	glm::mat4 getModelMatrix(BodyId body) const;
+
+	// records the body of a render proxy slot and the orbit of an orbit visual slot, skipped if outside the frustum
+	// doesn't touch GL, safe to call from worker threads
+	void recordBody(size_t slot, CommandList& list, const ProgramSlot& program, const Camera& camera, const Frustum& frustum) const;
+	void recordOrbit(size_t slot, CommandList& list, const ProgramSlot& program, const Frustum& frustum) const;
+};
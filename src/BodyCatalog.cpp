@@ -0,0 +1,328 @@
+#include "BodyCatalog.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "AssetArchive.h"
+#include "LoadModel.h"
+#include "NameTable.h"
+#include "Profiler.h"
+#include "StartupTimeline.h"
+
+#define EARTH_RADIUS 6371 // in kilometers
+
+bool BodyCatalog::load(const std::string& path)
+{
+	PROFILE_ZONE("BodyCatalog::load");
+	STARTUP_ASSET("BodyCatalog::load", path);
+
+	m_parsed.clear();
+	m_header = nullptr;
+	m_bodies = nullptr;
+	m_strings = nullptr;
+
+	// packAssets() stores the compiled form, viewed in place
+	const uint8_t* archived;
+	size_t archivedSize;
+	if (findArchivedFile(path, archived, archivedSize))
+	{
+		return view(archived, archivedSize, path);
+	}
+
+	if (!m_file.open(path))
+	{
+		return false;
+	}
+
+	uint32_t magic = 0;
+	if (m_file.getSize() >= sizeof(magic))
+	{
+		std::memcpy(&magic, m_file.getData(), sizeof(magic));
+	}
+
+	if (magic == CATALOG_MAGIC)
+	{
+		if (!view(m_file.getData(), m_file.getSize(), path))
+		{
+			m_file.close();
+			return false;
+		}
+		return true;
+	}
+
+	m_file.close();
+	return parseText(path);
+}
+
+bool BodyCatalog::parseText(const std::string& path)
+{
+	std::ifstream in(path);
+	if (!in)
+	{
+		std::cout << "Failed to open catalog: " << path << std::endl;
+		return false;
+	}
+
+	std::vector<CatalogBody> bodies;
+	std::string strings;
+	// bodies by name for resolving parents, and string offsets so a model shared by many bodies is stored once
+	std::unordered_map<std::string, uint32_t> bodyIndices;
+	std::unordered_map<std::string, uint32_t> stringOffsets;
+
+	auto addString = [&](const std::string& text)
+	{
+		auto it = stringOffsets.find(text);
+		if (it != stringOffsets.end())
+		{
+			return it->second;
+		}
+		uint32_t offset = (uint32_t)strings.size();
+		strings.append(text).push_back('\0');
+		stringOffsets.emplace(text, offset);
+		return offset;
+	};
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(in, line))
+	{
+		lineNumber++;
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream fields(line);
+		std::string name, parent, model;
+		CatalogBody body = {};
+		if (!(fields >> name >> parent >> body.radius >> body.axialTilt >> body.rotationSpeed
+			>> body.a >> body.b >> body.period >> body.startAngle >> model))
+		{
+			std::cout << path << ":" << lineNumber
+				<< ": expected 'name parent radius axialTilt rotationSpeed a b period startAngle model'" << std::endl;
+			return false;
+		}
+
+		if (bodyIndices.count(name) != 0)
+		{
+			std::cout << path << ":" << lineNumber << ": " << name << " is listed twice" << std::endl;
+			return false;
+		}
+
+		body.parent = INVALID_BODY;
+		if (parent != "-")
+		{
+			auto it = bodyIndices.find(parent);
+			if (it == bodyIndices.end())
+			{
+				std::cout << path << ":" << lineNumber << ": parent " << parent << " must be listed before " << name << std::endl;
+				return false;
+			}
+			body.parent = it->second;
+		}
+
+		if (body.parent != INVALID_BODY && body.period == 0.0)
+		{
+			std::cout << path << ":" << lineNumber << ": " << name << " orbits something, its period can't be 0" << std::endl;
+			return false;
+		}
+
+		body.name = addString(name);
+		body.model = model != "-" ? addString(model) : CATALOG_NO_STRING;
+		bodyIndices.emplace(name, (uint32_t)bodies.size());
+		bodies.push_back(body);
+	}
+
+	if (bodies.empty())
+	{
+		std::cout << "Catalog has no bodies: " << path << std::endl;
+		return false;
+	}
+
+	CatalogHeader header = { CATALOG_MAGIC, CATALOG_VERSION, (uint32_t)bodies.size(), (uint32_t)strings.size() };
+	size_t bodiesSize = bodies.size() * sizeof(CatalogBody);
+	size_t size = sizeof(header) + bodiesSize + strings.size();
+
+	m_parsed.resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+	uint8_t* data = (uint8_t*)m_parsed.data();
+	std::memcpy(data, &header, sizeof(header));
+	std::memcpy(data + sizeof(header), bodies.data(), bodiesSize);
+	std::memcpy(data + sizeof(header) + bodiesSize, strings.data(), strings.size());
+
+	return view(data, size, path);
+}
+
+bool BodyCatalog::view(const uint8_t* data, size_t size, const std::string& path)
+{
+	if (size < sizeof(CatalogHeader))
+	{
+		std::cout << "Catalog is truncated: " << path << std::endl;
+		return false;
+	}
+
+	const CatalogHeader* header = (const CatalogHeader*)data;
+	if (header->magic != CATALOG_MAGIC || header->version != CATALOG_VERSION)
+	{
+		std::cout << "Catalog has an unsupported version: " << path << std::endl;
+		return false;
+	}
+
+	size_t bodiesSize = (size_t)header->bodyCount * sizeof(CatalogBody);
+	if (size != sizeof(CatalogHeader) + bodiesSize + header->stringsSize)
+	{
+		std::cout << "Catalog size doesn't match its header: " << path << std::endl;
+		return false;
+	}
+
+	const CatalogBody* bodies = (const CatalogBody*)(data + sizeof(CatalogHeader));
+	const char* strings = (const char*)(data + sizeof(CatalogHeader) + bodiesSize);
+	if (header->stringsSize == 0 || strings[header->stringsSize - 1] != '\0')
+	{
+		std::cout << "Catalog strings aren't terminated: " << path << std::endl;
+		return false;
+	}
+
+	// everything addCatalogBodies relies on, so a corrupt file can't index out of bounds or orbit with a 0 period later,
+	// the same checks parseText() makes
+	for (uint32_t i = 0; i < header->bodyCount; i++)
+	{
+		const CatalogBody& body = bodies[i];
+		if ((body.parent != INVALID_BODY && (body.parent >= i || body.period == 0.0)) || body.name >= header->stringsSize
+			|| (body.model != CATALOG_NO_STRING && body.model >= header->stringsSize))
+		{
+			std::cout << "Catalog body " << i << " is invalid: " << path << std::endl;
+			return false;
+		}
+	}
+
+	m_header = header;
+	m_bodies = bodies;
+	m_strings = strings;
+	return true;
+}
+
+size_t BodyCatalog::getSize() const
+{
+	if (m_header == nullptr)
+	{
+		return 0;
+	}
+	return sizeof(CatalogHeader) + (size_t)m_header->bodyCount * sizeof(CatalogBody) + m_header->stringsSize;
+}
+
+bool BodyCatalog::write(const std::string& path) const
+{
+	std::ofstream out(path, std::ios::binary);
+	if (!out || m_header == nullptr)
+	{
+		std::cout << "Failed to write catalog: " << path << std::endl;
+		return false;
+	}
+
+	// header, bodies and strings are contiguous whether the catalog was mapped or parsed
+	out.write((const char*)m_header, getSize());
+	return bool(out);
+}
+
+void addCatalogBodies(BodyStore& bodies, ResourceRegistry& resources, const BodyCatalog& catalog, const std::string& modelsDirectory,
+	const AssetLoader* assets, std::vector<PlaceholderModel>* placeholders)
+{
+	PROFILE_ZONE("addCatalogBodies");
+	STARTUP_PHASE("addCatalogBodies");
+
+	BodyId first = (BodyId)bodies.getBodyCount();
+	uint32_t count = catalog.getBodyCount();
+	bodies.reserve(first + count);
+
+	// by string offset, bodies sharing a model share its mesh (nullptr if it failed to load)
+	std::unordered_map<uint32_t, const Mesh*> models;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const CatalogBody& entry = catalog.getBody(i);
+		BodyId parent = entry.parent != INVALID_BODY ? first + entry.parent : INVALID_BODY;
+		BodyId body = bodies.createBody(parent, internName(catalog.getString(entry.name)));
+
+		// the root doesn't orbit anything
+		if (parent != INVALID_BODY)
+		{
+			Orbit orbit;
+			orbit.a = entry.a;
+			orbit.b = entry.b;
+			orbit.period = entry.period;
+			orbit.angle = entry.startAngle;
+			bodies.addOrbit(body, orbit);
+		}
+
+		if (entry.axialTilt != 0.0 || entry.rotationSpeed != 0.0)
+		{
+			Spin spin;
+			spin.axialTilt = entry.axialTilt;
+			spin.rotationSpeed = entry.rotationSpeed;
+			bodies.addSpin(body, spin);
+		}
+
+		if (entry.model == CATALOG_NO_STRING)
+		{
+			continue;
+		}
+
+		auto it = models.find(entry.model);
+		if (it == models.end() && placeholders != nullptr)
+		{
+			const Mesh* placeholder = bodies.addMesh(makePlaceholderSphere(resources));
+			placeholders->push_back({ modelsDirectory + catalog.getString(entry.model), placeholder });
+			it = models.emplace(entry.model, placeholder).first;
+		}
+		else if (it == models.end())
+		{
+			std::vector<std::unique_ptr<Mesh>> meshes;
+			loadModel(modelsDirectory + catalog.getString(entry.model), resources, meshes, assets);
+			it = models.emplace(entry.model, meshes.empty() ? nullptr : bodies.addMesh(std::move(meshes[0]))).first;
+		}
+
+		if (it->second != nullptr)
+		{
+			// size relative to earth, whose mesh is drawn unscaled
+			bodies.addRenderProxy(body, it->second, float(entry.radius / EARTH_RADIUS));
+			if (parent != INVALID_BODY)
+			{
+				bodies.addOrbitVisual(body);
+			}
+		}
+	}
+
+	bodies.updateTransforms();
+}
+
+std::vector<std::string> getCatalogModels(const BodyCatalog& catalog, const std::string& modelsDirectory)
+{
+	// by string offset, the same way addCatalogBodies() tells models apart
+	std::unordered_set<uint32_t> seen;
+	std::vector<std::string> models;
+	for (uint32_t i = 0; i < catalog.getBodyCount(); i++)
+	{
+		uint32_t model = catalog.getBody(i).model;
+		if (model != CATALOG_NO_STRING && seen.insert(model).second)
+		{
+			models.push_back(modelsDirectory + catalog.getString(model));
+		}
+	}
+	return models;
+}
+
+bool compileCatalog(const std::string& textPath, const std::string& binaryPath)
+{
+	BodyCatalog catalog;
+	if (!catalog.load(textPath) || !catalog.write(binaryPath))
+	{
+		return false;
+	}
+
+	std::cout << "Compiled " << catalog.getBodyCount() << " bodies (" << catalog.getSize() << " bytes): " << binaryPath << std::endl;
+	return true;
+}
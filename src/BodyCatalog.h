@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Bodies.h"
+
+class AssetLoader;
+
+// "BCAT" read as a little endian uint32_t, first thing in a compiled catalog
+#define CATALOG_MAGIC 0x54414342u
+#define CATALOG_VERSION 1u
+// string offset of an absent model
+#define CATALOG_NO_STRING 0xFFFFFFFFu
+
+// start of a compiled catalog, followed by bodyCount CatalogBody, then stringsSize bytes of '\0' terminated strings
+struct CatalogHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t bodyCount;
+	uint32_t stringsSize;
+};
+
+// one body as stored in a compiled catalog, strings are offsets into the string block
+struct CatalogBody
+{
+	// index of an earlier body, INVALID_BODY for the root
+	uint32_t parent;
+	uint32_t name;
+	// OBJ file relative to the models directory, CATALOG_NO_STRING for a body that isn't drawn
+	uint32_t model;
+	uint32_t padding;
+	// kilometers, the mesh is scaled by radius / earth's radius
+	double radius;
+	// degrees and degrees per day
+	double axialTilt;
+	double rotationSpeed;
+	// ellipse around the parent, days per revolution and starting angle in degrees
+	double a;
+	double b;
+	double period;
+	double startAngle;
+};
+
+static_assert(sizeof(CatalogHeader) == 16, "compiled catalog layout changed");
+static_assert(sizeof(CatalogBody) == 72, "compiled catalog layout changed");
+
+/*
+* Bodies, their parents, physical/orbital parameters and meshes, read from a file instead of compiled in
+* The text form is for editing, one body per line:
+*   name parent radius axialTilt rotationSpeed a b period startAngle model
+* with '-' for no parent (the root) or no model, '#' starts a comment line, and parents listed before their children.
+* The compiled form (compileCatalog, or the text form loaded and written back) is the in-memory layout itself, so
+* loading it is a mapping plus validation, bodies are read in place without being copied or parsed.
+*/
+class BodyCatalog
+{
+private:
+	// compiled catalogs are viewed in place
+	MappedFile m_file;
+	// text catalogs are parsed into the same layout, uint64_t keeps the bodies' doubles aligned
+	std::vector<uint64_t> m_parsed;
+
+	const CatalogHeader* m_header = nullptr;
+	const CatalogBody* m_bodies = nullptr;
+	const char* m_strings = nullptr;
+
+	bool parseText(const std::string& path);
+	bool view(const uint8_t* data, size_t size, const std::string& path);
+
+public:
+	// compiled if the file starts with CATALOG_MAGIC or comes from the mounted archive, text otherwise, prints why and
+	// returns false if it's invalid
+	bool load(const std::string& path);
+
+	// compiled form of the loaded catalog
+	bool write(const std::string& path) const;
+
+	uint32_t getBodyCount() const { return m_header != nullptr ? m_header->bodyCount : 0; }
+	const CatalogBody& getBody(uint32_t index) const { return m_bodies[index]; }
+	const char* getString(uint32_t offset) const { return m_strings + offset; }
+	// bytes of the compiled form
+	size_t getSize() const;
+	// getSize() bytes of header, bodies and strings, what write() writes
+	const uint8_t* getData() const { return (const uint8_t*)m_header; }
+	bool isMapped() const { return m_file.isOpen(); }
+};
+
+// a model of the catalog drawn as a placeholder sphere until it's loaded
+struct PlaceholderModel
+{
+	std::string path;
+	const Mesh* placeholder;
+};
+
+// creates a body in the store for every body of the catalog, loading each model once from the models directory into
+// the registry (or taking it from assets if it was loaded there), bodies with a model and a parent also get an orbit line
+// with placeholders nothing is loaded, each model gets a placeholder sphere of its own instead, listed there so
+// BodyStore::replaceMesh() can swap in the model once it is
+void addCatalogBodies(BodyStore& bodies, ResourceRegistry& resources, const BodyCatalog& catalog, const std::string& modelsDirectory,
+	const AssetLoader* assets = nullptr, std::vector<PlaceholderModel>* placeholders = nullptr);
+
+// path of every model the catalog's bodies use, each once, so they can be loaded ahead of addCatalogBodies()
+std::vector<std::string> getCatalogModels(const BodyCatalog& catalog, const std::string& modelsDirectory);
+
+// text catalog to compiled catalog, for --compile-catalog
+bool compileCatalog(const std::string& textPath, const std::string& binaryPath);
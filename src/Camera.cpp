@@ -17,22 +17,31 @@ void Camera::updateSensitivity(int movementSensitivity)
 	m_sensitivity = std::pow(1.2f, movementSensitivity);
 }
 
-void Camera::exportToShader(Shader& shader, const char* uniform)
+glm::mat4 Camera::getCamMatrix() const
 {
-	shader.bind();
-
 	// set camera position and direction
 	glm::mat4 view = glm::lookAt(m_position, m_position + m_orientation, m_upDirection);
 	// use perspective rather than orthographic, 45 degrees is non distorted
 	glm::mat4 projection = glm::perspective(glm::radians(m_FOVdeg), (float)m_width / m_height, m_nearPlane, m_farPlane);
 
-	glUniformMatrix4fv(glGetUniformLocation(shader.m_ID, uniform), 1, GL_FALSE, glm::value_ptr(projection * view));
+	return projection * view;
+}
+
+void Camera::exportToShader(Shader& shader, const char* uniform)
+{
+	shader.bind();
+
+	glUniformMatrix4fv(shader.getUniformLocation(uniform), 1, GL_FALSE, glm::value_ptr(getCamMatrix()));
 
 	// to debug current camera position
 	/*std::cout << m_position.x << " " << m_position.y << " " << m_position.z << " " << 
 		m_orientation.x << " " << m_orientation.y << " " << m_orientation.z << " " << std::endl;*/
 }
 
+float Camera::getNormalizedDepth(const glm::vec3& position) const
+{
+	return glm::length(position - m_position) / m_farPlane;
+}
 
 void Camera::getInputs(GLFWwindow* window)
 {
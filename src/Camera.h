@@ -14,6 +14,10 @@
 #include "Shader.h"
 #include "GUIParams.h"
 
+// where the camera starts, looking at the inner planets from above the belt
+#define CAMERA_START_POSITION glm::vec3(215.658, 141.441, 1122.28)
+#define CAMERA_START_ORIENTATION glm::vec3(-0.382241, -0.26202, -0.886138)
+
 class Camera
 {
 private:
@@ -50,9 +54,15 @@ public:
 	// updates sensitivity of scroll/wasd movement
 	void updateSensitivity(int movementSensitivity);
 
+	// projection * view
+	glm::mat4 getCamMatrix() const;
+
 	// exports the camera matrix to vertex shader
 	void exportToShader(Shader& shader, const char* uniform);
 
+	// distance from the camera divided by the far plane, used for depth sorting
+	float getNormalizedDepth(const glm::vec3& position) const;
+
 	// handles inputs from keyboard and mouse other than mouse scroll
 	void getInputs(GLFWwindow* window);
 };
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "CommandLine.h"
+
+#include <cstdio>
+
+// positive integer, false if it isn't one
+static bool parsePositive(const char* text, int& value)
+{
+	int parsed = 0;
+	char trailing;
+	if (std::sscanf(text, "%d%c", &parsed, &trailing) != 1 || parsed <= 0)
+	{
+		return false;
+	}
+	value = parsed;
+	return true;
+}
+
+// positive 64 bit integer, false if it isn't one
+static bool parseCount(const char* text, unsigned long long& value)
+{
+	unsigned long long parsed = 0;
+	char trailing;
+	if (text[0] == '-' || std::sscanf(text, "%llu%c", &parsed, &trailing) != 1 || parsed == 0)
+	{
+		return false;
+	}
+	value = parsed;
+	return true;
+}
+
+// WIDTHxHEIGHT
+static bool parseSize(const char* text, int& width, int& height)
+{
+	int parsedWidth = 0, parsedHeight = 0;
+	char trailing;
+	if (std::sscanf(text, "%dx%d%c", &parsedWidth, &parsedHeight, &trailing) != 2 || parsedWidth <= 0 || parsedHeight <= 0)
+	{
+		return false;
+	}
+	width = parsedWidth;
+	height = parsedHeight;
+	return true;
+}
+
+bool parseCommandLine(int argc, char* argv[], AppOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		int megabytes = 0;
+
+		if (arg == "--gl-debug-sync")
+		{
+			options.glDebugSynchronous = true;
+		}
+		else if (arg == "--gl-get-error")
+		{
+			options.glGetErrorChecks = true;
+		}
+		else if (arg == "--check-allocations")
+		{
+			options.checkAllocations = true;
+		}
+		else if (arg == "--profile")
+		{
+			options.profile = true;
+		}
+		else if (arg == "--trace" && i + 1 < argc)
+		{
+			options.tracePath = argv[++i];
+		}
+		else if (arg == "--startup-timeline" && i + 1 < argc)
+		{
+			options.startupTimelinePath = argv[++i];
+		}
+		else if (arg == "--catalog" && i + 1 < argc)
+		{
+			options.catalogPath = argv[++i];
+		}
+		else if (arg == "--compile-catalog" && i + 2 < argc)
+		{
+			options.compileCatalogInput = argv[++i];
+			options.compileCatalogOutput = argv[++i];
+		}
+		else if (arg == "--belt" && i + 1 < argc)
+		{
+			options.beltPath = argv[++i];
+		}
+		else if (arg == "--ingest-mpcorb" && i + 2 < argc)
+		{
+			options.ingestInput = argv[++i];
+			options.ingestOutput = argv[++i];
+		}
+		else if (arg == "--population" && i + 1 < argc)
+		{
+			options.populationPath = argv[++i];
+		}
+		else if (arg == "--population-budget" && i + 1 < argc && parsePositive(argv[i + 1], megabytes))
+		{
+			options.populationBudget = size_t(megabytes) * 1024 * 1024;
+			i++;
+		}
+		else if (arg == "--page-population" && i + 2 < argc)
+		{
+			options.pageInput = argv[++i];
+			options.pageOutput = argv[++i];
+		}
+		else if (arg == "--synthesize-belt" && i + 2 < argc && parseCount(argv[i + 1], options.synthesizeCount))
+		{
+			options.synthesizeOutput = argv[i + 2];
+			i += 2;
+		}
+		else if (arg == "--archive" && i + 1 < argc)
+		{
+			options.archivePath = argv[++i];
+		}
+		else if (arg == "--pack-assets" && i + 1 < argc)
+		{
+			options.packOutput = argv[++i];
+		}
+		else if (arg == "--headless")
+		{
+			options.headless = true;
+		}
+		else if (arg == "--stream")
+		{
+			options.stream = true;
+		}
+		else if (arg == "--size" && i + 1 < argc && parseSize(argv[i + 1], options.width, options.height))
+		{
+			i++;
+		}
+		else if (arg == "--frames" && i + 1 < argc && parsePositive(argv[i + 1], options.frames))
+		{
+			options.framesGiven = true;
+			i++;
+		}
+		else if (arg == "--fps" && i + 1 < argc && parsePositive(argv[i + 1], options.fps))
+		{
+			i++;
+		}
+		else if (arg == "--timeline" && i + 1 < argc)
+		{
+			options.timelinePath = argv[++i];
+		}
+		else if (arg == "--output" && i + 1 < argc)
+		{
+			options.outputPath = argv[++i];
+		}
+		else if (arg == "--timings" && i + 1 < argc)
+		{
+			options.timingsPath = argv[++i];
+		}
+		else if (arg == "--benchmark")
+		{
+			options.benchmark = true;
+		}
+		else if (arg == "--scene" && i + 1 < argc)
+		{
+			options.benchmarkScene = argv[++i];
+		}
+		else if (arg == "--microbench")
+		{
+			options.microbench = true;
+		}
+		else if (arg == "--filter" && i + 1 < argc)
+		{
+			options.microbenchFilter = argv[++i];
+		}
+		else
+		{
+			std::cout << "Unknown argument: " << arg << std::endl;
+			printUsage(argv[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void printUsage(const char* program)
+{
+	std::cout << "usage: " << program << " [options]\n"
+		<< "  --gl-debug-sync    report GL errors synchronously from the offending call (debug builds)\n"
+		<< "  --gl-get-error     check glGetError() around every GL call instead of using KHR_debug (debug builds)\n"
+		<< "  --check-allocations report heap allocations in steady state frames (debug builds break)\n"
+		<< "  --profile          start with the CPU profiler recording\n"
+		<< "  --trace <file>     where the Chrome trace is written, default trace.json\n"
+		<< "  --startup-timeline <file>\n"
+		<< "                     write each startup phase and asset's wall/CPU time and bytes read/uploaded as JSON\n"
+		<< "  --catalog <file>   bodies to load, text or compiled, default resources/solar_system.catalog\n"
+		<< "  --compile-catalog <in> <out>\n"
+		<< "                     compile a text catalog into its binary form and exit\n"
+		<< "  --belt <file>      ingested minor planets drawn as the belt, default resources/minor_planets.bin\n"
+		<< "                     (a random belt when the file doesn't exist)\n"
+		<< "  --ingest-mpcorb <in> <out>\n"
+		<< "                     ingest an MPCORB style minor planet file into the belt's binary form and exit\n"
+		<< "  --population <file>\n"
+		<< "                     paged minor planets streamed as the belt, default resources/minor_planets.pages\n"
+		<< "  --population-budget <MB>\n"
+		<< "                     GPU memory for the resident pages of the streamed belt, default 64\n"
+		<< "  --page-population <in> <out>\n"
+		<< "                     page ingested minor planets for streaming and exit\n"
+		<< "  --synthesize-belt <count> <out>\n"
+		<< "                     write count synthetic main belt minor planets in the ingested form and exit\n"
+		<< "  --archive <file>   read the scene's assets from this archive instead of the loose files\n"
+		<< "  --pack-assets <out>\n"
+		<< "                     build the mesh and texture caches and pack them with the shaders and catalog, then exit\n"
+		<< "  --headless         render offscreen (EGL or hidden window) without imgui\n"
+		<< "  --stream           draw headless frames while the scene streams in, as the window does\n"
+		<< "  --size WxH         headless framebuffer size, default 1500x800\n"
+		<< "  --frames <n>       headless frames to render, default 300 (or the whole timeline)\n"
+		<< "  --fps <n>          headless simulation steps per second, default 60\n"
+		<< "  --timeline <file>  headless camera keyframes, 'time posX posY posZ dirX dirY dirZ' per line\n"
+		<< "  --output <file>    write the last headless frame as a PPM image\n"
+		<< "  --timings <file>   write per pass GPU/CPU timings as JSON (benchmark results, default benchmark.json,\n"
+		<< "                     microbenchmark results, default microbench.tsv)\n"
+		<< "  --benchmark        headless camera flythrough of the benchmark scenes, reports frame time percentiles\n"
+		<< "  --scene <name>     run only this benchmark scene: overview, belt or jupiter\n"
+		<< "  --microbench       time the simulation/loading hot paths over body, instance and thread counts\n"
+		<< "  --filter <text>    run only the microbenchmarks whose name contains text\n"
+		<< std::flush;
+}
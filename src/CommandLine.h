@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+
+// options given on the command line, defaults are the interactive windowed app
+struct AppOptions
+{
+	// debug builds only, driver reports GL errors from inside the offending call (slower, but breaks on the culprit)
+	bool glDebugSynchronous = false;
+	// debug builds only, skip KHR_debug and check glGetError() around every GLCall() instead
+	bool glGetErrorChecks = false;
+
+	// complain about heap allocations in the simulate/record/submit part of steady state frames,
+	// breaks into the debugger in debug builds
+	bool checkAllocations = false;
+
+	// start with the profiler recording, and where "Dump trace" writes to
+	bool profile = false;
+	std::string tracePath = "trace.json";
+	// the startup timeline as JSON, written once the scene is at full quality when set
+	std::string startupTimelinePath;
+
+	// bodies of the scene, the shipped solar system when empty
+	std::string catalogPath;
+	// text catalog to compile into its binary form (then exit), and where the binary is written
+	std::string compileCatalogInput;
+	std::string compileCatalogOutput;
+
+	// ingested minor planets drawn as the belt, resources/minor_planets.bin when empty
+	std::string beltPath;
+	// MPCORB style text to ingest into the quantized binary (then exit), and where the binary is written
+	std::string ingestInput;
+	std::string ingestOutput;
+
+	// paged minor planets streamed as the belt, resources/minor_planets.pages when empty, and the GPU memory
+	// the resident pages may take (POPULATION_DEFAULT_BUDGET)
+	std::string populationPath;
+	size_t populationBudget = 64ull * 1024 * 1024;
+	// ingested minor planets to page for streaming (then exit), and where the pages are written
+	std::string pageInput;
+	std::string pageOutput;
+	// number of main belt like minor planets to synthesize into the ingested binary form (then exit)
+	unsigned long long synthesizeCount = 0;
+	std::string synthesizeOutput;
+
+	// archive the scene's assets are read from (see AssetArchive.h), the loose files when empty
+	std::string archivePath;
+	// where the archive of the scene's assets is packed to (then exit)
+	std::string packOutput;
+
+	// render offscreen without a window or imgui
+	bool headless = false;
+	// headless frames are drawn while the scene streams in, as the window does, instead of once it's all loaded
+	bool stream = false;
+	int width = 1500;
+	int height = 800;
+	// frames to render headless, a timeline runs to its end unless the count is given
+	int frames = 300;
+	bool framesGiven = false;
+	// simulation steps per second of timeline time
+	int fps = 60;
+	// camera keyframes, see Timeline.h
+	std::string timelinePath;
+	// final frame as PPM, and per pass timings as JSON, written when set
+	std::string outputPath;
+	std::string timingsPath;
+
+	// headless camera flythrough of the built in benchmark scenes, all of them unless one is named
+	bool benchmark = false;
+	std::string benchmarkScene;
+
+	// microbenchmarks of the simulation and loading hot paths, only the cases whose name contains the filter
+	bool microbench = false;
+	std::string microbenchFilter;
+};
+
+// fills in options from argv, prints the usage and returns false on anything it doesn't understand
+bool parseCommandLine(int argc, char* argv[], AppOptions& options);
+
+void printUsage(const char* program);
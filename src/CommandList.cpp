@@ -0,0 +1,40 @@
+#include "CommandList.h"
+
+uint64_t CommandList::makeSortKey(RenderLayer layer, uint32_t program, float depth, uint32_t texture, uint32_t geometry)
+{
+	// quantize depth, anything outside the frustum range just clamps to the ends
+	uint64_t depthBits = uint64_t(glm::clamp(depth, 0.0f, 1.0f) * 0xFFFF);
+
+	return (uint64_t(layer) & 0xF) << 60
+		| (uint64_t(program) & 0xFFF) << 48
+		| depthBits << 32
+		| (uint64_t(texture) & 0xFFFF) << 16
+		| (uint64_t(geometry) & 0xFFFF);
+}
+
+void CommandList::clear()
+{
+	m_commands.clear();
+	m_matrices.clear();
+}
+
+void CommandList::reserve(size_t commands, size_t matrices)
+{
+	m_commands.reserve(commands);
+	m_matrices.reserve(matrices);
+}
+
+void CommandList::push(DrawCommand command, const glm::mat4* model)
+{
+	if (model != nullptr)
+	{
+		command.matrixIndex = (uint32_t)m_matrices.size();
+		m_matrices.push_back(*model);
+	}
+	else
+	{
+		command.matrixIndex = NO_MATRIX;
+	}
+
+	m_commands.push_back(command);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/*
+* Draw commands are recorded on worker threads and replayed on the GL thread by RenderQueue.
+* Nothing in here touches the graphics API, resources are referred to by opaque handles which the
+* backend interprets (for the GL backend they are just object names).
+*/
+
+// layers are drawn in this order, the layer occupies the top bits of the sort key
+enum class RenderLayer : uint8_t
+{
+	Opaque = 0,
+	Lines = 1
+};
+
+// what a draw belongs to, only used to attribute GPU time
+enum class RenderPass : uint8_t
+{
+	Bodies,
+	Asteroids,
+	Orbits,
+	Skybox,
+	ImGui,
+	Count
+};
+
+enum class Primitive : uint8_t
+{
+	Triangles,
+	Lines
+};
+
+// a program and the slot its model matrix goes into, resolved on the GL thread before recording
+struct ProgramSlot
+{
+	uint32_t program = 0;
+	// -1 if the program has no model matrix
+	int32_t modelSlot = -1;
+	// of the vec3[2] position dequantization (scale, offset) of packed meshes, -1 if the program has none
+	int32_t dequantizeSlot = -1;
+};
+
+// everything needed to issue a single draw call
+struct DrawCommand
+{
+	uint64_t sortKey;
+
+	uint32_t program;
+	uint32_t geometry;
+	// 0 for untextured draws
+	uint32_t texture;
+	// per-instance data, only used by instanced draws
+	uint32_t instanceBuffer;
+
+	int32_t modelSlot;
+	// into the command list's matrices, NO_MATRIX if there is none
+	uint32_t matrixIndex;
+
+	int32_t dequantizeSlot;
+	// scale and offset for the dequantizeSlot, owned by the mesh, nullptr for geometry without one
+	const glm::vec3* dequantize;
+
+	uint32_t indexCount;
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	uint32_t indexType;
+	// the range of a shared buffer: first index in bytes, and what's added to every index
+	uint32_t indexOffset;
+	int32_t baseVertex;
+	uint32_t firstInstance;
+	// 1 if not an instanced draw call
+	uint32_t instanceCount;
+
+	Primitive primitive;
+	RenderPass pass;
+};
+
+#define NO_MATRIX 0xFFFFFFFFu
+
+// per-thread list of draw commands, model matrices are kept out of line so the commands stay small for sorting
+class CommandList
+{
+public:
+	std::vector<DrawCommand> m_commands;
+	std::vector<glm::mat4> m_matrices;
+
+	// key layout from most to least significant bits:
+	// layer (4) | program (12) | depth (16) | texture (16) | geometry (16)
+	// depth is ahead of texture/geometry because nearly every body has its own texture and VAO, grouping on those
+	// buys nothing while drawing opaque geometry front-to-back lets early-Z throw away hidden fragments
+	// depth is expected as distance / far plane, in the range [0, 1]
+	static uint64_t makeSortKey(RenderLayer layer, uint32_t program, float depth, uint32_t texture, uint32_t geometry);
+
+	// keeps the capacity, so steady state frames don't reallocate
+	void clear();
+
+	// makes room up front, so a view that shows more than any before doesn't allocate mid-frame
+	void reserve(size_t commands, size_t matrices);
+
+	// stores the matrix (if any) and fills in the command's matrixIndex
+	void push(DrawCommand command, const glm::mat4* model);
+};
@@ -0,0 +1,44 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t capacity)
+	: m_memory(new unsigned char[capacity]), m_capacity(capacity)
+{
+}
+
+void FrameArena::reset()
+{
+	if (!m_overflow.empty())
+	{
+		// one allocation now instead of some every frame from here on
+		m_overflow.clear();
+		m_capacity = std::max(m_capacity * 2, m_peak);
+		m_memory.reset(new unsigned char[m_capacity]);
+	}
+
+	m_used = 0;
+	m_overflowBytes = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+	uintptr_t base = (uintptr_t)m_memory.get();
+	size_t offset = ((base + m_used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+
+	if (offset + size <= m_capacity)
+	{
+		m_used = offset + size;
+		m_peak = std::max(m_peak, m_used + m_overflowBytes);
+		return m_memory.get() + offset;
+	}
+
+	// over capacity, new[] is aligned for any fundamental type
+	m_overflow.emplace_back(new unsigned char[size + alignment]);
+	m_overflowBytes += size + alignment;
+	m_peak = std::max(m_peak, m_used + m_overflowBytes);
+
+	uintptr_t overflow = (uintptr_t)m_overflow.back().get();
+	return (void*)((overflow + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// default capacity of the arena a Scene hands out per frame
+#define FRAME_ARENA_SIZE (256 * 1024)
+
+/*
+* Linear allocator for data that only lives until the end of the frame (sort orders, scratch arrays)
+* Allocating bumps a pointer, reset() at the start of the next frame frees everything at once. Memory isn't
+* constructed or destructed, so only trivially destructible types belong here.
+* A frame that outgrows the capacity is served from the heap so nothing breaks, and the next reset() grows the
+* arena to fit, the steady state then never touches the heap.
+*/
+class FrameArena
+{
+private:
+	std::unique_ptr<unsigned char[]> m_memory;
+	size_t m_capacity;
+	size_t m_used = 0;
+	// most memory any frame has used, what the arena grows to after an overflow
+	size_t m_peak = 0;
+
+	std::vector<std::unique_ptr<unsigned char[]>> m_overflow;
+	size_t m_overflowBytes = 0;
+
+public:
+	explicit FrameArena(size_t capacity = FRAME_ARENA_SIZE);
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// frees everything allocated since the last reset, grows the arena if the frame overflowed it
+	void reset();
+
+	// alignment must be a power of two
+	void* allocate(size_t size, size_t alignment);
+
+	template <typename T>
+	T* allocateArray(size_t count)
+	{
+		return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+	}
+
+	size_t getUsed() const { return m_used + m_overflowBytes; }
+	size_t getCapacity() const { return m_capacity; }
+};
@@ -0,0 +1,65 @@
+#include "FrameRecorder.h"
+
+#include "Profiler.h"
+
+FrameRecorder::FrameRecorder(JobSystem& jobs)
+	: m_jobs(jobs), m_lists(jobs.getNumSlots())
+{
+}
+
+void FrameRecorder::record(const FrameView& view, const BodyStore& bodies, const Mesh* asteroid, const std::vector<BeltChunk>& beltChunks)
+{
+	m_view = view;
+	m_bodies = &bodies;
+	m_orbitCount = view.drawOrbits ? bodies.getOrbitVisuals().size() : 0;
+	m_asteroid = asteroid;
+	m_beltChunks = &beltChunks;
+	size_t chunkCount = asteroid != nullptr ? beltChunks.size() : 0;
+
+	// any slot may end up recording everything: every body, orbit and belt chunk
+	size_t maxMatrices = bodies.getRenderProxies().size() + bodies.getOrbitVisuals().size();
+	for (auto& list : m_lists)
+	{
+		list.clear();
+		list.reserve(maxMatrices + chunkCount, maxMatrices);
+	}
+
+	size_t count = bodies.getRenderProxies().size() + m_orbitCount + chunkCount;
+	m_jobs.parallelFor((unsigned int)count, &FrameRecorder::recordItem, this);
+}
+
+void FrameRecorder::recordItem(void* context, unsigned int index, unsigned int slot)
+{
+	PROFILE_ZONE("RecordItem");
+
+	FrameRecorder& recorder = *static_cast<FrameRecorder*>(context);
+	const FrameView& view = recorder.m_view;
+	CommandList& list = recorder.m_lists[slot];
+
+	const BodyStore& bodies = *recorder.m_bodies;
+	size_t proxyCount = bodies.getRenderProxies().size();
+	if (index < proxyCount)
+	{
+		// stars are drawn unlit by the light source shader
+		bool star = bodies.getType(bodies.getRenderProxies().getOwner(index)) == BodyType::Star;
+		bodies.recordBody(index, list, star ? view.sunProgram : view.bodyProgram, *view.camera, view.frustum);
+		return;
+	}
+
+	index -= (unsigned int)proxyCount;
+	if (index < recorder.m_orbitCount)
+	{
+		bodies.recordOrbit(index, list, view.orbitProgram, view.frustum);
+		return;
+	}
+
+	const BeltChunk& chunk = (*recorder.m_beltChunks)[index - recorder.m_orbitCount];
+	float radius = chunk.radius + chunk.maxScale * recorder.m_asteroid->getBoundingRadius();
+	if (!view.frustum.intersectsSphere(chunk.center, radius))
+	{
+		return;
+	}
+
+	recorder.m_asteroid->record(list, view.asteroidProgram, RenderLayer::Opaque, RenderPass::Asteroids, nullptr,
+		view.camera->getNormalizedDepth(chunk.center), chunk.firstInstance, chunk.instanceCount);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "CommandList.h"
+#include "JobSystem.h"
+#include "Frustum.h"
+#include "Camera.h"
+#include "Mesh.h"
+#include "Bodies.h"
+#include "AsteroidBelt.h"
+
+// what the workers need to know about the frame, filled in on the GL thread before recording
+struct FrameView
+{
+	const Camera* camera = nullptr;
+	Frustum frustum;
+
+	bool drawOrbits = false;
+
+	ProgramSlot sunProgram;
+	ProgramSlot bodyProgram;
+	ProgramSlot orbitProgram;
+	ProgramSlot asteroidProgram;
+};
+
+// records the frame's draw commands for bodies, orbits and belt chunks in parallel on the job system
+// every slot of the job system records into its own command list, RenderQueue merges them afterwards
+class FrameRecorder
+{
+private:
+	JobSystem& m_jobs;
+	std::vector<CommandList> m_lists;
+
+	// scene being recorded, only valid during record()
+	FrameView m_view;
+	const BodyStore* m_bodies = nullptr;
+	// orbit visuals to record, none when orbits are hidden
+	size_t m_orbitCount = 0;
+	const Mesh* m_asteroid = nullptr;
+	const std::vector<BeltChunk>* m_beltChunks = nullptr;
+
+	// job entry point, index covers the render proxies first, then the orbit visuals, then the belt chunks
+	static void recordItem(void* context, unsigned int index, unsigned int slot);
+
+public:
+	explicit FrameRecorder(JobSystem& jobs);
+
+	// returns once every command list is filled in, the scene must not change until then
+	// the belt is skipped while asteroid is nullptr (its model hasn't streamed in yet)
+	void record(const FrameView& view, const BodyStore& bodies, const Mesh* asteroid, const std::vector<BeltChunk>& beltChunks);
+
+	const std::vector<CommandList>& getLists() const { return m_lists; }
+};
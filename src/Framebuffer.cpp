@@ -0,0 +1,71 @@
+#include "Framebuffer.h"
+
+#include <fstream>
+#include <iostream>
+
+#include "GLErrors.h"
+
+Framebuffer::Framebuffer(int width, int height)
+	: m_width(width), m_height(height)
+{
+	glGenFramebuffers(1, &m_FBO);
+	glGenRenderbuffers(1, &m_colorRBO);
+	glGenRenderbuffers(1, &m_depthRBO);
+
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_colorRBO));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_depthRBO));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height));
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_FBO));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorRBO));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRBO));
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Framebuffer " << width << "x" << height << " is incomplete" << std::endl;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+Framebuffer::~Framebuffer()
+{
+	glDeleteFramebuffers(1, &m_FBO);
+	glDeleteRenderbuffers(1, &m_colorRBO);
+	glDeleteRenderbuffers(1, &m_depthRBO);
+}
+
+void Framebuffer::bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+	glViewport(0, 0, m_width, m_height);
+}
+
+bool Framebuffer::writePPM(const std::string& path)
+{
+	std::vector<unsigned char> pixels(size_t(m_width) * m_height * 3);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_FBO);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	GLCall(glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data()));
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+	{
+		std::cout << "Failed to write image: " << path << std::endl;
+		return false;
+	}
+
+	out << "P6\n" << m_width << " " << m_height << "\n255\n";
+
+	// GL's origin is the bottom left, PPM's the top left
+	for (int y = m_height - 1; y >= 0; y--)
+	{
+		out.write((const char*)&pixels[size_t(y) * m_width * 3], size_t(m_width) * 3);
+	}
+
+	std::cout << "Wrote image: " << path << std::endl;
+	return true;
+}
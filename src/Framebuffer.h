@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <string>
+
+// offscreen render target of any size: RGBA8 color + 24 bit depth renderbuffers
+class Framebuffer
+{
+private:
+	unsigned int m_FBO, m_colorRBO, m_depthRBO;
+
+public:
+	int m_width;
+	int m_height;
+
+	Framebuffer(int width, int height);
+	~Framebuffer();
+
+	Framebuffer(const Framebuffer&) = delete;
+	Framebuffer& operator=(const Framebuffer&) = delete;
+
+	// binds for drawing and sets the viewport to cover it
+	void bind();
+
+	// reads back the color buffer and writes it as a binary PPM, blocks until the GPU is done
+	bool writePPM(const std::string& path);
+};
@@ -0,0 +1,40 @@
+#include "Frustum.h"
+
+Frustum Frustum::fromMatrix(const glm::mat4& camMatrix)
+{
+	Frustum frustum;
+
+	// rows of the matrix (glm is column major)
+	glm::vec4 row0(camMatrix[0][0], camMatrix[1][0], camMatrix[2][0], camMatrix[3][0]);
+	glm::vec4 row1(camMatrix[0][1], camMatrix[1][1], camMatrix[2][1], camMatrix[3][1]);
+	glm::vec4 row2(camMatrix[0][2], camMatrix[1][2], camMatrix[2][2], camMatrix[3][2]);
+	glm::vec4 row3(camMatrix[0][3], camMatrix[1][3], camMatrix[2][3], camMatrix[3][3]);
+
+	// Gribb/Hartmann plane extraction
+	frustum.m_planes[0] = row3 + row0;
+	frustum.m_planes[1] = row3 - row0;
+	frustum.m_planes[2] = row3 + row1;
+	frustum.m_planes[3] = row3 - row1;
+	frustum.m_planes[4] = row3 + row2;
+	frustum.m_planes[5] = row3 - row2;
+
+	// normalize so the distance test against the radius is in world units
+	for (auto& plane : frustum.m_planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	return frustum;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const
+{
+	for (const auto& plane : m_planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
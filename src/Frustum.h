@@ -0,0 +1,16 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// view frustum as 6 planes, used to skip bodies and belt chunks that can't be seen
+struct Frustum
+{
+	// left, right, bottom, top, near, far, normals point inwards
+	glm::vec4 m_planes[6];
+
+	// extracts the planes from a projection * view matrix
+	static Frustum fromMatrix(const glm::mat4& camMatrix);
+
+	// true if any part of the sphere is inside the frustum
+	bool intersectsSphere(const glm::vec3& center, float radius) const;
+};
@@ -1,5 +1,117 @@
 #include "GLErrors.h"
 
+#include <cstring>
+
+// KHR_debug is not part of the 3.3 core profile glad was generated for
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#endif
+
+typedef void (APIENTRYP PFNDEBUGMESSAGECALLBACKPROC)(GLDEBUGPROC callback, const void* userParam);
+typedef void (APIENTRYP PFNDEBUGMESSAGECONTROLPROC)(GLenum source, GLenum type, GLenum severity, GLsizei count,
+    const GLuint* ids, GLboolean enabled);
+
+bool glDebugOutputActive = false;
+
+// whether the driver reports from inside the offending call, only then is breaking useful
+static bool debugOutputSynchronous = false;
+
+static bool hasExtension(const char* name)
+{
+    GLint numExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+    for (GLint i = 0; i < numExtensions; i++)
+    {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void APIENTRY debugMessageCallback(GLenum /*source*/, GLenum type, GLuint id, GLenum severity, GLsizei /*length*/,
+    const GLchar* message, const void* /*userParam*/)
+{
+    const char* severityName =
+        severity == GL_DEBUG_SEVERITY_HIGH ? "high" :
+        severity == GL_DEBUG_SEVERITY_MEDIUM ? "medium" :
+        severity == GL_DEBUG_SEVERITY_LOW ? "low" : "notification";
+
+    std::cout << "[OpenGL Debug] (" << std::hex << id << std::dec << ", " << severityName << ") " << message << std::endl;
+
+    if (type == GL_DEBUG_TYPE_ERROR && debugOutputSynchronous)
+    {
+        DEBUG_BREAK();
+    }
+}
+
+bool initGLDebugOutput(GLADloadproc loadProc, bool synchronous, bool getErrorOnly)
+{
+#ifdef NDEBUG
+    (void)loadProc;
+    (void)synchronous;
+    (void)getErrorOnly;
+    return false;
+#else
+    if (getErrorOnly)
+    {
+        std::cout << "KHR_debug not used, checking glGetError() around every GL call" << std::endl;
+        return false;
+    }
+
+    // core since 4.3, same entry points through KHR_debug, ARB_debug_output has the suffixed ones
+    PFNDEBUGMESSAGECALLBACKPROC debugMessageCallbackProc = nullptr;
+    PFNDEBUGMESSAGECONTROLPROC debugMessageControlProc = nullptr;
+
+    if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3) || hasExtension("GL_KHR_debug"))
+    {
+        debugMessageCallbackProc = (PFNDEBUGMESSAGECALLBACKPROC)loadProc("glDebugMessageCallback");
+        debugMessageControlProc = (PFNDEBUGMESSAGECONTROLPROC)loadProc("glDebugMessageControl");
+    }
+    else if (hasExtension("GL_ARB_debug_output"))
+    {
+        debugMessageCallbackProc = (PFNDEBUGMESSAGECALLBACKPROC)loadProc("glDebugMessageCallbackARB");
+        debugMessageControlProc = (PFNDEBUGMESSAGECONTROLPROC)loadProc("glDebugMessageControlARB");
+    }
+
+    if (debugMessageCallbackProc == nullptr)
+    {
+        std::cout << "KHR_debug not supported, falling back to glGetError()" << std::endl;
+        return false;
+    }
+
+    glEnable(GL_DEBUG_OUTPUT);
+    if (synchronous)
+    {
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
+    debugOutputSynchronous = synchronous;
+
+    debugMessageCallbackProc(debugMessageCallback, nullptr);
+
+    // notifications are mostly drivers chatting about buffer placement, not worth the noise
+    if (debugMessageControlProc != nullptr)
+    {
+        debugMessageControlProc(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+    }
+
+    // anything still queued from before the callback was installed won't be reported by it
+    GLClearError();
+
+    glDebugOutputActive = true;
+    return true;
+#endif
+}
+
 void GLClearError()
 {
     /*while (glGetError() != GL_NO_ERROR);*/
@@ -10,8 +122,8 @@ bool GLLogCall(const char* function, const char* file, int line)
 {
     while (GLenum error = glGetError())
     {
-        std::cout << "[OpenGL Error] (" << std::hex << error << function << " " << file << ":" << std::dec << line << ")" << std::endl;
+        std::cout << "[OpenGL Error] (" << std::hex << error << " " << function << " " << file << ":" << std::dec << line << ")" << std::endl;
         return false;
     }
     return true;
-}
\ No newline at end of file
+}
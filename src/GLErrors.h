@@ -6,15 +6,41 @@
 
 /*
 * This file defines macros to flush out openGL errors, used for debugging
-* GLCall() is used to run statements to determine error values which can are defined in "glad.c"
-* in hexadecimal
+* In debug builds errors are reported by the driver through a KHR_debug message callback (see initGLDebugOutput()),
+* so GLCall() doesn't have to query anything and costs next to nothing. If the context has no KHR_debug, GLCall() falls
+* back to running glGetError() around every call, the error values are defined in "glad.c" in hexadecimal
+* Release builds (NDEBUG) compile every check out
 */
 
-#define ASSERT(x) if (!(x)) __debugbreak()
-#define GLCall(x) GLClearError();\
+#if defined(_MSC_VER)
+#define DEBUG_BREAK() __debugbreak()
+#elif defined(__GNUC__) || defined(__clang__)
+#define DEBUG_BREAK() __builtin_trap()
+#else
+#include <cstdlib>
+#define DEBUG_BREAK() std::abort()
+#endif
+
+#define ASSERT(x) if (!(x)) DEBUG_BREAK()
+
+#ifdef NDEBUG
+#define GLCall(x) x
+#else
+#define GLCall(x) if (!glDebugOutputActive) GLClearError();\
     x;\
-    ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+    ASSERT(glDebugOutputActive || GLLogCall(#x, __FILE__, __LINE__))
+#endif
+
+// true once the debug message callback is installed, GLCall() then leaves error checking to the driver
+extern bool glDebugOutputActive;
+
+// installs the debug message callback if the context supports KHR_debug (or ARB_debug_output)
+// synchronous makes the driver call back from inside the offending call, so a breakpoint shows the culprit,
+// at the cost of serializing with the driver
+// getErrorOnly leaves KHR_debug off, so GLCall() checks glGetError() around every call as it does without it
+// does nothing in release builds, returns whether debug output is active
+bool initGLDebugOutput(GLADloadproc loadProc, bool synchronous, bool getErrorOnly = false);
 
 void GLClearError();
 
-bool GLLogCall(const char* function, const char* file, int line);
\ No newline at end of file
+bool GLLogCall(const char* function, const char* file, int line);
@@ -0,0 +1,225 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "GLErrors.h"
+#include "Profiler.h"
+#include "StartupTimeline.h"
+
+RangeAllocator::RangeAllocator(uint32_t capacity)
+	: m_capacity(capacity)
+{
+	if (capacity > 0)
+	{
+		m_free.emplace(0, capacity);
+	}
+}
+
+bool RangeAllocator::allocate(uint32_t size, uint32_t alignment, uint32_t& offset)
+{
+	for (auto it = m_free.begin(); it != m_free.end(); ++it)
+	{
+		uint32_t start = it->first;
+		uint32_t end = it->first + it->second;
+		uint32_t aligned = (start + alignment - 1) & ~(alignment - 1);
+		if (aligned > end || end - aligned < size)
+		{
+			continue;
+		}
+
+		// whatever is left on either side of the allocation stays free
+		m_free.erase(it);
+		if (aligned > start)
+		{
+			m_free.emplace(start, aligned - start);
+		}
+		if (aligned + size < end)
+		{
+			m_free.emplace(aligned + size, end - aligned - size);
+		}
+
+		m_used += size;
+		offset = aligned;
+		return true;
+	}
+	return false;
+}
+
+void RangeAllocator::free(uint32_t offset, uint32_t size)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	m_used -= size;
+	auto it = m_free.emplace(offset, size).first;
+
+	auto next = std::next(it);
+	if (next != m_free.end() && it->first + it->second == next->first)
+	{
+		it->second += next->second;
+		m_free.erase(next);
+	}
+	if (it != m_free.begin())
+	{
+		auto previous = std::prev(it);
+		if (previous->first + previous->second == it->first)
+		{
+			previous->second += it->second;
+			m_free.erase(it);
+		}
+	}
+}
+
+void RangeAllocator::grow(uint32_t newCapacity)
+{
+	uint32_t oldCapacity = m_capacity;
+	m_capacity = newCapacity;
+	m_used += newCapacity - oldCapacity;
+	free(oldCapacity, newCapacity - oldCapacity);
+}
+
+GeometryArena::GeometryArena(uint32_t vertexCapacity, uint32_t indexCapacity)
+	: m_vertices(vertexCapacity), m_indices(indexCapacity)
+{
+	GLCall(glGenBuffers(1, &m_vertexBuffer));
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer));
+	GLCall(glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity, nullptr, GL_STATIC_DRAW));
+
+	GLCall(glGenBuffers(1, &m_indexBuffer));
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer));
+	GLCall(glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity, nullptr, GL_STATIC_DRAW));
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+
+	m_layoutArrays[size_t(VertexLayout::Float)] = createVertexArray(VertexLayout::Float);
+	m_layoutArrays[size_t(VertexLayout::Packed)] = createVertexArray(VertexLayout::Packed);
+}
+
+GeometryArena::~GeometryArena()
+{
+	for (const auto& vertexArray : m_vertexArrays)
+	{
+		glDeleteVertexArrays(1, &vertexArray.first);
+	}
+	glDeleteBuffers(1, &m_vertexBuffer);
+	glDeleteBuffers(1, &m_indexBuffer);
+}
+
+void GeometryArena::setupVertexArray(VertexLayout layout)
+{
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer));
+
+	// the shaders see the same vec3 position/vec2 uv/vec3 normal either way
+	if (layout == VertexLayout::Packed)
+	{
+		GLCall(glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position)));
+		GLCall(glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoord)));
+		GLCall(glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal)));
+	}
+	else
+	{
+		GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position)));
+		GLCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoor)));
+		GLCall(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal)));
+	}
+	GLCall(glEnableVertexAttribArray(0));
+	GLCall(glEnableVertexAttribArray(1));
+	GLCall(glEnableVertexAttribArray(2));
+
+	// element buffer binding is VAO state
+	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer));
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+unsigned int GeometryArena::createVertexArray(VertexLayout layout)
+{
+	unsigned int VAO;
+	GLCall(glGenVertexArrays(1, &VAO));
+	GLCall(glBindVertexArray(VAO));
+	setupVertexArray(layout);
+	GLCall(glBindVertexArray(0));
+
+	m_vertexArrays.emplace_back(VAO, layout);
+	return VAO;
+}
+
+void GeometryArena::deleteVertexArray(unsigned int VAO)
+{
+	auto it = std::find_if(m_vertexArrays.begin(), m_vertexArrays.end(), [&](const auto& vertexArray) { return vertexArray.first == VAO; });
+	if (it != m_vertexArrays.end())
+	{
+		m_vertexArrays.erase(it);
+		glDeleteVertexArrays(1, &VAO);
+	}
+}
+
+void GeometryArena::growBuffer(unsigned int& buffer, RangeAllocator& allocator, uint32_t needed)
+{
+	PROFILE_ZONE("GeometryArena::growBuffer");
+
+	uint64_t capacity = std::max<uint64_t>(uint64_t(allocator.getCapacity()) * 2, uint64_t(allocator.getCapacity()) + needed);
+	capacity = std::min<uint64_t>(capacity, 0xFFFFFFFFull);
+
+	// copied on the GPU, the old contents never come back to the host
+	unsigned int grown;
+	GLCall(glGenBuffers(1, &grown));
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, grown));
+	GLCall(glBufferData(GL_COPY_WRITE_BUFFER, size_t(capacity), nullptr, GL_STATIC_DRAW));
+	GLCall(glBindBuffer(GL_COPY_READ_BUFFER, buffer));
+	GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, allocator.getCapacity()));
+	GLCall(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+	glDeleteBuffers(1, &buffer);
+
+	buffer = grown;
+	allocator.grow(uint32_t(capacity));
+
+	for (const auto& vertexArray : m_vertexArrays)
+	{
+		GLCall(glBindVertexArray(vertexArray.first));
+		setupVertexArray(vertexArray.second);
+	}
+	GLCall(glBindVertexArray(0));
+}
+
+GeometryHandle GeometryArena::allocate(const MeshData& data)
+{
+	PROFILE_ZONE("GeometryArena::allocate");
+
+	uint32_t vertexSize = (uint32_t)getVertexSize(data.layout);
+
+	GeometryHandle geometry;
+	geometry.layout = data.layout;
+	geometry.vertexBytes = data.vertexCount * vertexSize;
+	geometry.indexBytes = data.indexCount * data.indexSize;
+	geometry.indexCount = data.indexCount;
+	geometry.indexType = data.indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	while (!m_vertices.allocate(geometry.vertexBytes, GEOMETRY_ARENA_VERTEX_ALIGNMENT, geometry.vertexOffset))
+	{
+		growBuffer(m_vertexBuffer, m_vertices, geometry.vertexBytes + GEOMETRY_ARENA_VERTEX_ALIGNMENT);
+	}
+	while (!m_indices.allocate(geometry.indexBytes, GEOMETRY_ARENA_INDEX_ALIGNMENT, geometry.indexOffset))
+	{
+		growBuffer(m_indexBuffer, m_indices, geometry.indexBytes + GEOMETRY_ARENA_INDEX_ALIGNMENT);
+	}
+	geometry.baseVertex = int32_t(geometry.vertexOffset / vertexSize);
+
+	// through the copy target, binding the element buffer here would change whatever VAO is bound
+	StartupTimeline::addBytesUploaded(uint64_t(geometry.vertexBytes) + geometry.indexBytes);
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer));
+	GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, geometry.vertexOffset, geometry.vertexBytes, data.vertices));
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer));
+	GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, geometry.indexOffset, geometry.indexBytes, data.indices));
+	GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+
+	return geometry;
+}
+
+void GeometryArena::free(const GeometryHandle& geometry)
+{
+	m_vertices.free(geometry.vertexOffset, geometry.vertexBytes);
+	m_indices.free(geometry.indexOffset, geometry.indexBytes);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "Vertex.h"
+
+// starting sizes of the shared buffers, they double when an upload doesn't fit
+#define GEOMETRY_ARENA_VERTEX_BYTES (4u << 20)
+#define GEOMETRY_ARENA_INDEX_BYTES (1u << 20)
+// multiple of both vertex sizes, so any vertex range starts on a whole vertex of either layout
+#define GEOMETRY_ARENA_VERTEX_ALIGNMENT 32u
+#define GEOMETRY_ARENA_INDEX_ALIGNMENT 4u
+
+/*
+* First-fit suballocator over a byte range [0, capacity)
+* Free ranges are kept by offset and merged with their neighbours when freed. Meshes are loaded and freed a handful
+* of times per run, so a map is plenty.
+*/
+class RangeAllocator
+{
+private:
+	// offset -> size
+	std::map<uint32_t, uint32_t> m_free;
+	uint32_t m_capacity = 0;
+	uint32_t m_used = 0;
+
+public:
+	explicit RangeAllocator(uint32_t capacity);
+
+	// false if no free range is big enough, alignment must be a power of two
+	bool allocate(uint32_t size, uint32_t alignment, uint32_t& offset);
+	void free(uint32_t offset, uint32_t size);
+	// adds [capacity, newCapacity) to the free ranges
+	void grow(uint32_t newCapacity);
+
+	uint32_t getCapacity() const { return m_capacity; }
+	uint32_t getUsed() const { return m_used; }
+};
+
+// where a mesh's vertices and indices live in the arena, offsets and sizes in bytes
+struct GeometryHandle
+{
+	VertexLayout layout = VertexLayout::Float;
+	uint32_t vertexOffset = 0;
+	uint32_t vertexBytes = 0;
+	uint32_t indexOffset = 0;
+	uint32_t indexBytes = 0;
+	// vertexOffset in vertices of the layout, added to every index when drawing
+	int32_t baseVertex = 0;
+	uint32_t indexCount = 0;
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	uint32_t indexType = GL_UNSIGNED_INT;
+};
+
+/*
+* One vertex buffer and one index buffer that every mesh's geometry is suballocated from
+* Meshes of a vertex layout share one VAO and draw their range with a base vertex and index offset, so drawing the
+* bodies doesn't switch VAOs or buffers at all. Meshes with per instance attributes get their own VAO over the same
+* buffers. When a buffer grows its contents are copied on the GPU and every VAO handed out is re-pointed, nothing
+* is kept in host memory.
+* Must outlive the meshes allocated from it and needs a current GL context.
+*/
+class GeometryArena
+{
+private:
+	unsigned int m_vertexBuffer = 0;
+	unsigned int m_indexBuffer = 0;
+	RangeAllocator m_vertices;
+	RangeAllocator m_indices;
+
+	// the shared VAO of each layout, by VertexLayout
+	unsigned int m_layoutArrays[2] = {};
+	// every VAO over the buffers and its layout, shared or not
+	std::vector<std::pair<unsigned int, VertexLayout>> m_vertexArrays;
+
+	// points the bound VAO's vertex attributes and element buffer at the arena
+	void setupVertexArray(VertexLayout layout);
+	// at least doubles the buffer, keeping the contents
+	void growBuffer(unsigned int& buffer, RangeAllocator& allocator, uint32_t needed);
+
+public:
+	GeometryArena(uint32_t vertexCapacity = GEOMETRY_ARENA_VERTEX_BYTES, uint32_t indexCapacity = GEOMETRY_ARENA_INDEX_BYTES);
+	~GeometryArena();
+
+	GeometryArena(const GeometryArena&) = delete;
+	GeometryArena& operator=(const GeometryArena&) = delete;
+
+	// uploads the vertices and indices, data can go away afterwards
+	GeometryHandle allocate(const MeshData& data);
+	void free(const GeometryHandle& geometry);
+
+	// shared by every mesh of the layout
+	unsigned int getVertexArray(VertexLayout layout) const { return m_layoutArrays[size_t(layout)]; }
+	// a VAO of its own over the arena's buffers, for meshes that add attributes, give it back with deleteVertexArray()
+	unsigned int createVertexArray(VertexLayout layout);
+	void deleteVertexArray(unsigned int VAO);
+
+	const RangeAllocator& getVertexAllocator() const { return m_vertices; }
+	const RangeAllocator& getIndexAllocator() const { return m_indices; }
+};
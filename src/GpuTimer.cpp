@@ -0,0 +1,357 @@
+#include "GpuTimer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include <iostream>
+
+#include "imgui/imgui.h"
+#include "GLErrors.h"
+
+GpuTimer::GpuTimer(unsigned int historyLength)
+	: m_historyLength(std::max(historyLength, 1u))
+{
+	for (auto& history : m_passHistory)
+	{
+		history.assign(m_historyLength, 0.0f);
+	}
+	m_gpuTotalHistory.assign(m_historyLength, 0.0f);
+	m_cpuHistory.assign(m_historyLength, 0.0f);
+	m_scratch.reserve(m_historyLength);
+
+	for (auto& frame : m_frames)
+	{
+		frame.queries.reserve(GPU_TIMER_SEGMENTS);
+		frame.passes.reserve(GPU_TIMER_SEGMENTS);
+	}
+}
+
+GpuTimer::~GpuTimer()
+{
+	for (auto& frame : m_frames)
+	{
+		if (!frame.queries.empty())
+		{
+			glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+		}
+	}
+}
+
+void GpuTimer::beginFrame()
+{
+	FrameQueries& frame = m_frames[m_frameIndex];
+	if (frame.pending)
+	{
+		collect(frame);
+	}
+	frame.used = 0;
+}
+
+void GpuTimer::endFrame(float cpuMs)
+{
+	endPass();
+
+	FrameQueries& frame = m_frames[m_frameIndex];
+	frame.pending = true;
+	frame.cpuMs = cpuMs;
+
+	m_frameIndex = (m_frameIndex + 1) % GPU_TIMER_FRAMES;
+}
+
+void GpuTimer::finish()
+{
+	endPass();
+
+	// oldest first, m_frameIndex is the slot that was issued longest ago
+	for (unsigned int i = 0; i < GPU_TIMER_FRAMES; i++)
+	{
+		FrameQueries& frame = m_frames[(m_frameIndex + i) % GPU_TIMER_FRAMES];
+		if (frame.pending)
+		{
+			collect(frame);
+		}
+	}
+}
+
+void GpuTimer::clear()
+{
+	m_historyHead = 0;
+	m_historySize = 0;
+	m_stalls = 0;
+}
+
+void GpuTimer::beginPass(RenderPass pass)
+{
+	if (m_passOpen && m_currentPass == pass)
+	{
+		return;
+	}
+	endPass();
+
+	FrameQueries& frame = m_frames[m_frameIndex];
+	if (frame.used == frame.queries.size())
+	{
+		GLuint query;
+		glGenQueries(1, &query);
+		frame.queries.push_back(query);
+		frame.passes.push_back(pass);
+	}
+
+	frame.passes[frame.used] = pass;
+	GLCall(glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.used]));
+	frame.used++;
+
+	m_passOpen = true;
+	m_currentPass = pass;
+}
+
+void GpuTimer::endPass()
+{
+	if (!m_passOpen)
+	{
+		return;
+	}
+
+	GLCall(glEndQuery(GL_TIME_ELAPSED));
+	m_passOpen = false;
+}
+
+void GpuTimer::collect(FrameQueries& frame)
+{
+	frame.pending = false;
+
+	// queries complete in order, so the last one being available means all of them are
+	if (frame.used > 0)
+	{
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			// the GPU is more than GPU_TIMER_FRAMES - 1 frames behind, the read below will wait for it
+			m_stalls++;
+		}
+	}
+
+	float passMs[(int)RenderPass::Count] = {};
+	float totalMs = 0.0f;
+	for (unsigned int i = 0; i < frame.used; i++)
+	{
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &elapsed);
+
+		float ms = float(elapsed / 1.0e6);
+		passMs[(int)frame.passes[i]] += ms;
+		totalMs += ms;
+	}
+
+	for (int pass = 0; pass < (int)RenderPass::Count; pass++)
+	{
+		m_passHistory[pass][m_historyHead] = passMs[pass];
+	}
+	m_gpuTotalHistory[m_historyHead] = totalMs;
+	m_cpuHistory[m_historyHead] = frame.cpuMs;
+
+	m_historyHead = (m_historyHead + 1) % m_historyLength;
+	m_historySize = std::min(m_historySize + 1, m_historyLength);
+}
+
+std::vector<float> GpuTimer::ordered(const std::vector<float>& history) const
+{
+	std::vector<float> result;
+	result.reserve(m_historySize);
+
+	unsigned int start = (m_historyHead + m_historyLength - m_historySize) % m_historyLength;
+	for (unsigned int i = 0; i < m_historySize; i++)
+	{
+		result.push_back(history[(start + i) % m_historyLength]);
+	}
+	return result;
+}
+
+// sample at the given fraction of a sorted series
+static float percentile(const std::vector<float>& sorted, double fraction)
+{
+	return sorted[std::min(sorted.size() - 1, size_t(sorted.size() * fraction))];
+}
+
+TimingStats GpuTimer::computeStats(const std::vector<float>& history) const
+{
+	TimingStats stats;
+	if (m_historySize == 0)
+	{
+		return stats;
+	}
+
+	// the valid samples are always the first m_historySize (the ring only wraps once it's full), and order doesn't
+	// matter once they're sorted
+	std::vector<float>& samples = m_scratch;
+	samples.assign(history.begin(), history.begin() + m_historySize);
+	stats.last = history[(m_historyHead + m_historyLength - 1) % m_historyLength];
+
+	float sum = 0.0f;
+	for (float sample : samples)
+	{
+		sum += sample;
+	}
+	stats.avg = sum / samples.size();
+
+	std::sort(samples.begin(), samples.end());
+	stats.min = samples.front();
+	stats.max = samples.back();
+	stats.p50 = percentile(samples, 0.50);
+	stats.p95 = percentile(samples, 0.95);
+	stats.p99 = percentile(samples, 0.99);
+
+	return stats;
+}
+
+const char* GpuTimer::getPassName(RenderPass pass)
+{
+	switch (pass)
+	{
+	case RenderPass::Bodies: return "bodies";
+	case RenderPass::Asteroids: return "asteroids";
+	case RenderPass::Orbits: return "orbits";
+	case RenderPass::Skybox: return "skybox";
+	case RenderPass::ImGui: return "imgui";
+	default: return "unknown";
+	}
+}
+
+TimingStats GpuTimer::getPassStats(RenderPass pass) const
+{
+	return computeStats(m_passHistory[(int)pass]);
+}
+
+TimingStats GpuTimer::getGpuTotalStats() const
+{
+	return computeStats(m_gpuTotalHistory);
+}
+
+TimingStats GpuTimer::getCpuStats() const
+{
+	return computeStats(m_cpuHistory);
+}
+
+void GpuTimer::drawOverlay()
+{
+	ImGui::Begin("Frame Breakdown");
+
+	if (ImGui::BeginTable("passes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("GPU pass (ms)");
+		ImGui::TableSetupColumn("last");
+		ImGui::TableSetupColumn("min");
+		ImGui::TableSetupColumn("avg");
+		ImGui::TableSetupColumn("p99");
+		ImGui::TableHeadersRow();
+
+		auto row = [](const char* name, const TimingStats& stats)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::TextUnformatted(name);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.last);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.min);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.avg);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.p99);
+		};
+
+		for (int pass = 0; pass < (int)RenderPass::Count; pass++)
+		{
+			row(getPassName(RenderPass(pass)), getPassStats(RenderPass(pass)));
+		}
+		row("GPU total", getGpuTotalStats());
+		row("CPU frame", getCpuStats());
+
+		ImGui::EndTable();
+	}
+
+	// plotted straight from the rings, the offset is the oldest sample once they've wrapped
+	int offset = m_historySize == m_historyLength ? (int)m_historyHead : 0;
+	ImGui::PlotLines("CPU ms", m_cpuHistory.data(), (int)m_historySize, offset, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+	ImGui::PlotLines("GPU ms", m_gpuTotalHistory.data(), (int)m_historySize, offset, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+	ImGui::Text("Readback stalls: %u", m_stalls);
+
+	if (ImGui::Button("Export CSV"))
+	{
+		exportCSV("frame_timings.csv");
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Export JSON"))
+	{
+		exportJSON("frame_timings.json");
+	}
+
+	ImGui::End();
+}
+
+bool GpuTimer::exportCSV(const std::string& path) const
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cout << "Failed to write timings: " << path << std::endl;
+		return false;
+	}
+
+	// one row per frame in the history
+	out << "frame,cpu_ms,gpu_total_ms";
+	for (int pass = 0; pass < (int)RenderPass::Count; pass++)
+	{
+		out << "," << getPassName(RenderPass(pass)) << "_ms";
+	}
+	out << "\n";
+
+	std::vector<float> cpu = ordered(m_cpuHistory);
+	std::vector<float> gpu = ordered(m_gpuTotalHistory);
+	std::vector<std::vector<float>> passes;
+	for (const auto& history : m_passHistory)
+	{
+		passes.push_back(ordered(history));
+	}
+
+	for (unsigned int i = 0; i < m_historySize; i++)
+	{
+		out << i << "," << cpu[i] << "," << gpu[i];
+		for (const auto& pass : passes)
+		{
+			out << "," << pass[i];
+		}
+		out << "\n";
+	}
+
+	std::cout << "Wrote timings: " << path << std::endl;
+	return true;
+}
+
+void GpuTimer::writeStatsJSON(std::ostream& out, const TimingStats& stats)
+{
+	out << "{\"last\":" << stats.last << ",\"min\":" << stats.min << ",\"max\":" << stats.max << ",\"avg\":" << stats.avg
+		<< ",\"p50\":" << stats.p50 << ",\"p95\":" << stats.p95 << ",\"p99\":" << stats.p99 << "}";
+}
+
+bool GpuTimer::exportJSON(const std::string& path) const
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cout << "Failed to write timings: " << path << std::endl;
+		return false;
+	}
+
+	out << "{\n  \"frames\": " << m_historySize << ",\n  \"readback_stalls\": " << m_stalls << ",\n  \"cpu_ms\": ";
+	writeStatsJSON(out, getCpuStats());
+	out << ",\n  \"gpu_total_ms\": ";
+	writeStatsJSON(out, getGpuTotalStats());
+	out << ",\n  \"passes_ms\": {";
+	for (int pass = 0; pass < (int)RenderPass::Count; pass++)
+	{
+		out << (pass == 0 ? "\n    \"" : ",\n    \"") << getPassName(RenderPass(pass)) << "\": ";
+		writeStatsJSON(out, getPassStats(RenderPass(pass)));
+	}
+	out << "\n  }\n}\n";
+
+	std::cout << "Wrote timings: " << path << std::endl;
+	return true;
+}
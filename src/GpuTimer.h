@@ -0,0 +1,114 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "CommandList.h"
+
+// frames of queries in flight, results are read back this many frames - 1 after they were issued
+#define GPU_TIMER_FRAMES 3
+// samples kept per series for the overlay and export, unless given to the constructor
+#define GPU_TIMER_HISTORY 240
+// pass segments per frame queries are preallocated for, more still work but allocate the first time
+#define GPU_TIMER_SEGMENTS 32
+
+// summary of the history, in milliseconds
+struct TimingStats
+{
+	float last = 0.0f;
+	float min = 0.0f;
+	float max = 0.0f;
+	float avg = 0.0f;
+	float p50 = 0.0f;
+	float p95 = 0.0f;
+	float p99 = 0.0f;
+};
+
+/*
+* Times each RenderPass on the GPU with GL_TIME_ELAPSED queries
+* A pass may be begun several times in a frame (the sorted queue can interleave them), every segment gets its own
+* query and the results are summed. Queries are triple buffered (GPU_TIMER_FRAMES) across frames and read back non-blockingly,
+* if a frame's results still aren't available when its slot comes around again it is counted as a stall and waited on.
+*/
+class GpuTimer
+{
+private:
+	struct FrameQueries
+	{
+		std::vector<GLuint> queries;
+		std::vector<RenderPass> passes;
+		unsigned int used = 0;
+		bool pending = false;
+		float cpuMs = 0.0f;
+	};
+
+	FrameQueries m_frames[GPU_TIMER_FRAMES];
+	unsigned int m_frameIndex = 0;
+
+	bool m_passOpen = false;
+	RenderPass m_currentPass = RenderPass::Count;
+
+	// ring buffers of per-pass GPU time, GPU total and CPU frame time, newest at m_historyHead - 1
+	std::vector<float> m_passHistory[(int)RenderPass::Count];
+	std::vector<float> m_gpuTotalHistory;
+	std::vector<float> m_cpuHistory;
+	unsigned int m_historyLength;
+	unsigned int m_historyHead = 0;
+	unsigned int m_historySize = 0;
+
+	unsigned int m_stalls = 0;
+
+	// sorted copy of a series for computeStats(), sized up front so the overlay doesn't allocate every frame
+	mutable std::vector<float> m_scratch;
+
+	// reads back the results of a slot and appends them to the history
+	void collect(FrameQueries& frame);
+
+	// history in chronological order
+	std::vector<float> ordered(const std::vector<float>& history) const;
+
+	TimingStats computeStats(const std::vector<float>& history) const;
+
+public:
+	// historyLength is the number of frames kept, benchmarks pass their frame count so no sample is dropped
+	explicit GpuTimer(unsigned int historyLength = GPU_TIMER_HISTORY);
+	~GpuTimer();
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	// collects whichever frame's results are due, call before the first pass
+	void beginFrame();
+	// cpuMs is the CPU time of the frame, recorded next to its GPU times
+	void endFrame(float cpuMs);
+
+	// waits for and collects every frame still in flight, for when rendering is done (headless runs, benchmarks)
+	void finish();
+
+	// forgets the history and stall count, e.g. after warm-up frames, call after finish() so nothing is in flight
+	void clear();
+
+	// ends the current pass if there is one, a no-op if pass is already the current one
+	void beginPass(RenderPass pass);
+	void endPass();
+
+	static const char* getPassName(RenderPass pass);
+
+	TimingStats getPassStats(RenderPass pass) const;
+	TimingStats getGpuTotalStats() const;
+	TimingStats getCpuStats() const;
+	unsigned int getStalls() const { return m_stalls; }
+	unsigned int getFrameCount() const { return m_historySize; }
+
+	// imgui window with the per pass table and frame time graph
+	void drawOverlay();
+
+	bool exportCSV(const std::string& path) const;
+	bool exportJSON(const std::string& path) const;
+
+	// {"last":..,"min":..,...} on a single line
+	static void writeStatsJSON(std::ostream& out, const TimingStats& stats);
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define HASH_SEED 0xCBF29CE484222325ull
+
+// 64-bit content hash, 8 bytes at a time since it runs over whole files and decoded images
+// chain calls by passing the previous hash as the seed
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = HASH_SEED)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	hash ^= size * 0x9E3779B97F4A7C15ull;
+
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes + i, 8);
+		hash = (hash ^ word) * 0x100000001B3ull;
+		hash ^= hash >> 29;
+	}
+	for (; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+	}
+	return hash;
+}
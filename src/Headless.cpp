@@ -0,0 +1,124 @@
+#include "Headless.h"
+
+#include <glad/glad.h>
+
+#include <cmath>
+#include <iostream>
+
+#include "HeadlessContext.h"
+#include "Framebuffer.h"
+#include "Timeline.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "GpuTimer.h"
+#include "GLErrors.h"
+#include "ShaderCache.h"
+#include "Profiler.h"
+#include "StartupTimeline.h"
+#include "AllocationTracker.h"
+
+int runHeadless(const AppOptions& options)
+{
+	HeadlessContext context;
+	{
+		STARTUP_PHASE("HeadlessContext::create");
+		if (!context.create())
+		{
+			return -1;
+		}
+	}
+
+	{
+		STARTUP_PHASE("GL extensions");
+		initGLDebugOutput(context.getLoader(), options.glDebugSynchronous, options.glGetErrorChecks);
+		initShaderCompile(context.getLoader());
+	}
+
+	Timeline timeline;
+	if (!options.timelinePath.empty() && !timeline.load(options.timelinePath))
+	{
+		return -1;
+	}
+
+	// a timeline runs to its end unless a frame count was given explicitly
+	int frames = options.frames;
+	if (!timeline.empty() && !options.framesGiven)
+	{
+		frames = int(std::ceil(timeline.getDuration() * options.fps)) + 1;
+	}
+
+	Framebuffer framebuffer(options.width, options.height);
+	Camera camera(options.width, options.height, 45.f, 0.1f, 10000.f, CAMERA_START_POSITION, CAMERA_START_ORIENTATION);
+
+	Scene scene{ getSceneDirectories(options), options.populationBudget };
+	// recorded frames are of the finished scene, not of its placeholders, unless the start itself is what's looked at
+	if (!options.stream)
+	{
+		scene.finishLoading();
+	}
+	GpuTimer gpuTimer;
+
+	// simulated time advances by a fixed step per frame, so runs are reproducible whatever the frame rate
+	const double step = 1.0 / options.fps;
+	uint64_t runStart = Profiler::now();
+
+	SteadyStateAllocations sceneAllocations(options.checkAllocations);
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		PROFILE_ZONE("Frame");
+		uint64_t frameStart = Profiler::now();
+
+		gpuTimer.beginFrame();
+
+		if (!timeline.empty())
+		{
+			timeline.sample(float(frame * step), camera.m_position, camera.m_orientation);
+		}
+
+		framebuffer.bind();
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		sceneAllocations.begin(scene.getAllocationCount());
+		scene.update(step * daysPerSecond);
+		scene.render(camera, &gpuTimer);
+		sceneAllocations.end(scene.getAllocationCount(), scene.isLoading());
+
+		// nothing is swapped, the first frame is out once the GPU is done with it
+		if (frame == 0)
+		{
+			glFinish();
+		}
+		scene.framePresented();
+
+		gpuTimer.endFrame(float((Profiler::now() - frameStart) / 1.0e6));
+	}
+
+	glFinish();
+	gpuTimer.finish();
+	double totalMs = (Profiler::now() - runStart) / 1.0e6;
+
+	TimingStats cpu = gpuTimer.getCpuStats();
+	TimingStats gpu = gpuTimer.getGpuTotalStats();
+	std::cout << "Rendered " << frames << " frames at " << options.width << "x" << options.height
+		<< " in " << totalMs << " ms\n"
+		<< "  cpu ms/frame avg " << cpu.avg << " p99 " << cpu.p99 << "\n"
+		<< "  gpu ms/frame avg " << gpu.avg << " p99 " << gpu.p99 << "\n"
+		<< "  steady state frames that allocated " << sceneAllocations.getViolations() << std::endl;
+
+	if (!options.outputPath.empty())
+	{
+		framebuffer.writePPM(options.outputPath);
+	}
+	if (!options.timingsPath.empty())
+	{
+		gpuTimer.exportJSON(options.timingsPath);
+	}
+	if (options.profile)
+	{
+		Profiler::writeChromeTrace(options.tracePath);
+	}
+
+	return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "CommandLine.h"
+
+// renders the scene into an offscreen framebuffer without a window or ImGui, for batch renders and performance
+// runs on CPU only machines through Mesa llvmpipe, returns the process exit code
+int runHeadless(const AppOptions& options);
@@ -0,0 +1,167 @@
+#include "HeadlessContext.h"
+
+#ifdef USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#endif
+
+HeadlessContext::~HeadlessContext()
+{
+#ifdef USE_EGL
+	if (m_eglContext != nullptr)
+	{
+		eglMakeCurrent((EGLDisplay)m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext((EGLDisplay)m_eglDisplay, (EGLContext)m_eglContext);
+		eglTerminate((EGLDisplay)m_eglDisplay);
+	}
+#endif
+
+	if (m_window != nullptr)
+	{
+		glfwDestroyWindow(m_window);
+		glfwTerminate();
+	}
+}
+
+bool HeadlessContext::create()
+{
+	if (createEGL() || createGLFW())
+	{
+		std::cout << "Headless context: " << getBackendName() << ", " << glGetString(GL_RENDERER) << std::endl;
+		return true;
+	}
+
+	std::cout << "Failed to create a headless GL context" << std::endl;
+	return false;
+}
+
+bool HeadlessContext::createEGL()
+{
+#ifdef USE_EGL
+	EGLDisplay display = EGL_NO_DISPLAY;
+
+	// prefer Mesa's surfaceless platform, it needs neither X11 nor a GPU
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay != nullptr)
+	{
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		return false;
+	}
+
+	// no surface is ever created, everything renders into an FBO
+	const EGLint configAttribs[] =
+	{
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config = EGL_NO_CONFIG_KHR;
+	EGLint numConfigs = 0;
+	if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, configAttribs, &config, 1, &numConfigs))
+	{
+		eglTerminate(display);
+		return false;
+	}
+
+	// Mesa's surfaceless platform lists no GL configs at all, a context without one is fine as nothing is ever bound
+	const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+	if (numConfigs == 0 && (extensions == nullptr || strstr(extensions, "EGL_KHR_no_config_context") == nullptr))
+	{
+		eglTerminate(display);
+		return false;
+	}
+	if (numConfigs == 0)
+	{
+		config = EGL_NO_CONFIG_KHR;
+	}
+
+	const EGLint contextAttribs[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifndef NDEBUG
+		EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		if (context != EGL_NO_CONTEXT)
+		{
+			eglDestroyContext(display, context);
+		}
+		eglTerminate(display);
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+		eglTerminate(display);
+		return false;
+	}
+
+	m_eglDisplay = display;
+	m_eglContext = context;
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool HeadlessContext::createGLFW()
+{
+	if (!glfwInit())
+	{
+		return false;
+	}
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifndef NDEBUG
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	// size doesn't matter, the default framebuffer is never drawn to
+	m_window = glfwCreateWindow(64, 64, "Solar System Model (headless)", nullptr, nullptr);
+	if (m_window == nullptr)
+	{
+		glfwTerminate();
+		return false;
+	}
+
+	glfwMakeContextCurrent(m_window);
+	gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+	return true;
+}
+
+const char* HeadlessContext::getBackendName() const
+{
+	return m_eglContext != nullptr ? "egl" : "glfw";
+}
+
+GLADloadproc HeadlessContext::getLoader() const
+{
+#ifdef USE_EGL
+	if (m_eglContext != nullptr)
+	{
+		return (GLADloadproc)eglGetProcAddress;
+	}
+#endif
+	return (GLADloadproc)glfwGetProcAddress;
+}
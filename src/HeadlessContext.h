@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+// EGL is the default everywhere but Windows, whose drivers don't offer desktop GL through it; those builds link libEGL
+// (-lEGL), NO_EGL leaves it out
+#if !defined(USE_EGL) && !defined(NO_EGL) && !defined(_WIN32)
+#define USE_EGL
+#endif
+
+/*
+* GL 3.3 core context without a visible window, for batch renders and benchmarks
+* Built with USE_EGL it first tries a surfaceless EGL context, which works on headless Linux nodes (Mesa llvmpipe
+* included) with no display server at all. Otherwise, or if EGL fails, it falls back to a hidden GLFW window.
+* Either way nothing is presented, rendering goes into a Framebuffer.
+*/
+class HeadlessContext
+{
+private:
+	// EGL objects, kept as void* so this header doesn't need the EGL headers
+	void* m_eglDisplay = nullptr;
+	void* m_eglContext = nullptr;
+
+	GLFWwindow* m_window = nullptr;
+
+	bool createEGL();
+	bool createGLFW();
+
+public:
+	~HeadlessContext();
+
+	// creates the context and makes it current, then loads GL through glad
+	bool create();
+
+	// "egl" or "glfw"
+	const char* getBackendName() const;
+
+	// to load extension entry points glad doesn't know about
+	GLADloadproc getLoader() const;
+};
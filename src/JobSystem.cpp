@@ -0,0 +1,107 @@
+#include "JobSystem.h"
+
+#include <string>
+
+#include "Profiler.h"
+#include "AllocationTracker.h"
+
+JobSystem::JobSystem(unsigned int numWorkers)
+{
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	if (numWorkers == 0)
+	{
+		numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	m_callerParticipates = hardwareThreads < MIN_THREADS_FOR_SUBMIT_ONLY;
+
+	// workers take slots [0, numWorkers), the calling thread takes the last slot
+	for (unsigned int i = 0; i < numWorkers; i++)
+	{
+		m_threads.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void JobSystem::parallelFor(unsigned int count, JobFunction function, void* context)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_function = function;
+		m_context = context;
+		m_count = count;
+		m_next = 0;
+		m_active = (unsigned int)m_threads.size();
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	if (m_callerParticipates)
+	{
+		runJobs(getNumSlots() - 1);
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this] { return m_active == 0; });
+}
+
+void JobSystem::workerLoop(unsigned int slot)
+{
+	unsigned long long seenGeneration = 0;
+
+	std::string threadName = "Worker " + std::to_string(slot);
+	Profiler::setThreadName(threadName.c_str());
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_quit || m_generation != seenGeneration; });
+			if (m_quit)
+			{
+				return;
+			}
+			seenGeneration = m_generation;
+		}
+
+		{
+			PROFILE_ZONE("Jobs");
+			uint64_t allocations = AllocationTracker::getThreadCount();
+			runJobs(slot);
+			m_allocations.fetch_add(AllocationTracker::getThreadCount() - allocations, std::memory_order_relaxed);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_active--;
+		}
+		m_done.notify_one();
+	}
+}
+
+void JobSystem::runJobs(unsigned int slot)
+{
+	unsigned int index;
+	while ((index = m_next.fetch_add(1)) < m_count)
+	{
+		m_function(m_context, index, slot);
+	}
+}
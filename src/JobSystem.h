@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+// machines with at least this many hardware threads keep the calling thread out of parallelFor,
+// so the GL thread only ever does submission
+#define MIN_THREADS_FOR_SUBMIT_ONLY 8
+
+// small pool of worker threads running index based parallel loops
+// jobs are a plain function pointer + context so dispatching a frame's work never allocates
+class JobSystem
+{
+public:
+	// index is the loop index, slot identifies the thread running it, in [0, getNumSlots())
+	typedef void (*JobFunction)(void* context, unsigned int index, unsigned int slot);
+
+private:
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+
+	// the loop currently being run
+	JobFunction m_function = nullptr;
+	void* m_context = nullptr;
+	unsigned int m_count = 0;
+	std::atomic<unsigned int> m_next{ 0 };
+
+	// bumped for every parallelFor so sleeping workers know there is new work
+	unsigned long long m_generation = 0;
+	// workers that haven't finished the current loop yet
+	unsigned int m_active = 0;
+	bool m_quit = false;
+
+	bool m_callerParticipates;
+
+	// heap allocations the workers made running jobs, the calling thread counts its own
+	std::atomic<uint64_t> m_allocations{ 0 };
+
+	void workerLoop(unsigned int slot);
+
+	// grabs indices until the loop is exhausted
+	void runJobs(unsigned int slot);
+
+public:
+	// numWorkers of 0 picks one less than the number of hardware threads
+	explicit JobSystem(unsigned int numWorkers = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// runs function(context, i, slot) for every i in [0, count), returns once all of them are done
+	void parallelFor(unsigned int count, JobFunction function, void* context);
+
+	unsigned int getNumWorkers() const { return (unsigned int)m_threads.size(); }
+
+	// number of distinct slot values a job can see, for sizing per-thread data
+	unsigned int getNumSlots() const { return getNumWorkers() + 1; }
+
+	bool callerParticipates() const { return m_callerParticipates; }
+
+	// allocations made by the workers in jobs since construction, see AllocationTracker
+	uint64_t getAllocationCount() const { return m_allocations.load(std::memory_order_relaxed); }
+};
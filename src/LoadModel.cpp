@@ -1,88 +1,88 @@
 #include "LoadModel.h"
 
-// keep track of directory to find other files associated with .obj file
-static std::string directory;
+#include <cmath>
 
-void loadSolarSystemModels(std::string directory, std::vector<std::unique_ptr<Mesh>>& meshes)
+#include <glm/gtc/constants.hpp>
+
+#include "AssetLoader.h"
+#include "MeshCache.h"
+#include "Profiler.h"
+#include "StartupTimeline.h"
+
+// loads a texture named by a model's material, path relative to the model's directory (which ends in '/')
+static Texture loadModelTexture(ResourceRegistry& resources, const std::string& directory, const std::string& path);
+
+// the model loaded by assets if it has it, otherwise loaded into model, nullptr if it fails to load
+static const ModelData* getModelData(const std::string& path, const AssetLoader* assets, ModelData& model)
 {
-    // loads planet models
-    std::string modelPaths[15] =
+    const ModelData* loaded = assets != nullptr ? assets->getModel(path) : nullptr;
+    if (loaded == nullptr && model.load(path))
     {
-        directory + "sun.obj",
-        directory + "mercury.obj",
-        directory + "venus.obj",
-        directory + "earth.obj",
-        directory + "mars.obj",
-        directory + "jupiter.obj",
-        directory + "saturn.obj",
-        directory + "uranus.obj",
-        directory + "neptune.obj",
-        directory + "moon.obj",
-        directory + "titan.obj",
-        directory + "io.obj",
-        directory + "europa.obj",
-        directory + "ganymede.obj",
-        directory + "callisto.obj"
-    };
-
-    for (std::string modelPath : modelPaths)
-    {
-        loadModel(modelPath, meshes);
+        loaded = &model;
     }
+    return loaded;
 }
 
-std::unique_ptr<Mesh> loadAsteroidModel(std::string directory, const int number, std::vector<glm::mat4> instanceMatrix)
+std::unique_ptr<Mesh> loadAsteroidModel(ResourceRegistry& resources, const std::string& directory, const int number,
+    const std::vector<glm::mat4>& instanceMatrix, const AssetLoader* assets)
 {
-    std::vector<std::unique_ptr<Mesh>> meshes;
+    STARTUP_ASSET("loadAsteroidModel", directory + "asteroid.obj");
 
-    loadModel(directory + "asteroid.obj", meshes);
-    auto asteroidMesh = std::make_unique<Mesh>(std::move(meshes[0]), number, instanceMatrix);
+    ModelData data;
+    const ModelData* model = getModelData(directory + "asteroid.obj", assets, data);
+    if (model == nullptr || model->getMeshes().empty())
+    {
+        return nullptr;
+    }
 
-    return asteroidMesh;
+    return std::make_unique<Mesh>(resources, model->getMeshes()[0], loadModelTexture(resources, directory, model->getTexture(0)), number, instanceMatrix);
 }
 
 
 // main routine that will load meshes into a vector of unique pointers used to return the models
-void loadModel(std::string path, std::vector<std::unique_ptr<Mesh>>& meshes)
+void loadModel(const std::string& path, ResourceRegistry& resources, std::vector<std::unique_ptr<Mesh>>& meshes,
+    const AssetLoader* assets)
 {
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+    PROFILE_ZONE("loadModel");
+    STARTUP_ASSET("loadModel", path);
 
-    if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    // mapped from the mesh cache unless the .obj/.mtl changed since it was written
+    ModelData data;
+    const ModelData* model = getModelData(path, assets, data);
+    if (model == nullptr)
     {
-        std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
         return;
     }
 
-    // set static variable
-    directory = path.substr(0, path.find_last_of('/'));
+    // keep track of directory to find other files associated with .obj file
+    std::string directory = path.substr(0, path.find_last_of('/') + 1);
 
-    // starts recursion that will iterate through all the nodes in the scene
-    processNode(scene->mRootNode, scene, meshes);
+    // the arrays go into the arena straight from the mapping unless an identical mesh is there already, the model is
+    // unmapped once the meshes are built
+    for (size_t i = 0; i < model->getMeshes().size(); i++)
+    {
+        meshes.push_back(std::make_unique<Mesh>(resources, model->getMeshes()[i], loadModelTexture(resources, directory, model->getTexture(i))));
+    }
 }
 
-// iterates through aiNodes in tree structure of aiScene defined by assimp which is used to load scenes
-static void processNode(aiNode* node, const aiScene* scene, std::vector<std::unique_ptr<Mesh>>& meshes)
+// loads the texture defined by the material
+static Texture loadModelTexture(ResourceRegistry& resources, const std::string& directory, const std::string& path)
 {
-    // processes meshes in the node
-    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(std::move(processMesh(mesh, scene)));
-    }
+    Texture texture;
+    texture.path = path;
 
-    // processes children nodes in tree structure
-    for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene, meshes);
-    }
+    // gets the ID, the texture is only decoded and sent to the GPU if no other model used the file or its pixels yet
+    texture.ID = resources.acquireTexture(directory + texture.path);
+
+    return texture;
 }
 
-// processes each of the aiMesh in the nodes and converts them into mesh class defined in Mesh.h
-// Note: these two mesh classes are different!
-static std::unique_ptr<Mesh> processMesh(aiMesh* mesh, const aiScene* scene)
+// copies the vertex and index data of an aiMesh into the layout used by Mesh
+void extractMeshData(const aiMesh* mesh, std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
 {
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-    Texture texture; // there will only be 1 texture (only diffuse map) for simplicity
+    // the meshes are triangulated on import
+    vertices.reserve(vertices.size() + mesh->mNumVertices);
+    indices.reserve(indices.size() + 3 * mesh->mNumFaces);
 
     // vertex data
     for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -111,43 +111,21 @@ static std::unique_ptr<Mesh> processMesh(aiMesh* mesh, const aiScene* scene)
     // index data, found within faces
     for (unsigned int i = 0; i < mesh->mNumFaces; i++)
     {
-        aiFace face = mesh->mFaces[i];
+        const aiFace& face = mesh->mFaces[i];
         for (GLuint j = 0; j < face.mNumIndices; j++)
         {
             indices.push_back(face.mIndices[j]);
         }
     }
-
-    // material data to get texture
-    if (mesh->mMaterialIndex >= 0)
-    {
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        texture = loadMaterialTexture(material, aiTextureType_DIFFUSE);
-    }
-    return std::make_unique<Mesh>(vertices, indices, texture);
-}
-
-// loads the texture defined by the material
-static Texture loadMaterialTexture(aiMaterial* mat, aiTextureType type)
-{
-    Texture texture;
-    aiString textureFilename;
-
-    // gets the name of the texture file defined in '.mat' file
-    mat->GetTexture(type, 0, &textureFilename);
-
-    texture.path = std::string(textureFilename.C_Str());
-
-    // gets the ID, loads the texture, sets up config and sends texture to GPU
-    texture.ID = TextureFromFile(directory + '/' + texture.path);
-
-    return texture;
 }
 
 // performs actual loading of the texture file using stb_image
 // sets up config and sends texture data to the GPU
-static unsigned int TextureFromFile(std::string texturePath)
+unsigned int TextureFromFile(const std::string& texturePath)
 {
+    PROFILE_ZONE("TextureFromFile");
+    STARTUP_ASSET("TextureFromFile", texturePath);
+
     int widthImg, heightImg, numCh;
     unsigned char* bytes;
     unsigned int textureID;
@@ -156,7 +134,25 @@ static unsigned int TextureFromFile(std::string texturePath)
     stbi_set_flip_vertically_on_load(false);
 
     // read image data
-    bytes = stbi_load(texturePath.c_str(), &widthImg, &heightImg, &numCh, 0);
+    {
+        PROFILE_ZONE("stbi_load");
+        StartupTimeline::addFileRead(texturePath);
+        bytes = stbi_load(texturePath.c_str(), &widthImg, &heightImg, &numCh, 0);
+    }
+
+    textureID = uploadTexture(bytes, widthImg, heightImg);
+
+    stbi_image_free(bytes);
+
+    return textureID;
+}
+
+// sends decoded texture data to the GPU with mipmaps, repeat wrapping and trilinear filtering
+unsigned int uploadTexture(const unsigned char* bytes, int width, int height, PixelUploadRing* ring, size_t size)
+{
+    PROFILE_ZONE("uploadTexture");
+
+    unsigned int textureID;
 
     // generates the OpenGL texture object
     GLCall(glGenTextures(1, &textureID));
@@ -166,15 +162,77 @@ static unsigned int TextureFromFile(std::string texturePath)
 
     // puts texture into openGL format to use, some config
     GLCall(glBindTexture(GL_TEXTURE_2D, textureID));
-    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, widthImg, heightImg, 0, GL_RGB, GL_UNSIGNED_BYTE, bytes));
-    GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+    if (ring != nullptr)
+    {
+        ring->texImage2D(GL_TEXTURE_2D, width, height, bytes, size);
+    }
+    else
+    {
+        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, bytes));
+        StartupTimeline::addBytesUploaded(uint64_t(width) * height * 3);
+    }
+    {
+        STARTUP_PHASE("glGenerateMipmap");
+        GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+    }
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
     GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
     GLCall(glBindTexture(GL_TEXTURE_2D, 0));
 
-    stbi_image_free(bytes);
-
     return textureID;
 }
+
+// UV sphere with a flat grey texture, stands in for a model that hasn't streamed in yet
+std::unique_ptr<Mesh> makePlaceholderSphere(ResourceRegistry& resources)
+{
+    PROFILE_ZONE("makePlaceholderSphere");
+    STARTUP_PHASE("makePlaceholderSphere");
+
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    vertices.reserve((PLACEHOLDER_STACKS + 1) * (PLACEHOLDER_SLICES + 1));
+    indices.reserve(PLACEHOLDER_STACKS * PLACEHOLDER_SLICES * 6);
+
+    // a seam of duplicated vertices so the uvs wrap
+    for (int stack = 0; stack <= PLACEHOLDER_STACKS; stack++)
+    {
+        float polar = glm::pi<float>() * float(stack) / PLACEHOLDER_STACKS;
+        for (int slice = 0; slice <= PLACEHOLDER_SLICES; slice++)
+        {
+            float azimuth = 2.0f * glm::pi<float>() * float(slice) / PLACEHOLDER_SLICES;
+
+            Vertex vertex;
+            vertex.Normal = glm::vec3(std::sin(polar) * std::cos(azimuth), std::cos(polar), std::sin(polar) * std::sin(azimuth));
+            vertex.Position = vertex.Normal * PLACEHOLDER_RADIUS;
+            vertex.TexCoor = glm::vec2(float(slice) / PLACEHOLDER_SLICES, float(stack) / PLACEHOLDER_STACKS);
+            vertices.push_back(vertex);
+        }
+    }
+
+    // counter-clockwise seen from outside
+    for (int stack = 0; stack < PLACEHOLDER_STACKS; stack++)
+    {
+        for (int slice = 0; slice < PLACEHOLDER_SLICES; slice++)
+        {
+            GLuint first = GLuint(stack * (PLACEHOLDER_SLICES + 1) + slice);
+            GLuint below = first + PLACEHOLDER_SLICES + 1;
+            indices.insert(indices.end(), { first, first + 1, below, first + 1, below + 1, below });
+        }
+    }
+
+    MeshData data;
+    data.vertices = vertices.data();
+    data.vertexCount = (uint32_t)vertices.size();
+    data.indices = indices.data();
+    data.indexCount = (uint32_t)indices.size();
+
+    // shared by every placeholder through the registry like any other texture, 4 bytes for GL's row alignment
+    const unsigned char grey[4] = { 128, 128, 128, 0 };
+    Texture texture;
+    texture.path = "placeholder";
+    texture.ID = resources.acquireTexture(texture.path, grey, 1, 1, 3);
+
+    return std::make_unique<Mesh>(resources, data, texture);
+}
@@ -17,26 +17,37 @@
 
 #include "mesh.h"
 #include "GLErrors.h"
+#include "PixelUploadRing.h"
 
-// loads sun, planets, and satellites
-void loadSolarSystemModels(std::string directory, std::vector<std::unique_ptr<Mesh>>& meshes);
+class AssetLoader;
 
-// loads the asteroid model to use for asteroid belt
-std::unique_ptr<Mesh> loadAsteroidModel(std::string directory, const int number, std::vector<glm::mat4> instanceMatrix);
+// placeholder sphere, the size of the shipped planet models so bodies drawn with it keep their size
+#define PLACEHOLDER_RADIUS 2.5f
+#define PLACEHOLDER_STACKS 16
+#define PLACEHOLDER_SLICES 32
 
-// main routine that will load meshes into a vector of unique pointers used to return the models
-void loadModel(std::string path, std::vector<std::unique_ptr<Mesh>>& meshes);
+// loads the asteroid model to use for asteroid belt, its geometry and texture are shared through the registry
+// taken from assets if it was loaded there
+std::unique_ptr<Mesh> loadAsteroidModel(ResourceRegistry& resources, const std::string& directory, const int number,
+    const std::vector<glm::mat4>& instanceMatrix, const AssetLoader* assets = nullptr);
 
-// iterates through aiNodes in tree structure of aiScene defined by assimp which is used to load scenes
-static void processNode(aiNode* node, const aiScene* scene, std::vector<std::unique_ptr<Mesh>>& meshes);
+// main routine that will load meshes into a vector of unique pointers used to return the models
+// their geometry and textures are shared through the registry, which has to outlive them
+// the model is taken from assets if it was loaded there, otherwise loaded here
+void loadModel(const std::string& path, ResourceRegistry& resources, std::vector<std::unique_ptr<Mesh>>& meshes,
+    const AssetLoader* assets = nullptr);
 
-// processes each of the aiMesh in the nodes and converts them into mesh class defined in Mesh.h
-// Note: these two mesh classes are different
-static std::unique_ptr<Mesh> processMesh(aiMesh* mesh, const aiScene* scene);
+// sphere drawn in place of a model until it's loaded, every one made shares its geometry and texture through the
+// registry
+std::unique_ptr<Mesh> makePlaceholderSphere(ResourceRegistry& resources);
 
-// loads the texture defined by the material
-static Texture loadMaterialTexture(aiMaterial* mat, aiTextureType type);
+// the CPU side of an import, copies positions/normals/uv and face indices out of the aiMesh, no GL or file access
+void extractMeshData(const aiMesh* mesh, std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
 
 // performs actual loading of the texture file using stb_image
 // sets up config and sends texture data to the GPU
-static unsigned int TextureFromFile(std::string texturePath);
\ No newline at end of file
+unsigned int TextureFromFile(const std::string& texturePath);
+
+// uploads decoded 8-bit RGB pixels as a mipmapped 2D texture, what TextureFromFile() does after decoding
+// through the ring if one is given, size is then how many bytes the pixels take up
+unsigned int uploadTexture(const unsigned char* bytes, int width, int height, PixelUploadRing* ring = nullptr, size_t size = 0);
@@ -11,40 +11,32 @@
 #include <math.h>
 #include <iostream>
 
-#include "Mesh.h"
-#include "Shader.h"
-#include "LoadModel.h"
-#include "StellarObject.h"
 #include "Camera.h"
-#include "Skybox.h"
 #include "GLErrors.h"
+#include "ShaderCache.h"
 #include "GUIParams.h"
-#include "OrbitalEllipse.h"
+#include "Scene.h"
+#include "CommandLine.h"
+#include "Profiler.h"
+#include "GpuTimer.h"
+#include "Headless.h"
+#include "Benchmark.h"
+#include "Microbench.h"
+#include "AllocationTracker.h"
+#include "AssetArchive.h"
+#include "BodyCatalog.h"
+#include "MinorPlanets.h"
+#include "Population.h"
+#include "StartupTimeline.h"
 
 // window size
 #define WIDTH 1500
 #define HEIGHT 800
 
-// rng to generate number between -1 and 1
-float randfloat()
-{
-	return -1.0f + (rand() / (RAND_MAX / 2.0f));
-}
-
-// rng to generate number between -1 to -0.3 or 0.3 to 1
-float randscale()
-{
-	return (0.3f + (rand() / RAND_MAX * 0.7f)) * ((rand() % 2) * 2 - 1);
-}
-
-// generates model matrices for random asteroids
-std::vector<glm::mat4> genAsteroidModels(const unsigned int numberAsteroids, double radius, double radiusDeviation);
-
 // must create as global, due to having to use callback for scroll wheel which only takes function pointer
 // (as oppposed to class function pointer)
 // it was between a global or a singleton, they're both bad... I guess I'd rather a global than a singleton xD
-Camera camera(WIDTH, HEIGHT, 45.f, 0.1f, 10000.f, glm::vec3(215.658, 141.441, 1122.28),
-	glm::vec3(-0.382241, -0.26202, -0.886138));
+Camera camera(WIDTH, HEIGHT, 45.f, 0.1f, 10000.f, CAMERA_START_POSITION, CAMERA_START_ORIENTATION);
 
 // globals in GUIParams.h
 float daysPerSecond = 0.2f;
@@ -53,16 +45,89 @@ bool enableRotationalMotion = true;
 bool enableOrbitalPath = false;
 int movementSensitivity = 0;
 
-int main()
+int main(int argc, char* argv[])
 {
-	glfwInit();
+	AppOptions options;
+	if (!parseCommandLine(argc, argv, options))
+	{
+		return -1;
+	}
+
+	Profiler::setThreadName("Main");
+	Profiler::setEnabled(options.profile);
+
+	if (!options.compileCatalogInput.empty())
+	{
+		return compileCatalog(options.compileCatalogInput, options.compileCatalogOutput) ? 0 : -1;
+	}
+	if (!options.ingestInput.empty())
+	{
+		JobSystem jobs;
+		IngestStats stats;
+		if (!ingestMinorPlanets(options.ingestInput, options.ingestOutput, jobs, stats))
+		{
+			return -1;
+		}
+		printIngestStats(stats);
+		return 0;
+	}
+	if (options.synthesizeCount > 0)
+	{
+		return synthesizeMinorPlanets(options.synthesizeCount, options.synthesizeOutput) ? 0 : -1;
+	}
+	if (!options.pageInput.empty())
+	{
+		MinorPlanetCatalog minorPlanets;
+		return minorPlanets.load(options.pageInput) && buildPopulationPages(minorPlanets, options.pageOutput) ? 0 : -1;
+	}
+	if (!options.packOutput.empty())
+	{
+		return packAssets(getSceneDirectories(options), options.packOutput) ? 0 : -1;
+	}
+	if (options.microbench)
+	{
+		return runMicrobenchmarks(options);
+	}
+
+	// the scene ends it once it's at full quality and has presented a frame
+	StartupTimeline::begin(options.startupTimelinePath);
+
+	// from here on every loader looks in the archive first and only reads loose files for what it doesn't have
+	{
+		STARTUP_PHASE("Mount archive");
+		if (!options.archivePath.empty() && !AssetArchive::mount(options.archivePath))
+		{
+			return -1;
+		}
+	}
+	if (options.benchmark)
+	{
+		return runBenchmark(options);
+	}
+	if (options.headless)
+	{
+		return runHeadless(options);
+	}
+
+	{
+		STARTUP_PHASE("glfwInit");
+		glfwInit();
+	}
 
 	// modernOpenGL is 3.3+
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifndef NDEBUG
+	// lets the driver report errors through KHR_debug instead of glGetError() after every call
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
 
-	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Solar System Model", nullptr, nullptr);
+	GLFWwindow* window;
+	{
+		STARTUP_PHASE("glfwCreateWindow");
+		window = glfwCreateWindow(WIDTH, HEIGHT, "Solar System Model", nullptr, nullptr);
+	}
 	
 	if (window == nullptr)
 	{
@@ -73,44 +138,25 @@ int main()
 	glfwMakeContextCurrent(window);
 
 	// GLAD -> loads implementation from GPU provided by manufacturer, ie. Intel, AMD
-	gladLoadGL();
-
-	glViewport(0, 0, WIDTH, HEIGHT);
-
-	// light information
-	glm::vec3 lightPosition(0.0f, 0.0f, 0.0f);
-	glm::vec4 lightColor(1.0f, 1.0f, 1.0f, 1.0f);
-
-	// load and link shaders
-	GLCall(Shader defaultShader("./src/shaders/default.vert", "./src/shaders/default.frag")); // planets/satellites
-	GLCall(Shader skyboxShader("./src/shaders/skybox.vert", "./src/shaders/skybox.frag")); // background
-	GLCall(Shader lightSourceShader("./src/shaders/lightSource.vert", "./src/shaders/lightSource.frag")); // the sun
-	GLCall(Shader asteroidShader("./src/shaders/asteroid.vert", "./src/shaders/asteroid.frag")); // asteroid belt
-	GLCall(Shader orbitShader("./src/shaders/orbit.vert", "./src/shaders/orbit.frag")); // orbit trajectory
-	
-	glUniform3f(glGetUniformLocation(asteroidShader.m_ID, "lightColor"),
-		lightColor.x, lightColor.y, lightColor.z);
-	glUniform3f(glGetUniformLocation(asteroidShader.m_ID, "lightPosition"),
-		lightPosition.x, lightPosition.y, lightPosition.z);
+	{
+		STARTUP_PHASE("gladLoadGL");
+		gladLoadGL();
+	}
 
-	// generated randomized asteroids for asteroid belt, instancing enabled
-	const unsigned int numberAsteroids = 500;
-	float radius = 530.0f;
-	float radiusDeviation = 40.0f;
+	{
+		STARTUP_PHASE("GL extensions");
+		initGLDebugOutput((GLADloadproc)glfwGetProcAddress, options.glDebugSynchronous, options.glGetErrorChecks);
+		initShaderCompile((GLADloadproc)glfwGetProcAddress);
+	}
 
-	auto instanceMatrix = genAsteroidModels(numberAsteroids, radius, radiusDeviation);
-	auto asteroid = loadAsteroidModel("./resources/models/", numberAsteroids, instanceMatrix);
+	glViewport(0, 0, WIDTH, HEIGHT);
 
-	// load sun/planets/satellites
-	std::vector<std::unique_ptr<Mesh>> meshes;
-	loadSolarSystemModels("./resources/models/", meshes);
-	std::vector<StellarObject> stellarObjects = initStellarObjects(meshes);
+	// shaders, sun/planets/satellites, asteroid belt and skybox
+	Scene scene{ getSceneDirectories(options), options.populationBudget };
 
 	// will track real time
 	double prevTime = glfwGetTime();
 	double curTime;
-	
-	Skybox skybox("./resources/milky_way_skybox/");
 
 	// enable zooming through scroll on mouse
 	// glfwSetScrollCallback(window, scrollCallback);
@@ -120,20 +166,54 @@ int main()
 		);
 
 	// setup Dear ImGui context
-	IMGUI_CHECKVERSION();
-	ImGui::CreateContext();
-	ImGuiIO& io = ImGui::GetIO();
-	// setup Platform/Renderer bindings
-	ImGui_ImplGlfw_InitForOpenGL(window, true);
-	ImGui_ImplOpenGL3_Init("#version 330 core");
-	ImGui::StyleColorsDark();
+	{
+		STARTUP_PHASE("ImGui setup");
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+		// setup Platform/Renderer bindings
+		ImGui_ImplGlfw_InitForOpenGL(window, true);
+		ImGui_ImplOpenGL3_Init("#version 330 core");
+		ImGui::StyleColorsDark();
+	}
+
+	// set from the gui, the trace is written between frames
+	bool profilerEnabled = options.profile;
+	bool dumpTrace = false;
 
-	// necessary so depth in 3D models rendered properly
-	glEnable(GL_DEPTH_TEST);
+	// per pass GPU times, shown in the frame breakdown overlay
+	GpuTimer gpuTimer;
+	bool showFrameBreakdown = false;
+	bool showPopulation = false;
+	bool showStartupTimeline = false;
+	uint64_t lastFrameStart = Profiler::now();
+
+	// heap allocations of the simulate/record/submit part of the frame (checked with --check-allocations),
+	// and of the whole frame including imgui and the swap
+	SteadyStateAllocations sceneAllocations(options.checkAllocations);
+	uint64_t lastFrameAllocations = AllocationTracker::getCount();
 
 	// MAIN LOOP //
 	while (!glfwWindowShouldClose(window))
 	{
+		if (dumpTrace)
+		{
+			Profiler::writeChromeTrace(options.tracePath);
+			dumpTrace = false;
+		}
+
+		PROFILE_ZONE("Frame");
+
+		// frame time is start to start, so it covers the swap of the previous frame as well
+		uint64_t frameStart = Profiler::now();
+		float frameMs = float((frameStart - lastFrameStart) / 1.0e6);
+		lastFrameStart = frameStart;
+
+		uint64_t frameAllocationCount = AllocationTracker::getCount();
+		unsigned int frameAllocations = (unsigned int)(frameAllocationCount - lastFrameAllocations);
+		lastFrameAllocations = frameAllocationCount;
+
+		gpuTimer.beginFrame();
+
 		// background
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -143,137 +223,105 @@ int main()
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
 
+		sceneAllocations.begin(scene.getAllocationCount());
+
 		// update orbital/rotational positions
 		curTime = glfwGetTime();
 		if (curTime - prevTime >= 1 / 60)
 		{
 			double realTimeElapsed = curTime - prevTime;
 			prevTime = curTime;
-			
-			if (enableRotationalMotion)
-			{
-				for (auto& stellarObject : stellarObjects)
-				{
-					stellarObject.updateRotation(realTimeElapsed * daysPerSecond);
-				}
-			}
 
-			if (enableOrbitalMotion)
-			{
-				for (auto& stellarObject : stellarObjects)
-				{
-					if (stellarObject.m_name != "sun")
-						stellarObject.updatePosition(realTimeElapsed * daysPerSecond);
-				}
-			}
+			scene.update(realTimeElapsed * daysPerSecond);
 		}
 
-		// update camera
-		camera.getInputs(window);
-		camera.exportToShader(defaultShader, "camMatrix");
-		camera.exportToShader(lightSourceShader, "camMatrix");
-		camera.exportToShader(asteroidShader, "camMatrix");
-		camera.exportToShader(orbitShader, "camMatrix");
+		{
+			PROFILE_ZONE("Input");
+			camera.getInputs(window);
+		}
 
-		// draw the sun, planets, satellites/moons
-		for (auto& stellarObject : stellarObjects)
+		scene.render(camera, &gpuTimer);
+
+		sceneAllocations.end(scene.getAllocationCount(), scene.isLoading());
+
+		// imGUI
 		{
-			if (stellarObject.m_name == "sun")
+			PROFILE_ZONE("ImGui");
+			ImGui::Begin("Control");
+			ImGui::SliderInt("Movement Sensitivity", &movementSensitivity, -15, +15);
+			camera.updateSensitivity(movementSensitivity);
+			ImGui::InputFloat("days/second", &daysPerSecond, 0.01f, 5.0f, "%.3f");
+			ImGui::Checkbox("Enable Orbital Motion", &enableOrbitalMotion);
+			ImGui::Checkbox("Enable Rotational Motion", &enableRotationalMotion);
+			ImGui::Checkbox("Enable Orbital Path Marker", &enableOrbitalPath);
+			ImGui::Text("Average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+			ImGui::Text("\nControls: WASD/up-left-down-right keys; zoom & drag with mouse");
+			if (ImGui::Checkbox("Profiler", &profilerEnabled))
 			{
-				// export model uniform to GPU, then draw
-				stellarObject.exportToShader(lightSourceShader, "model");
-				stellarObject.draw(lightSourceShader);
+				Profiler::setEnabled(profilerEnabled);
 			}
-			else
+			ImGui::SameLine();
+			if (ImGui::Button("Dump trace"))
 			{
-				// export model + light uniforms to GPU, then draw
-				stellarObject.exportToShader(defaultShader, "model");
-
-				glUniform3f(glGetUniformLocation(defaultShader.m_ID, "lightColor"),
-					lightColor.x, lightColor.y, lightColor.z);
-				glUniform3f(glGetUniformLocation(defaultShader.m_ID, "lightPosition"),
-					lightPosition.x, lightPosition.y, lightPosition.z);
+				dumpTrace = true;
+			}
+			ImGui::Checkbox("Frame Breakdown", &showFrameBreakdown);
+			ImGui::Checkbox("Startup Timeline", &showStartupTimeline);
+			if (scene.getPopulation() != nullptr)
+			{
+				ImGui::Checkbox("Population Streaming", &showPopulation);
+			}
+			ImGui::End();
 
-				stellarObject.draw(defaultShader);
+			if (showPopulation && scene.getPopulation() != nullptr)
+			{
+				scene.getPopulation()->drawOverlay();
+			}
 
-				if (enableOrbitalPath)
-				{
-					stellarObject.m_orbitalEllipse->draw(orbitShader, stellarObject.m_orbitalFocusPtr->m_locMat);
-				}
+			if (showStartupTimeline)
+			{
+				StartupTimeline::drawOverlay();
 			}
-		}
 
-		asteroid->draw(asteroidShader);
+			if (showFrameBreakdown)
+			{
+				gpuTimer.drawOverlay();
+
+				// appended to the overlay's window
+				ImGui::Begin("Frame Breakdown");
+				ImGui::Text("Heap allocations: scene %u, frame %u, steady state frames that allocated %u",
+					sceneAllocations.getLast(), frameAllocations, sceneAllocations.getViolations());
+				ImGui::Text("Frame arena: %zu / %zu KB", scene.getFrameArena().getUsed() / 1024, scene.getFrameArena().getCapacity() / 1024);
+				ImGui::End();
+			}
 
-		skybox.draw(skyboxShader, camera);
+			ImGui::Render();
+			gpuTimer.beginPass(RenderPass::ImGui);
+			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+			gpuTimer.endPass();
+		}
 
-		// imGUI
-		ImGui::Begin("Control");
-		ImGui::SliderInt("Movement Sensitivity", &movementSensitivity, -15, +15);
-		camera.updateSensitivity(movementSensitivity);
-		ImGui::InputFloat("days/second", &daysPerSecond, 0.01f, 5.0f, "%.3f");
-		ImGui::Checkbox("Enable Orbital Motion", &enableOrbitalMotion);
-		ImGui::Checkbox("Enable Rotational Motion", &enableRotationalMotion);
-		ImGui::Checkbox("Enable Orbital Path Marker", &enableOrbitalPath);
-		ImGui::Text("Average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-		ImGui::Text("\nControls: WASD/up-left-down-right keys; zoom & drag with mouse");
-		ImGui::End();
-
-		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		// results are read back a couple of frames later, so this never waits on the GPU
+		gpuTimer.endFrame(frameMs);
 
 		// there are 2 image buffers, one displayed, and one drawn to
 		// must swap buffers in order to display image drawn (to back buffer)
-		glfwSwapBuffers(window);
+		{
+			PROFILE_ZONE("SwapBuffers");
+			glfwSwapBuffers(window);
+		}
+		scene.framePresented();
 
-		glfwPollEvents();
+		{
+			PROFILE_ZONE("PollEvents");
+			glfwPollEvents();
+		}
 	}
 
+	// closed before everything streamed in, what there is still gets written
+	StartupTimeline::end();
+
 	glfwDestroyWindow(window);
 	glfwTerminate();
 	return 0;
 }
-
-std::vector<glm::mat4> genAsteroidModels(const unsigned int numberAsteroids, double radius, double radiusDeviation)
-{
-	// holds different transformations for each asteroid
-	std::vector<glm::mat4> instanceMatrix;
-
-	// additional scaling
-	glm::mat4 addScale = glm::scale(glm::mat4(1.0f), glm::vec3(0.5f, 0.5f, 0.5f)); 
-
-	for (unsigned int i = 0; i < numberAsteroids; i++)
-	{
-		// using equation x^2 + y^2 = radius^2 (circle)
-		float x = randfloat(); // -1 to 1
-		float finalRadius = radius + randfloat() * radiusDeviation;
-		float y = ((rand() % 2) * 2 - 1) * sqrt(1.0f - x * x); // +/- sqrt(1-x^2) -> -1 to 1
-
-		glm::vec3 tempTranslation;
-		glm::quat tempRotation;
-		glm::vec3 tempScale;
-
-		// makes the random distribution more even
-		if (randfloat() > 0.5f)
-		{
-			tempTranslation = glm::vec3(y * finalRadius, randfloat(), x * finalRadius);
-		}
-		else
-		{
-			tempTranslation = glm::vec3(x * finalRadius, randfloat(), y * finalRadius);
-		}
-		// random rotations
-		tempRotation = glm::quat(1.0f, randfloat(), randfloat(), randfloat());
-		// random scales
-		tempScale = 0.1f * glm::vec3(randscale(), randscale(), randscale());
-
-		// model matrix components
-		glm::mat4 trans = glm::translate(glm::mat4(1.0f), tempTranslation);
-		glm::mat4 rot = glm::mat4_cast(tempRotation);
-		glm::mat4 sca = glm::scale(glm::mat4(1.0f), tempScale);
-
-		instanceMatrix.push_back(trans * rot * sca * addScale);
-	}
-
-	return instanceMatrix;
-}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+#include "StartupTimeline.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "Failed to open file: " << path << std::endl;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		std::cout << "Failed to map empty file: " << path << std::endl;
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (view == nullptr)
+	{
+		std::cout << "Failed to map file: " << path << std::endl;
+		if (mapping != nullptr)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = (const uint8_t*)view;
+	m_size = (size_t)size.QuadPart;
+	// pages are only read as they're touched, but what's mapped is what the caller goes on to read
+	StartupTimeline::addBytesRead(m_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data != nullptr)
+	{
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+	m_file = nullptr;
+	m_mapping = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		std::cout << "Failed to open file: " << path << std::endl;
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		std::cout << "Failed to map empty file: " << path << std::endl;
+		::close(file);
+		return false;
+	}
+
+	// the mapping keeps its own reference to the file
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (view == MAP_FAILED)
+	{
+		std::cout << "Failed to map file: " << path << std::endl;
+		return false;
+	}
+
+	m_data = (const uint8_t*)view;
+	m_size = (size_t)info.st_size;
+	// pages are only read as they're touched, but what's mapped is what the caller goes on to read
+	StartupTimeline::addBytesRead(m_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data != nullptr)
+	{
+		munmap((void*)m_data, m_size);
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+* Read only view of a whole file mapped into memory
+* The OS pages the file in on first touch and the view stays valid until close(), so loaders can hand out pointers
+* straight into it instead of copying. Not copyable, the view belongs to one owner.
+*/
+class MappedFile
+{
+private:
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// maps the file, closing whatever was mapped before, prints why and returns false if it can't
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const { return m_data != nullptr; }
+	const uint8_t* getData() const { return m_data; }
+	size_t getSize() const { return m_size; }
+};
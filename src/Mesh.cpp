@@ -1,73 +1,78 @@
 #include "Mesh.h"
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, Texture texture)
-	: m_vertices(vertices), m_indices(indices), m_texture(texture), m_instancing(1)
+#include <algorithm>
+
+#include "StartupTimeline.h"
+
+Mesh::Mesh(ResourceRegistry& resources, const MeshData& data, const Texture& texture, const float number, const std::vector<glm::mat4>& instanceMatrix)
+	: m_resources(resources), m_dequantize{ data.positionScale, data.positionOffset }, m_texture(texture), m_instancing(number)
 {
-	initMesh();
+	initMesh(data, number, instanceMatrix);
 }
 
-Mesh::Mesh(std::unique_ptr<Mesh>&& other, const float number, std::vector<glm::mat4> instanceMatrix)
-	: m_vertices(other->m_vertices), m_indices(other->m_indices), m_texture(other->m_texture), m_instancing(number)
+// dequantized for packed vertices
+static glm::vec3 getPosition(const MeshData& data, uint32_t vertex)
 {
-	initMesh(number, instanceMatrix);
+	if (data.layout == VertexLayout::Float)
+	{
+		return ((const Vertex*)data.vertices)[vertex].Position;
+	}
+
+	const uint16_t* position = ((const PackedVertex*)data.vertices)[vertex].position;
+	glm::vec3 normalized(position[0] / 65535.0f, position[1] / 65535.0f, position[2] / 65535.0f);
+	return normalized * data.positionScale + data.positionOffset;
 }
 
 Mesh::~Mesh()
 {
-	glDeleteVertexArrays(1, &m_VAO);
-	glDeleteBuffers(1, &m_VBO);
-	glDeleteBuffers(1, &m_EBO);
+	m_resources.releaseGeometry(m_geometryKey);
+	m_resources.releaseTexture(m_texture.ID);
+	if (m_instancing != 1)
+	{
+		m_resources.getArena().deleteVertexArray(m_VAO);
+		glDeleteBuffers(1, &m_instanceVBO);
+	}
 }
 
 // sets up the mesh
-// instead of creating separate classes for VAO, VBO, EBO, just initialize them together inside this mesh
-void Mesh::initMesh(const float number, std::vector<glm::mat4> instanceMatrix)
+// the geometry goes into the shared arena unless it's there already, only instanced meshes need a VAO and buffer of
+// their own
+void Mesh::initMesh(const MeshData& data, const float number, const std::vector<glm::mat4>& instanceMatrix)
 {
-	// generate objects
-	glGenVertexArrays(1, &m_VAO);
-	glGenBuffers(1, &m_VBO);
-	glGenBuffers(1, &m_EBO);
-	glGenBuffers(1, &m_instanceVBO);
+	m_boundingRadius = 0.0f;
+	for (uint32_t i = 0; i < data.vertexCount; i++)
+	{
+		m_boundingRadius = std::max(m_boundingRadius, glm::length(getPosition(data, i)));
+	}
 
-	glBindVertexArray(m_VAO);
+	m_geometry = m_resources.acquireGeometry(data, m_geometryKey);
+	m_instanceVBO = 0;
 
-	// vertex buffer
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_VBO));
-	GLCall(glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(Vertex), &m_vertices[0], GL_STATIC_DRAW));
+	if (number == 1)
+	{
+		m_VAO = m_resources.getArena().getVertexArray(data.layout);
+		return;
+	}
 
-	// layout
-	GLCall(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0));
-	GLCall(glEnableVertexAttribArray(0));
-	GLCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoor)));
-	GLCall(glEnableVertexAttribArray(1));
-	GLCall(glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal)));
-	GLCall(glEnableVertexAttribArray(2));
+	// in the case of instanced drawing, the instance matrices are attributes of a VAO of its own
+	m_VAO = m_resources.getArena().createVertexArray(data.layout);
+	glGenBuffers(1, &m_instanceVBO);
+	glBindVertexArray(m_VAO);
 
-	// index buffer
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO));
-	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), &m_indices[0], GL_STATIC_DRAW));
+	// instanced VBO, left uninitialized when no matrices are given so they can be streamed in later
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO));
+	GLCall(glBufferData(GL_ARRAY_BUFFER, size_t(number) * sizeof(glm::mat4), instanceMatrix.empty() ? nullptr : instanceMatrix.data(),
+		instanceMatrix.empty() ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW));
+	StartupTimeline::addBytesUploaded(instanceMatrix.size() * sizeof(glm::mat4));
 
-	// in the case of instanced drawing, set up additional buffers
-	if (number != 1)
+	// one mat4 takes up 4 vec4 attributes
+	for (unsigned int i = 0; i < 4; i++)
 	{
-		// instanced VBO
-		GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO));
-		GLCall(glBufferData(GL_ARRAY_BUFFER, instanceMatrix.size() * sizeof(glm::mat4), instanceMatrix.data(), GL_STATIC_DRAW));
-
-		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(1 * sizeof(glm::vec4)));
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-		glEnableVertexAttribArray(5);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-		glEnableVertexAttribArray(6);
-		
+		glVertexAttribPointer(INSTANCE_MATRIX_ATTRIB + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(INSTANCE_MATRIX_ATTRIB + i);
+
 		// Makes it so the transform is only switched when drawing the next instance
-		glVertexAttribDivisor(3, 1);
-		glVertexAttribDivisor(4, 1);
-		glVertexAttribDivisor(5, 1);
-		glVertexAttribDivisor(6, 1);
+		glVertexAttribDivisor(INSTANCE_MATRIX_ATTRIB + i, 1);
 	}
 
 	// unbind to be safe
@@ -75,32 +80,26 @@ void Mesh::initMesh(const float number, std::vector<glm::mat4> instanceMatrix)
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void Mesh::draw(Shader& shader)
+void Mesh::record(CommandList& list, const ProgramSlot& program, RenderLayer layer, RenderPass pass, const glm::mat4* model, float depth,
+	unsigned int firstInstance, unsigned int instanceCount) const
 {
-	// bind shader to be able to access uniforms
-	GLCall(shader.bind());
-	GLCall(glBindVertexArray(m_VAO));
-
-	// get uniform location and set it
-	GLCall(int texUni = glGetUniformLocation(shader.m_ID, "tex0"));
-	GLCall(glUniform1i(texUni, 0));
-
-	GLCall(glActiveTexture(GL_TEXTURE0));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_texture.ID));
-	
-	// check if instanced drawing
-	if (m_instancing == 1)
-	{
-		// normal draw
-		GLCall(glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0));
-	}
-	else
-	{
-		// instanced draw
-		GLCall(glDrawElementsInstanced(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0, m_instancing));
-	}
+	DrawCommand command;
+	command.program = program.program;
+	command.geometry = m_VAO;
+	command.texture = m_texture.ID;
+	command.instanceBuffer = m_instanceVBO;
+	command.modelSlot = program.modelSlot;
+	command.dequantizeSlot = program.dequantizeSlot;
+	command.dequantize = m_dequantize;
+	command.indexCount = m_geometry.indexCount;
+	command.indexType = m_geometry.indexType;
+	command.indexOffset = m_geometry.indexOffset;
+	command.baseVertex = m_geometry.baseVertex;
+	command.firstInstance = firstInstance;
+	command.instanceCount = instanceCount == 0 ? m_instancing : instanceCount;
+	command.primitive = Primitive::Triangles;
+	command.pass = pass;
+	command.sortKey = CommandList::makeSortKey(layer, program.program, depth, command.texture, command.geometry);
 
-	GLCall(glActiveTexture(GL_TEXTURE0));
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
-	GLCall(glBindVertexArray(0));
+	list.push(command, model);
 }
\ No newline at end of file
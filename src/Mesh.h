@@ -3,18 +3,16 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <vector>
 #include <string>
 
+#include "Vertex.h"
+#include "ResourceRegistry.h"
 #include "Shader.h"
 #include "GLErrors.h"
-
-struct Vertex
-{
-	glm::vec3 Position;
-	glm::vec2 TexCoor;
-	glm::vec3 Normal;
-};
+#include "CommandList.h"
+#include "RenderQueue.h"
 
 struct Texture
 {
@@ -26,24 +24,47 @@ struct Texture
 class Mesh
 {
 private:
-	// the mesh data
-	std::vector<Vertex> m_vertices;
-	std::vector<unsigned int> m_indices;
+	// the vertex/index data lives in the registry's arena on the GPU only, the handle is where and the key is what it's
+	// shared under
+	ResourceRegistry& m_resources;
+	GeometryHandle m_geometry;
+	uint64_t m_geometryKey;
+	// positionScale and positionOffset of the data, set as the shaders' dequantize uniform
+	glm::vec3 m_dequantize[2];
 	Texture m_texture;
 
 	// number of instances to draw together, 1 if not instanced draw call
 	int m_instancing;
 
-	// openGL IDs
-	unsigned int m_VAO, m_VBO, m_EBO, m_instanceVBO;
+	// openGL IDs, the VAO is the arena's shared one of the layout unless instanced
+	unsigned int m_VAO, m_instanceVBO;
+
+	// radius of a sphere around the origin containing every vertex, for culling
+	float m_boundingRadius;
 
 	// sets up the mesh
-	void initMesh(const float number = 1, std::vector<glm::mat4> instanceMatrix = {});
+	void initMesh(const MeshData& data, const float number, const std::vector<glm::mat4>& instanceMatrix);
 
 public:
-	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, Texture texture);
-	Mesh(std::unique_ptr<Mesh>&& other, const float number, std::vector<glm::mat4> instanceMatrix);
+	// the data is shared through the registry, which must outlive the mesh, and isn't kept so it can go away once
+	// constructed; the texture is released with the mesh if it was acquired from the registry
+	// instanced if number isn't 1, instanceMatrix may then be empty and the instance buffer has room for number matrices
+	// to be filled in later
+	Mesh(ResourceRegistry& resources, const MeshData& data, const Texture& texture, const float number = 1,
+		const std::vector<glm::mat4>& instanceMatrix = {});
 	~Mesh();
 
-	void draw(Shader& shader);
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+
+	// records a draw command for this mesh, model may be nullptr for instanced meshes
+	// depth is the distance to the camera divided by the far plane
+	// instanced meshes can draw a sub range of their instances, instanceCount of 0 draws all of them
+	// doesn't touch GL, safe to call from worker threads
+	void record(CommandList& list, const ProgramSlot& program, RenderLayer layer, RenderPass pass, const glm::mat4* model, float depth,
+		unsigned int firstInstance = 0, unsigned int instanceCount = 0) const;
+
+	float getBoundingRadius() const { return m_boundingRadius; }
+	// 0 for meshes that aren't instanced
+	unsigned int getInstanceBuffer() const { return m_instanceVBO; }
 };
\ No newline at end of file
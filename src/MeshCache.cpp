@@ -0,0 +1,358 @@
+#include "MeshCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "AssetArchive.h"
+#include "Hash.h"
+#include "LoadModel.h"
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+#include "StartupTimeline.h"
+
+// what the import does to the meshes, part of the hash so changing it rebuilds every cache
+#define MESH_IMPORT_FLAGS (aiProcess_Triangulate | aiProcess_FlipUVs)
+
+static bool isBlank(uint8_t c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+uint64_t hashModelSources(const std::string& path)
+{
+	PROFILE_ZONE("hashModelSources");
+
+	MappedFile obj;
+	if (!obj.open(path))
+	{
+		return 0;
+	}
+
+	uint64_t hash = hashBytes(obj.getData(), obj.getSize(), HASH_SEED ^ MESH_IMPORT_FLAGS);
+	std::string directory = path.substr(0, path.find_last_of('/') + 1);
+
+	// materials are named by "mtllib a.mtl [b.mtl...]" lines, their files are hashed in the order they're named
+	const uint8_t* end = obj.getData() + obj.getSize();
+	for (const uint8_t* line = obj.getData(); line < end;)
+	{
+		const uint8_t* next = (const uint8_t*)std::memchr(line, '\n', size_t(end - line));
+		next = next == nullptr ? end : next + 1;
+
+		if (next - line > 7 && std::memcmp(line, "mtllib", 6) == 0 && isBlank(line[6]))
+		{
+			const uint8_t* c = line + 6;
+			while (c < next)
+			{
+				while (c < next && (isBlank(*c) || *c == '\n'))
+				{
+					c++;
+				}
+				const uint8_t* name = c;
+				while (c < next && !isBlank(*c) && *c != '\n')
+				{
+					c++;
+				}
+				if (c == name)
+				{
+					continue;
+				}
+
+				std::string mtlPath = directory + std::string((const char*)name, size_t(c - name));
+				MappedFile mtl;
+				if (std::ifstream(mtlPath).good() && mtl.open(mtlPath))
+				{
+					hash = hashBytes(mtl.getData(), mtl.getSize(), hash);
+				}
+				else
+				{
+					// a missing material still has to change the hash when it shows up
+					hash = hashBytes(name, size_t(c - name), ~hash);
+				}
+			}
+		}
+		line = next;
+	}
+
+	return hash != 0 ? hash : 1;
+}
+
+void ModelData::clear()
+{
+	m_file.close();
+	m_archived = false;
+	m_meshes.clear();
+	m_textures.clear();
+	m_vertices.clear();
+	m_packedVertices.clear();
+	m_indices.clear();
+	m_shortIndices.clear();
+}
+
+bool ModelData::mapCache(const std::string& cachePath, uint64_t sourceHash)
+{
+	if (!std::ifstream(cachePath).good() || !m_file.open(cachePath))
+	{
+		return false;
+	}
+
+	// a stale cache isn't an error, the model just changed
+	if (!viewBlob(m_file.getData(), m_file.getSize(), sourceHash))
+	{
+		m_file.close();
+		return false;
+	}
+	return true;
+}
+
+bool ModelData::viewBlob(const uint8_t* data, size_t size, uint64_t sourceHash)
+{
+	const MeshCacheHeader* header = (const MeshCacheHeader*)data;
+	bool valid = size >= sizeof(MeshCacheHeader) && header->magic == MESH_CACHE_MAGIC && header->version == MESH_CACHE_VERSION
+		&& header->vertexSize == sizeof(Vertex) && (sourceHash == 0 || header->sourceHash == sourceHash) && header->size == size
+		&& header->meshCount <= (size - sizeof(MeshCacheHeader)) / sizeof(MeshCacheEntry);
+
+	const MeshCacheEntry* entries = (const MeshCacheEntry*)(data + sizeof(MeshCacheHeader));
+	for (uint32_t i = 0; valid && i < header->meshCount; i++)
+	{
+		const MeshCacheEntry& entry = entries[i];
+		valid = entry.vertexOffset % MESH_CACHE_ALIGNMENT == 0 && entry.indexOffset % MESH_CACHE_ALIGNMENT == 0
+			&& entry.vertexLayout <= uint32_t(VertexLayout::Packed)
+			&& entry.vertexOffset <= size && (size - entry.vertexOffset) / getVertexSize(VertexLayout(entry.vertexLayout)) >= entry.vertexCount
+			&& (entry.indexSize == sizeof(uint16_t) || entry.indexSize == sizeof(uint32_t))
+			&& entry.indexOffset <= size && (size - entry.indexOffset) / entry.indexSize >= entry.indexCount
+			&& uint64_t(entry.textureOffset) + entry.textureLength <= size;
+	}
+
+	if (!valid)
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header->meshCount; i++)
+	{
+		const MeshCacheEntry& entry = entries[i];
+
+		MeshData mesh;
+		mesh.vertices = data + entry.vertexOffset;
+		mesh.vertexCount = entry.vertexCount;
+		mesh.layout = VertexLayout(entry.vertexLayout);
+		mesh.positionScale = glm::vec3(entry.positionScale[0], entry.positionScale[1], entry.positionScale[2]);
+		mesh.positionOffset = glm::vec3(entry.positionOffset[0], entry.positionOffset[1], entry.positionOffset[2]);
+		mesh.indices = data + entry.indexOffset;
+		mesh.indexCount = entry.indexCount;
+		mesh.indexSize = entry.indexSize;
+		m_meshes.push_back(mesh);
+		m_textures.emplace_back((const char*)data + entry.textureOffset, entry.textureLength);
+	}
+	return true;
+}
+
+bool ModelData::load(const std::string& path)
+{
+	PROFILE_ZONE("ModelData::load");
+	STARTUP_ASSET("ModelData::load", path);
+
+	clear();
+
+	// packed by packAssets(), there's no .obj/.mtl next to it to check against
+	const uint8_t* archived;
+	size_t archivedSize;
+	if (findArchivedFile(path + MESH_CACHE_EXTENSION, archived, archivedSize))
+	{
+		m_archived = viewBlob(archived, archivedSize, 0);
+		return m_archived;
+	}
+
+	uint64_t sourceHash = hashModelSources(path);
+	if (sourceHash == 0)
+	{
+		return false;
+	}
+
+	std::string cachePath = path + MESH_CACHE_EXTENSION;
+	if (mapCache(cachePath, sourceHash))
+	{
+		return true;
+	}
+
+	// a rebuild is rare enough to be worth telling about
+	if (!import(path, true))
+	{
+		return false;
+	}
+
+	// serve this load from the import either way, the cache is for the next one
+	write(cachePath, sourceHash);
+	return true;
+}
+
+// meshes in the order of a depth first walk of the node tree
+static void collectMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes)
+{
+	for (unsigned int i = 0; i < node->mNumMeshes; i++)
+	{
+		meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+	}
+	for (unsigned int i = 0; i < node->mNumChildren; i++)
+	{
+		collectMeshes(node->mChildren[i], scene, meshes);
+	}
+}
+
+bool ModelData::import(const std::string& path, bool report)
+{
+	PROFILE_ZONE("ModelData::import");
+
+	clear();
+
+	Assimp::Importer importer;
+	const aiScene* scene;
+	{
+		PROFILE_ZONE("Assimp::ReadFile");
+		STARTUP_ASSET("Assimp::ReadFile", path);
+		// the .mtl files it reads too aren't counted
+		StartupTimeline::addFileRead(path);
+		scene = importer.ReadFile(path, MESH_IMPORT_FLAGS);
+	}
+
+	if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+	{
+		std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+		return false;
+	}
+
+	std::vector<const aiMesh*> meshes;
+	collectMeshes(scene->mRootNode, scene, meshes);
+
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		extractMeshData(meshes[i], vertices, indices);
+
+		MeshStats before, after;
+		optimizeMesh(vertices, indices, before, after);
+
+		// float vertices are only kept for meshes the packed layout can't hold
+		MeshData mesh;
+		mesh.vertexCount = (uint32_t)vertices.size();
+		m_packedVertices.emplace_back();
+		if (packVertices(vertices, m_packedVertices.back(), mesh.positionScale, mesh.positionOffset))
+		{
+			mesh.layout = VertexLayout::Packed;
+			after.vertexBytes = m_packedVertices.back().size() * sizeof(PackedVertex);
+			vertices.clear();
+		}
+		m_vertices.push_back(std::move(vertices));
+
+		if (report)
+		{
+			printMeshStats(path + " mesh " + std::to_string(i), before, after);
+		}
+
+		mesh.indexCount = (uint32_t)indices.size();
+		m_shortIndices.emplace_back();
+		if (mesh.vertexCount <= SHORT_INDEX_VERTICES)
+		{
+			mesh.indexSize = sizeof(uint16_t);
+			m_shortIndices.back().assign(indices.begin(), indices.end());
+			indices.clear();
+		}
+		m_indices.push_back(std::move(indices));
+		m_meshes.push_back(mesh);
+
+		// there will only be 1 texture (only diffuse map) for simplicity
+		aiString textureFilename;
+		scene->mMaterials[meshes[i]->mMaterialIndex]->GetTexture(aiTextureType_DIFFUSE, 0, &textureFilename);
+		m_textures.emplace_back(textureFilename.C_Str());
+	}
+
+	// the vectors are done growing, the views can point into them now
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		MeshData& mesh = m_meshes[i];
+		mesh.vertices = mesh.layout == VertexLayout::Packed ? (const void*)m_packedVertices[i].data() : (const void*)m_vertices[i].data();
+		mesh.indices = mesh.indexSize == sizeof(uint16_t) ? (const void*)m_shortIndices[i].data() : (const void*)m_indices[i].data();
+	}
+	return true;
+}
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+}
+
+bool ModelData::write(const std::string& cachePath, uint64_t sourceHash) const
+{
+	PROFILE_ZONE("ModelData::write");
+
+	MeshCacheHeader header = {};
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.meshCount = (uint32_t)m_meshes.size();
+	header.vertexSize = sizeof(Vertex);
+	header.sourceHash = sourceHash;
+
+	// texture names right after the entries, then each mesh's vertices and indices on aligned offsets
+	std::vector<MeshCacheEntry> entries(m_meshes.size());
+	uint64_t offset = sizeof(MeshCacheHeader) + entries.size() * sizeof(MeshCacheEntry);
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		entries[i].textureOffset = (uint32_t)offset;
+		entries[i].textureLength = (uint32_t)m_textures[i].size();
+		offset += m_textures[i].size();
+	}
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		entries[i].vertexCount = m_meshes[i].vertexCount;
+		entries[i].indexCount = m_meshes[i].indexCount;
+		entries[i].indexSize = m_meshes[i].indexSize;
+		entries[i].vertexLayout = uint32_t(m_meshes[i].layout);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			entries[i].positionScale[axis] = m_meshes[i].positionScale[axis];
+			entries[i].positionOffset[axis] = m_meshes[i].positionOffset[axis];
+		}
+		entries[i].vertexOffset = alignOffset(offset);
+		offset = entries[i].vertexOffset + uint64_t(m_meshes[i].vertexCount) * getVertexSize(m_meshes[i].layout);
+		entries[i].indexOffset = alignOffset(offset);
+		offset = entries[i].indexOffset + uint64_t(m_meshes[i].indexCount) * m_meshes[i].indexSize;
+	}
+	header.size = offset;
+
+	std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+	if (!out)
+	{
+		std::cout << "Failed to write mesh cache: " << cachePath << std::endl;
+		return false;
+	}
+
+	const char padding[MESH_CACHE_ALIGNMENT] = {};
+	uint64_t written = 0;
+	auto put = [&](const void* data, uint64_t at, uint64_t bytes)
+	{
+		out.write(padding, std::streamsize(at - written));
+		out.write((const char*)data, std::streamsize(bytes));
+		written = at + bytes;
+	};
+
+	put(&header, 0, sizeof(header));
+	put(entries.data(), written, entries.size() * sizeof(MeshCacheEntry));
+	for (const std::string& texture : m_textures)
+	{
+		put(texture.data(), written, texture.size());
+	}
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		put(m_meshes[i].vertices, entries[i].vertexOffset, uint64_t(m_meshes[i].vertexCount) * getVertexSize(m_meshes[i].layout));
+		put(m_meshes[i].indices, entries[i].indexOffset, uint64_t(m_meshes[i].indexCount) * m_meshes[i].indexSize);
+	}
+
+	if (!out)
+	{
+		std::cout << "Failed to write mesh cache: " << cachePath << std::endl;
+		return false;
+	}
+	return true;
+}
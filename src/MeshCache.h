@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "MappedFile.h"
+
+#define MESH_CACHE_MAGIC 0x4348534Du // "MSHC"
+#define MESH_CACHE_VERSION 3u
+// vertex and index arrays start on this boundary in the blob
+#define MESH_CACHE_ALIGNMENT 16u
+// appended to the model path, the cache sits next to the .obj it was built from
+#define MESH_CACHE_EXTENSION ".meshcache"
+
+// start of a cache blob, followed by meshCount entries, the texture names and the aligned vertex/index arrays
+struct MeshCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t meshCount;
+	// sizeof(Vertex) when it was written, a changed layout invalidates the cache (PackedVertex is locked by Mesh.h)
+	uint32_t vertexSize;
+	// hashModelSources() of the model it was built from
+	uint64_t sourceHash;
+	// of the whole blob, catches a truncated write
+	uint64_t size;
+};
+
+// one per mesh, offsets from the start of the blob
+struct MeshCacheEntry
+{
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	// 2 or 4 bytes
+	uint32_t indexSize;
+	// diffuse texture file relative to the model, not null terminated
+	uint32_t textureOffset;
+	uint32_t textureLength;
+	// VertexLayout
+	uint32_t vertexLayout;
+	// dequantization of packed positions, see MeshData
+	float positionScale[3];
+	float positionOffset[3];
+};
+
+static_assert(sizeof(MeshCacheHeader) == 32, "mesh cache header layout changed, bump MESH_CACHE_VERSION");
+static_assert(sizeof(MeshCacheEntry) == 64, "mesh cache entry layout changed, bump MESH_CACHE_VERSION");
+
+// hash of the files a model is imported from: the .obj and every .mtl its mtllib lines name, 0 if the .obj can't be read
+uint64_t hashModelSources(const std::string& path);
+
+/*
+* The processed meshes of a model, ready to be uploaded
+* load() maps the content-hashed cache next to the .obj and hands out views straight into it, so the vertex/index
+* arrays go from the page cache to glBufferData without a copy. Assimp only runs when the cache is missing or was
+* built from a different .obj/.mtl, the fresh import is then optimized (see optimizeMesh()) and written back for the
+* next start.
+* The views stay valid as long as the ModelData.
+*/
+class ModelData
+{
+private:
+	MappedFile m_file;
+	std::vector<MeshData> m_meshes;
+	std::vector<std::string> m_textures;
+	// back the views after an import, meshes use one of the vertex layouts and either 16 or 32-bit indices
+	std::vector<std::vector<Vertex>> m_vertices;
+	std::vector<std::vector<PackedVertex>> m_packedVertices;
+	std::vector<std::vector<uint32_t>> m_indices;
+	std::vector<std::vector<uint16_t>> m_shortIndices;
+
+	// viewed from the mounted archive
+	bool m_archived = false;
+
+	// false if the blob doesn't exist, is damaged or was built from other sources
+	bool mapCache(const std::string& cachePath, uint64_t sourceHash);
+	// the meshes and textures of a blob laid out like the cache file, sourceHash 0 takes one built from any sources
+	bool viewBlob(const uint8_t* data, size_t size, uint64_t sourceHash);
+	void clear();
+
+public:
+	// from the mounted archive if it has the model, else from the cache when it matches the sources, otherwise
+	// imported and cached
+	bool load(const std::string& path);
+	// always runs Assimp and the optimizer, leaves the cache alone, prints what the optimizer did if report is set
+	bool import(const std::string& path, bool report = false);
+	// what's loaded as a cache blob of the given sources
+	bool write(const std::string& cachePath, uint64_t sourceHash) const;
+
+	const std::vector<MeshData>& getMeshes() const { return m_meshes; }
+	// diffuse texture of each mesh, relative to the model's directory
+	const std::string& getTexture(size_t mesh) const { return m_textures[mesh]; }
+	// whether the views point into a mapped cache or the archive
+	bool isCached() const { return m_file.isOpen() || m_archived; }
+};
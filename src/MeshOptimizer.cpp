@@ -0,0 +1,477 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include "Profiler.h"
+
+#define NO_VERTEX 0xFFFFFFFFu
+
+float analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+	if (indices.size() < 3)
+	{
+		return 0.0f;
+	}
+
+	// a vertex is still cached if fewer than cacheSize misses happened since it was last loaded
+	std::vector<uint32_t> loadedAt(vertexCount, 0);
+	uint32_t misses = 0;
+	for (uint32_t index : indices)
+	{
+		if (loadedAt[index] == 0 || misses - loadedAt[index] >= cacheSize)
+		{
+			misses++;
+			loadedAt[index] = misses;
+		}
+	}
+	return float(misses) / float(indices.size() / 3);
+}
+
+static uint32_t hashVertex(const Vertex& vertex)
+{
+	uint32_t words[sizeof(Vertex) / 4];
+	std::memcpy(words, &vertex, sizeof(Vertex));
+
+	uint32_t hash = 0x9E3779B9u;
+	for (uint32_t word : words)
+	{
+		hash ^= word * 0x85EBCA6Bu;
+		hash = (hash << 13 | hash >> 19) * 0xC2B2AE35u;
+	}
+	return hash ^ hash >> 16;
+}
+
+uint32_t weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	PROFILE_ZONE("weldVertices");
+
+	static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex has padding, welding compares raw bytes");
+
+	size_t tableSize = 16;
+	while (tableSize < vertices.size() * 2)
+	{
+		tableSize *= 2;
+	}
+
+	// open addressing, slots hold the welded index of the first vertex with those bytes
+	std::vector<uint32_t> table(tableSize, NO_VERTEX);
+	std::vector<uint32_t> remap(vertices.size());
+	uint32_t unique = 0;
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		size_t slot = hashVertex(vertices[i]) & (tableSize - 1);
+		while (true)
+		{
+			uint32_t welded = table[slot];
+			if (welded == NO_VERTEX)
+			{
+				// compacted in place, unique never gets ahead of i
+				table[slot] = unique;
+				vertices[unique] = vertices[i];
+				remap[i] = unique++;
+				break;
+			}
+			if (std::memcmp(&vertices[welded], &vertices[i], sizeof(Vertex)) == 0)
+			{
+				remap[i] = welded;
+				break;
+			}
+			slot = (slot + 1) & (tableSize - 1);
+		}
+	}
+
+	vertices.resize(unique);
+	for (uint32_t& index : indices)
+	{
+		index = remap[index];
+	}
+	return unique;
+}
+
+// Forsyth's scoring: the 3 most recent vertices score the same so the last triangle's fan doesn't win outright,
+// the rest decay with their position, and vertices with few triangles left get a boost so they're finished off
+static float vertexScore(int cachePosition, uint32_t liveTriangles)
+{
+	if (liveTriangles == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		if (cachePosition < 3)
+		{
+			score = 0.75f;
+		}
+		else
+		{
+			score = std::pow(1.0f - float(cachePosition - 3) / (VERTEX_CACHE_OPTIMIZE_SIZE - 3), 1.5f);
+		}
+	}
+	return score + 2.0f / std::sqrt(float(liveTriangles));
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+	PROFILE_ZONE("optimizeVertexCache");
+
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// triangles using each vertex, the first live[v] of a vertex's range are the ones not emitted yet
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	std::vector<uint32_t> live(vertexCount, 0);
+	for (uint32_t index : indices)
+	{
+		live[index]++;
+	}
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		offsets[v + 1] = offsets[v] + live[v];
+	}
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			adjacency[fill[indices[i]]++] = uint32_t(i / 3);
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> scores(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++)
+	{
+		scores[v] = vertexScore(-1, live[v]);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	size_t best = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+		if (triangleScores[t] > triangleScores[best])
+		{
+			best = t;
+		}
+	}
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	uint32_t cache[VERTEX_CACHE_OPTIMIZE_SIZE + 3];
+	uint32_t cacheSize = 0;
+	size_t cursor = 0;
+
+	while (true)
+	{
+		emitted[best] = 1;
+		const uint32_t* triangle = &indices[best * 3];
+		result.insert(result.end(), triangle, triangle + 3);
+		if (result.size() == indices.size())
+		{
+			break;
+		}
+
+		// the triangle's vertices move to the front of the cache, the rest shift back and may fall out
+		uint32_t next[VERTEX_CACHE_OPTIMIZE_SIZE + 3];
+		uint32_t nextSize = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t v = triangle[k];
+			uint32_t* first = &adjacency[offsets[v]];
+			uint32_t* last = first + live[v] - 1;
+			*std::find(first, last + 1, uint32_t(best)) = *last;
+			live[v]--;
+
+			if (std::find(next, next + nextSize, v) == next + nextSize)
+			{
+				next[nextSize++] = v;
+			}
+		}
+		for (uint32_t i = 0; i < cacheSize; i++)
+		{
+			if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+			{
+				next[nextSize++] = cache[i];
+			}
+		}
+
+		for (uint32_t i = 0; i < nextSize; i++)
+		{
+			uint32_t v = next[i];
+			cachePosition[v] = i < VERTEX_CACHE_OPTIMIZE_SIZE ? int(i) : -1;
+
+			float score = vertexScore(cachePosition[v], live[v]);
+			float delta = score - scores[v];
+			scores[v] = score;
+			for (uint32_t j = 0; j < live[v]; j++)
+			{
+				triangleScores[adjacency[offsets[v] + j]] += delta;
+			}
+		}
+
+		cacheSize = std::min(nextSize, VERTEX_CACHE_OPTIMIZE_SIZE);
+		std::copy(next, next + cacheSize, cache);
+
+		// best triangle touching the cache, or the next one in input order once the cache has nothing left
+		float bestScore = -1.0f;
+		best = triangleCount;
+		for (uint32_t i = 0; i < cacheSize; i++)
+		{
+			uint32_t v = cache[i];
+			for (uint32_t j = 0; j < live[v]; j++)
+			{
+				uint32_t t = adjacency[offsets[v] + j];
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					best = t;
+				}
+			}
+		}
+		if (best == triangleCount)
+		{
+			while (emitted[cursor])
+			{
+				cursor++;
+			}
+			best = cursor;
+		}
+	}
+
+	indices.swap(result);
+}
+
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold)
+{
+	PROFILE_ZONE("optimizeOverdraw");
+
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2)
+	{
+		return;
+	}
+
+	// a triangle missing the cache on all three vertices starts a new cluster, moving whole clusters around then
+	// only costs misses at their seams
+	std::vector<size_t> clusters;
+	std::vector<uint32_t> loadedAt(vertices.size(), 0);
+	uint32_t misses = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		int triangleMisses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t index = indices[t * 3 + k];
+			if (loadedAt[index] == 0 || misses - loadedAt[index] >= VERTEX_CACHE_SIZE)
+			{
+				misses++;
+				loadedAt[index] = misses;
+				triangleMisses++;
+			}
+		}
+		if (triangleMisses == 3 || t == 0)
+		{
+			clusters.push_back(t);
+		}
+	}
+	if (clusters.size() < 2)
+	{
+		return;
+	}
+	clusters.push_back(triangleCount);
+
+	// area weighted centroid and normal of every cluster
+	std::vector<glm::vec3> centroids(clusters.size() - 1, glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(clusters.size() - 1, glm::vec3(0.0f));
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c + 1 < clusters.size(); c++)
+	{
+		float area = 0.0f;
+		for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const glm::vec3& a = vertices[indices[t * 3]].Position;
+			const glm::vec3& b = vertices[indices[t * 3 + 1]].Position;
+			const glm::vec3& d = vertices[indices[t * 3 + 2]].Position;
+			glm::vec3 normal = glm::cross(b - a, d - a);
+			float triangleArea = glm::length(normal);
+
+			centroids[c] += (a + b + d) * (triangleArea / 3.0f);
+			normals[c] += normal;
+			area += triangleArea;
+		}
+		meshCentroid += centroids[c];
+		meshArea += area;
+		centroids[c] = area > 0.0f ? centroids[c] / area : glm::vec3(0.0f);
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+	// clusters facing away from the middle are the ones in front from most directions, draw them first
+	std::vector<float> keys(clusters.size() - 1);
+	std::vector<uint32_t> order(clusters.size() - 1);
+	for (size_t c = 0; c < keys.size(); c++)
+	{
+		float length = glm::length(normals[c]);
+		keys[c] = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+		order[c] = uint32_t(c);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (uint32_t c : order)
+	{
+		result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+	}
+
+	uint32_t vertexCount = (uint32_t)vertices.size();
+	if (analyzeVertexCache(result, vertexCount) <= analyzeVertexCache(indices, vertexCount) * threshold)
+	{
+		indices.swap(result);
+	}
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	PROFILE_ZONE("optimizeVertexFetch");
+
+	// vertices no index refers to are dropped
+	std::vector<uint32_t> remap(vertices.size(), NO_VERTEX);
+	std::vector<Vertex> result;
+	result.reserve(vertices.size());
+
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == NO_VERTEX)
+		{
+			remap[index] = (uint32_t)result.size();
+			result.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices.swap(result);
+}
+
+static uint16_t packUnorm16(float value)
+{
+	return (uint16_t)std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f);
+}
+
+// 10 bit two's complement of a [-1, 1] value
+static uint32_t packSnorm10(float value)
+{
+	return uint32_t(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 511.0f)) & 0x3FFu;
+}
+
+bool packVertices(const std::vector<Vertex>& vertices, std::vector<PackedVertex>& packed, glm::vec3& positionScale, glm::vec3& positionOffset)
+{
+	PROFILE_ZONE("packVertices");
+
+	glm::vec3 min(0.0f), max(0.0f);
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const Vertex& vertex = vertices[i];
+		if (vertex.TexCoor.x < 0.0f || vertex.TexCoor.x > 1.0f || vertex.TexCoor.y < 0.0f || vertex.TexCoor.y > 1.0f)
+		{
+			return false;
+		}
+		min = i == 0 ? vertex.Position : glm::min(min, vertex.Position);
+		max = i == 0 ? vertex.Position : glm::max(max, vertex.Position);
+	}
+
+	positionOffset = min;
+	positionScale = max - min;
+
+	packed.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const Vertex& vertex = vertices[i];
+		PackedVertex& result = packed[i];
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = positionScale[axis];
+			result.position[axis] = extent > 0.0f ? packUnorm16((vertex.Position[axis] - min[axis]) / extent) : 0;
+		}
+		result.position[3] = 0;
+		result.texCoord[0] = packUnorm16(vertex.TexCoor.x);
+		result.texCoord[1] = packUnorm16(vertex.TexCoor.y);
+
+		glm::vec3 normal = glm::length(vertex.Normal) > 0.0f ? glm::normalize(vertex.Normal) : vertex.Normal;
+		result.normal = packSnorm10(normal.x) | packSnorm10(normal.y) << 10 | packSnorm10(normal.z) << 20;
+	}
+	return true;
+}
+
+// sign extends a 10 bit two's complement value
+static float unpackSnorm10(uint32_t bits)
+{
+	int value = int(bits << 22) >> 22;
+	return std::max(float(value) / 511.0f, -1.0f);
+}
+
+void unpackVertices(const MeshData& mesh, std::vector<Vertex>& vertices)
+{
+	vertices.resize(mesh.vertexCount);
+	if (mesh.layout == VertexLayout::Float)
+	{
+		std::memcpy(vertices.data(), mesh.vertices, mesh.vertexCount * sizeof(Vertex));
+		return;
+	}
+
+	const PackedVertex* packed = (const PackedVertex*)mesh.vertices;
+	for (uint32_t i = 0; i < mesh.vertexCount; i++)
+	{
+		Vertex& vertex = vertices[i];
+		glm::vec3 position(packed[i].position[0], packed[i].position[1], packed[i].position[2]);
+		vertex.Position = position / 65535.0f * mesh.positionScale + mesh.positionOffset;
+		vertex.TexCoor = glm::vec2(packed[i].texCoord[0], packed[i].texCoord[1]) / 65535.0f;
+		vertex.Normal = glm::vec3(unpackSnorm10(packed[i].normal), unpackSnorm10(packed[i].normal >> 10), unpackSnorm10(packed[i].normal >> 20));
+	}
+}
+
+static MeshStats measureMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t indexSize)
+{
+	MeshStats stats;
+	stats.vertices = (uint32_t)vertices.size();
+	stats.indices = (uint32_t)indices.size();
+	stats.vertexBytes = vertices.size() * sizeof(Vertex);
+	stats.indexBytes = indices.size() * indexSize;
+	stats.acmr = analyzeVertexCache(indices, stats.vertices);
+	return stats;
+}
+
+void optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, MeshStats& before, MeshStats& after)
+{
+	PROFILE_ZONE("optimizeMesh");
+
+	before = measureMesh(vertices, indices, sizeof(uint32_t));
+
+	uint32_t vertexCount = weldVertices(vertices, indices);
+	optimizeVertexCache(indices, vertexCount);
+	optimizeOverdraw(indices, vertices);
+	optimizeVertexFetch(vertices, indices);
+
+	after = measureMesh(vertices, indices, vertices.size() <= SHORT_INDEX_VERTICES ? sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+void printMeshStats(const std::string& name, const MeshStats& before, const MeshStats& after)
+{
+	std::cout << std::fixed << std::setprecision(3) << name << ": vertices " << before.vertices << " -> " << after.vertices
+		<< " (" << before.vertexBytes << " -> " << after.vertexBytes << " bytes), indices " << before.indices << " -> "
+		<< after.indices << " (" << before.indexBytes << " -> " << after.indexBytes << " bytes), ACMR " << before.acmr
+		<< " -> " << after.acmr << std::defaultfloat << std::endl;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+
+// FIFO post-transform cache the ACMR is measured against, what most GPUs behave closest to
+#define VERTEX_CACHE_SIZE 16u
+// LRU cache the triangle reordering scores vertices against
+#define VERTEX_CACHE_OPTIMIZE_SIZE 32u
+// overdraw reordering is kept only if the ACMR doesn't grow past this factor of the cache optimized order
+#define OVERDRAW_ACMR_THRESHOLD 1.05f
+// meshes with up to this many vertices get 16-bit indices
+#define SHORT_INDEX_VERTICES 65536u
+
+// size and vertex cache efficiency of a mesh, before and after optimizeMesh()
+struct MeshStats
+{
+	uint32_t vertices = 0;
+	uint32_t indices = 0;
+	size_t vertexBytes = 0;
+	size_t indexBytes = 0;
+	// average cache miss ratio: transformed vertices per triangle, 3 is no reuse at all and 0.5 the best a
+	// regular grid can do
+	float acmr = 0.0f;
+};
+
+// vertices transformed per triangle drawing indices in order through a FIFO cache of cacheSize vertices
+float analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+// merges bitwise identical vertices and remaps the indices, returns the new vertex count
+uint32_t weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// reorders triangles so vertices are reused while still in the post-transform cache (Forsyth's linear-speed
+// optimizer against an LRU cache of VERTEX_CACHE_OPTIMIZE_SIZE)
+void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+// reorders the clusters of a cache optimized triangle list so outward facing ones are drawn first and hide what's
+// behind them, the clusters are the runs between cache misses so ACMR barely moves; reverted if it grows past threshold
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = OVERDRAW_ACMR_THRESHOLD);
+
+// renumbers the vertices in the order the indices first use them, so vertex fetch walks memory linearly
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// the whole pipeline: weld, vertex cache, overdraw, vertex fetch; stats of the mesh before and after
+// index bytes of the result assume 16-bit indices when the vertex count allows
+void optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, MeshStats& before, MeshStats& after);
+
+// quantizes to PackedVertex: positions over the bounding box (scale/offset turn them back, see MeshData), uvs and
+// normals normalized, false and nothing written if a uv is outside [0, 1] and can't be stored as unorm16
+bool packVertices(const std::vector<Vertex>& vertices, std::vector<PackedVertex>& packed, glm::vec3& positionScale, glm::vec3& positionOffset);
+
+// float copy of a mesh's vertices in either layout, packed ones dequantized
+void unpackVertices(const MeshData& mesh, std::vector<Vertex>& vertices);
+
+// one line per mesh, "name: vertices a -> b, indices..."
+void printMeshStats(const std::string& name, const MeshStats& before, const MeshStats& after);
@@ -0,0 +1,719 @@
+#include "Microbench.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include <stb/stb_image.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "HeadlessContext.h"
+#include "Bodies.h"
+#include "BodyCatalog.h"
+#include "MinorPlanets.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "Population.h"
+#include "OrbitalEllipse.h"
+#include "AsteroidBelt.h"
+#include "LoadModel.h"
+#include "Shader.h"
+#include "Scene.h"
+#include "Framebuffer.h"
+#include "JobSystem.h"
+#include "GLErrors.h"
+#include "AssetLoader.h"
+#include "ShaderCache.h"
+#include "TextureCache.h"
+
+// smallest number of bodies handed to each job by the threaded cases
+#define MICROBENCH_BATCH 64u
+
+static volatile float sink;
+
+void Microbench::consume(float value)
+{
+	sink = sink + value;
+}
+
+bool Microbench::matches(const std::string& name, const std::string& params) const
+{
+	return m_filter.empty() || (name + " " + params).find(m_filter) != std::string::npos;
+}
+
+void Microbench::record(const std::string& name, const std::string& params, unsigned long long items,
+	unsigned long long iterations, std::vector<double>& samples)
+{
+	std::sort(samples.begin(), samples.end());
+
+	MicrobenchResult result;
+	result.name = name;
+	result.params = params;
+	result.items = items;
+	result.iterations = iterations;
+	result.nsPerOp = samples[samples.size() / 2];
+	result.minNsPerOp = samples.front();
+	m_results.push_back(result);
+
+	std::cout << std::left << std::setw(32) << name << std::setw(28) << params << std::right << std::fixed
+		<< std::setprecision(1) << std::setw(14) << result.nsPerOp << " ns/op" << std::setw(12)
+		<< result.nsPerOp / std::max(items, 1ull) << " ns/item" << std::defaultfloat << std::endl;
+}
+
+void Microbench::write(std::ostream& out) const
+{
+#ifdef NDEBUG
+	const char* build = "release";
+#else
+	const char* build = "debug";
+#endif
+
+	out << "# microbenchmarks build=" << build << " hardware_threads=" << std::thread::hardware_concurrency() << "\n"
+		<< "# name\tparams\titems\tns_per_op\tmin_ns_per_op\tns_per_item\n";
+
+	out << std::fixed << std::setprecision(1);
+	for (const auto& result : m_results)
+	{
+		out << result.name << "\t" << result.params << "\t" << result.items << "\t" << result.nsPerOp << "\t"
+			<< result.minNsPerOp << "\t" << result.nsPerOp / std::max(result.items, 1ull) << "\n";
+	}
+	out << std::defaultfloat;
+}
+
+bool Microbench::write(const std::string& path) const
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cout << "Failed to write microbenchmark results: " << path << std::endl;
+		return false;
+	}
+
+	write(out);
+
+	std::cout << "Wrote microbenchmark results: " << path << std::endl;
+	return true;
+}
+
+// synthetic system of the given size, the sun, then alternating planets and moons of the planet before them
+// bodies are as light as the store allows: orbit and spin, no name, mesh or orbit line
+static BodyStore makeBodies(unsigned int count)
+{
+	BodyStore bodies;
+	bodies.reserve(count);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		BodyId parent = i == 0 ? INVALID_BODY : (i % 2 == 1 ? 0 : i - 1);
+		BodyId body = bodies.createBody(parent);
+
+		if (parent != INVALID_BODY)
+		{
+			Orbit orbit;
+			orbit.a = parent == 0 ? 300.0 + i % 700 : 40.0;
+			orbit.b = orbit.a * 0.98;
+			orbit.period = parent == 0 ? 5.0 + i % 11 : 1.5;
+			orbit.angle = i * 17.0;
+			bodies.addOrbit(body, orbit);
+		}
+
+		Spin spin;
+		spin.axialTilt = 23.44;
+		spin.rotationSpeed = 360.99;
+		bodies.addSpin(body, spin);
+	}
+
+	bodies.updateTransforms();
+	return bodies;
+}
+
+// shared by the threaded cases, per slot sums keep the matrices from being optimized out
+struct BodyJob
+{
+	BodyStore* bodies;
+	double days;
+	unsigned int batchSize;
+	std::vector<float> sums;
+};
+
+static void updateOrbitsBatch(void* context, unsigned int index, unsigned int /*slot*/)
+{
+	BodyJob& job = *(BodyJob*)context;
+	size_t count = job.bodies->getOrbits().size();
+	size_t begin = std::min(size_t(index) * job.batchSize, count);
+	job.bodies->updateOrbits(job.days, begin, std::min(begin + job.batchSize, count));
+}
+
+static void modelMatrixBatch(void* context, unsigned int index, unsigned int slot)
+{
+	BodyJob& job = *(BodyJob*)context;
+	size_t count = job.bodies->getBodyCount();
+	size_t end = std::min(size_t(index + 1) * job.batchSize, count);
+	float sum = 0.0f;
+	for (size_t body = size_t(index) * job.batchSize; body < end; body++)
+	{
+		sum += job.bodies->getModelMatrix((BodyId)body)[3][0];
+	}
+	job.sums[slot] += sum;
+}
+
+// the body systems and model matrix building over body counts, serially (workers=0) and through the job system
+static void benchSimulation(Microbench& bench, Shader& shader)
+{
+	const unsigned int bodyCounts[] = { 16, 256, 4096, 1 << 20 };
+	const unsigned int workerCounts[] = { 1, 2, 4, 8 };
+	unsigned int hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (unsigned int count : bodyCounts)
+	{
+		std::string bodiesParam = "bodies=" + std::to_string(count);
+		if (!bench.matches("BodyStore", bodiesParam) && !bench.matches("exportToShader", bodiesParam))
+		{
+			continue;
+		}
+
+		BodyStore bodies = makeBodies(count);
+
+		bench.run("BodyStore::updateOrbits", bodiesParam + " workers=0", count, [&]()
+		{
+			bodies.updateOrbits(0.01);
+		});
+
+		bench.run("BodyStore::updateSpins", bodiesParam, count, [&]()
+		{
+			bodies.updateSpins(0.01);
+		});
+
+		// parents before children, so this one stays serial
+		bench.run("BodyStore::updateTransforms", bodiesParam, count, [&]()
+		{
+			bodies.updateTransforms();
+		});
+
+		bench.run("BodyStore::getModelMatrix", bodiesParam + " workers=0", count, [&]()
+		{
+			float sum = 0.0f;
+			for (BodyId body = 0; body < count; body++)
+			{
+				sum += bodies.getModelMatrix(body)[3][0];
+			}
+			Microbench::consume(sum);
+		});
+
+		for (unsigned int workers : workerCounts)
+		{
+			if (workers > hardwareThreads)
+			{
+				break;
+			}
+
+			std::string params = bodiesParam + " workers=" + std::to_string(workers);
+			if (!bench.matches("BodyStore::updateOrbits", params) && !bench.matches("BodyStore::getModelMatrix", params))
+			{
+				continue;
+			}
+
+			// enough batches to balance, few enough that the per batch overhead doesn't dominate
+			JobSystem jobs(workers);
+			BodyJob job = { &bodies, 0.01, std::max(MICROBENCH_BATCH, count / 64), std::vector<float>(jobs.getNumSlots(), 0.0f) };
+			unsigned int batches = (count + job.batchSize - 1) / job.batchSize;
+
+			bench.run("BodyStore::updateOrbits", params, count, [&]()
+			{
+				jobs.parallelFor(batches, updateOrbitsBatch, &job);
+			});
+
+			bench.run("BodyStore::getModelMatrix", params, count, [&]()
+			{
+				jobs.parallelFor(batches, modelMatrixBatch, &job);
+			});
+			for (float sum : job.sums)
+			{
+				Microbench::consume(sum);
+			}
+		}
+
+		// matrix building plus the glUniformMatrix4fv, GL thread only, and not worth a million uniform uploads
+		if (count <= 4096)
+		{
+			shader.bind();
+			int location = shader.getUniformLocation("model");
+			bench.run("exportToShader", bodiesParam, count, [&]()
+			{
+				for (BodyId body = 0; body < count; body++)
+				{
+					glUniformMatrix4fv(location, 1, GL_FALSE, &bodies.getModelMatrix(body)[0][0]);
+				}
+			});
+		}
+	}
+}
+
+// text catalog of count point-mass bodies (no models), planets and moons alternating like makeBodies()
+static bool writeSyntheticCatalog(const std::string& path, unsigned int count)
+{
+	std::ofstream out(path);
+	out << "body0 - 696340 7.25 14.18 0 0 0 0 -\n";
+	for (unsigned int i = 1; i < count; i++)
+	{
+		unsigned int parent = i % 2 == 1 ? 0 : i - 1;
+		double a = parent == 0 ? 300.0 + i % 700 : 40.0;
+		out << "body" << i << " body" << parent << " 1000 0 30 " << a << " " << a * 0.98 << " "
+			<< (parent == 0 ? 5.0 + i % 11 : 1.5) << " " << i * 17 << " -\n";
+	}
+	return bool(out);
+}
+
+// catalog parsing/mapping and turning it into bodies, without models so only the catalog itself is measured
+static void benchCatalog(Microbench& bench)
+{
+	const unsigned int bodyCounts[] = { 1000, 100000 };
+
+	for (unsigned int count : bodyCounts)
+	{
+		std::string bodiesParam = "bodies=" + std::to_string(count);
+		if (!bench.matches("BodyCatalog::load", bodiesParam) && !bench.matches("addCatalogBodies", bodiesParam))
+		{
+			continue;
+		}
+
+		const std::string textPath = "microbench_catalog.txt";
+		const std::string binaryPath = "microbench_catalog.bcat";
+		if (!writeSyntheticCatalog(textPath, count) || !compileCatalog(textPath, binaryPath))
+		{
+			std::cout << "Microbenchmark couldn't write a catalog, skipped" << std::endl;
+			continue;
+		}
+
+		bench.run("BodyCatalog::load", bodiesParam + " format=text", count, [&]()
+		{
+			BodyCatalog catalog;
+			catalog.load(textPath);
+			Microbench::consume(float(catalog.getBodyCount()));
+		});
+
+		bench.run("BodyCatalog::load", bodiesParam + " format=binary", count, [&]()
+		{
+			BodyCatalog catalog;
+			catalog.load(binaryPath);
+			Microbench::consume(float(catalog.getBodyCount()));
+		});
+
+		// scoped so the file is unmapped before it's removed, the catalog has no models so the arena stays empty
+		{
+			GeometryArena arena;
+			ResourceRegistry resources(arena);
+			BodyCatalog catalog;
+			if (catalog.load(binaryPath))
+			{
+				bench.run("addCatalogBodies", bodiesParam, count, [&]()
+				{
+					BodyStore bodies;
+					addCatalogBodies(bodies, resources, catalog, "");
+					Microbench::consume(bodies.getTransform(BodyId(count - 1)).world.x);
+				});
+			}
+		}
+
+		std::remove(textPath.c_str());
+		std::remove(binaryPath.c_str());
+	}
+}
+
+// MPCORB style file of count main belt objects, same columns as the real one after its preamble
+static bool writeSyntheticMpcorb(const std::string& path, unsigned int count)
+{
+	std::ofstream out(path, std::ios::binary);
+	out << "MINOR PLANET CENTER ORBIT DATABASE (MPCORB)\n"
+		<< "Des'n     H     G   Epoch     M        Peri.      Node       Incl.       e            n           a\n"
+		<< "--------------------------------------------------------------------------------------------------\n";
+
+	char line[256];
+	for (unsigned int i = 0; i < count; i++)
+	{
+		double a = 2.1 + (i % 1200) * 0.001;
+		std::snprintf(line, sizeof(line), "%07u %5.2f  0.15 K2555 %9.5f  %9.5f  %9.5f  %9.5f  %9.7f %11.8f %11.7f  0 E2024-V47  7330 125 1801-2024 0.80 M-v 30k MPCLINUX   4000      (%u)\n",
+			i + 1, 10.0 + (i % 90) * 0.1, (i * 37) % 360 + 0.12345, (i * 53) % 360 + 0.5, (i * 71) % 360 + 0.25,
+			(i % 30) + 0.125, (i % 300) * 0.001, 0.9856076686 / std::pow(a, 1.5), a, i + 1);
+		out << line;
+	}
+	return bool(out);
+}
+
+// fixed-width parsing and quantization over worker counts, then placing the ingested objects as belt instances and
+// paging them for streaming
+static void benchMinorPlanets(Microbench& bench)
+{
+	const unsigned int count = 100000;
+	const unsigned int workerCounts[] = { 1, 2, 4, 8 };
+	unsigned int hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	std::string objectsParam = "objects=" + std::to_string(count);
+	if (!bench.matches("ingestMinorPlanets", objectsParam) && !bench.matches("genMinorPlanetModels", objectsParam)
+		&& !bench.matches("buildPopulationPages", objectsParam))
+	{
+		return;
+	}
+
+	const std::string textPath = "microbench_mpcorb.dat";
+	const std::string binaryPath = "microbench_minor_planets.bin";
+	if (!writeSyntheticMpcorb(textPath, count))
+	{
+		std::cout << "Microbenchmark couldn't write an MPCORB file, skipped" << std::endl;
+		return;
+	}
+
+	for (unsigned int workers : workerCounts)
+	{
+		if (workers > hardwareThreads)
+		{
+			break;
+		}
+
+		JobSystem jobs(workers);
+		IngestStats stats;
+		bench.run("ingestMinorPlanets", objectsParam + " workers=" + std::to_string(workers), count, [&]()
+		{
+			ingestMinorPlanets(textPath, binaryPath, jobs, stats);
+		});
+	}
+
+	// scoped so the file is unmapped before it's removed
+	{
+		MinorPlanetCatalog minorPlanets;
+		if (minorPlanets.load(binaryPath))
+		{
+			bench.run("genMinorPlanetModels", objectsParam, count, [&]()
+			{
+				std::vector<glm::mat4> instanceMatrix = genMinorPlanetModels(minorPlanets);
+				Microbench::consume(instanceMatrix.back()[3][0]);
+			});
+
+			const std::string pagesPath = "microbench_minor_planets.pages";
+			bench.run("buildPopulationPages", objectsParam, count, [&]()
+			{
+				buildPopulationPages(minorPlanets, pagesPath);
+			});
+			std::remove(pagesPath.c_str());
+		}
+	}
+
+	std::remove(textPath.c_str());
+	std::remove(binaryPath.c_str());
+}
+
+// asteroid belt generation over instance counts, from the same seed every call
+static void benchAsteroids(Microbench& bench)
+{
+	const unsigned int instanceCounts[] = { 500, 5000, 50000 };
+
+	for (unsigned int count : instanceCounts)
+	{
+		bench.run("genAsteroidModels", "instances=" + std::to_string(count), count, [&]()
+		{
+			std::srand(1234u);
+			std::vector<glm::mat4> instanceMatrix = genAsteroidModels(count, 530.0, 40.0);
+			Microbench::consume(instanceMatrix.back()[3][0]);
+		});
+	}
+}
+
+// aiMesh to Vertex/index conversion and optimization, mesh cache hits against imports and texture decode/upload on the shipped models
+static void benchLoading(Microbench& bench, const SceneDirectories& directories)
+{
+	const char* models[] = { "asteroid", "jupiter" };
+	for (const char* model : models)
+	{
+		std::string params = std::string("model=") + model;
+		if (!bench.matches("processMesh", params))
+		{
+			continue;
+		}
+
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(directories.models + model + ".obj", aiProcess_Triangulate | aiProcess_FlipUVs);
+		if (!scene || scene->mNumMeshes == 0)
+		{
+			std::cout << "Microbenchmark couldn't load " << model << ".obj, skipped" << std::endl;
+			continue;
+		}
+
+		const aiMesh* mesh = scene->mMeshes[0];
+		bench.run("processMesh", params, mesh->mNumVertices, [&]()
+		{
+			std::vector<Vertex> vertices;
+			std::vector<GLuint> indices;
+			extractMeshData(mesh, vertices, indices);
+			Microbench::consume(vertices.back().Position.x + float(indices.back()));
+		});
+
+		// the import-time pipeline on the same triangle soup
+		std::vector<Vertex> soupVertices;
+		std::vector<GLuint> soupIndices;
+		extractMeshData(mesh, soupVertices, soupIndices);
+		bench.run("optimizeMesh", params, mesh->mNumVertices, [&]()
+		{
+			std::vector<Vertex> vertices = soupVertices;
+			std::vector<uint32_t> indices = soupIndices;
+			MeshStats before, after;
+			optimizeMesh(vertices, indices, before, after);
+			Microbench::consume(after.acmr);
+		});
+	}
+
+	// Assimp import against mapping the mesh cache, the cache is written by the first load if it isn't there yet
+	for (const char* model : models)
+	{
+		std::string path = directories.models + model + ".obj";
+		std::string params = std::string("model=") + model;
+
+		ModelData data;
+		if (!data.load(path))
+		{
+			std::cout << "Microbenchmark couldn't load " << model << ".obj, skipped" << std::endl;
+			continue;
+		}
+		unsigned long long vertices = data.getMeshes()[0].vertexCount;
+
+		bench.run("ModelData::import", params, vertices, [&]()
+		{
+			ModelData imported;
+			imported.import(path);
+			Microbench::consume(float(imported.getMeshes()[0].indexCount));
+		});
+		bench.run("ModelData::load/cached", params, vertices, [&]()
+		{
+			ModelData cached;
+			cached.load(path);
+			Microbench::consume(float(cached.getMeshes()[0].indexCount));
+		});
+	}
+
+	const char* textures[] = { "asteroid.png", "jupiter.jpg" };
+	for (const char* texture : textures)
+	{
+		std::string path = directories.models + texture;
+		int width = 0, height = 0, channels = 0;
+		if (!stbi_info(path.c_str(), &width, &height, &channels))
+		{
+			std::cout << "Microbenchmark couldn't read " << path << ", skipped" << std::endl;
+			continue;
+		}
+
+		std::string params = std::string("texture=") + texture;
+		unsigned long long pixels = (unsigned long long)width * height;
+
+		bench.run("TextureFromFile/decode", params, pixels, [&]()
+		{
+			int decodedWidth, decodedHeight, decodedChannels;
+			unsigned char* bytes = stbi_load(path.c_str(), &decodedWidth, &decodedHeight, &decodedChannels, 0);
+			Microbench::consume(bytes != nullptr ? float(bytes[0]) : 0.0f);
+			stbi_image_free(bytes);
+		});
+
+		// decode, upload and mipmap generation, glFinish so the driver's share of the upload is counted
+		bench.run("TextureFromFile", params, pixels, [&]()
+		{
+			unsigned int textureID = TextureFromFile(path);
+			glFinish();
+			glDeleteTextures(1, &textureID);
+		});
+
+		// building the texture cache against mapping it and uploading the prebuilt mip chain
+		if (!bench.matches("compressBC1", params) && !bench.matches("CompressedTexture::load/cached", params))
+		{
+			continue;
+		}
+		int decodedWidth, decodedHeight, decodedChannels;
+		unsigned char* bytes = stbi_load(path.c_str(), &decodedWidth, &decodedHeight, &decodedChannels, 0);
+		CompressedTexture compressed;
+		if (bytes == nullptr || !compressed.load(path, true))
+		{
+			stbi_image_free(bytes);
+			continue;
+		}
+
+		std::vector<uint8_t> blocks(compressedSizeBC1(decodedWidth, decodedHeight));
+		bench.run("compressBC1", params, pixels, [&]()
+		{
+			compressBC1(bytes, decodedWidth, decodedHeight, decodedChannels, blocks.data());
+			Microbench::consume(float(blocks[0]));
+		});
+		stbi_image_free(bytes);
+
+		if (isTextureCompressionSupported())
+		{
+			bench.run("CompressedTexture::load/cached", params, pixels, [&]()
+			{
+				CompressedTexture cached;
+				cached.load(path, true);
+				unsigned int textureID = uploadCompressedTexture(cached);
+				glFinish();
+				glDeleteTextures(1, &textureID);
+			});
+		}
+	}
+
+	// the whole scene's models, textures and skybox through the asset loader over worker counts, from start() to the
+	// last upload, the same as a cold scene start with the caches built
+	BodyCatalog catalog;
+	if (!bench.matches("AssetLoader::load", "workers=") || !catalog.load(directories.catalog))
+	{
+		return;
+	}
+	std::vector<std::string> modelPaths = getCatalogModels(catalog, directories.models);
+	modelPaths.push_back(directories.models + "asteroid.obj");
+	std::string skyboxFaces[6];
+	Skybox::getTexturePaths(directories.skybox, skyboxFaces);
+
+	const unsigned int workerCounts[] = { 1, 2, 4, 8 };
+	unsigned int hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	for (unsigned int workers : workerCounts)
+	{
+		if (workers > hardwareThreads)
+		{
+			break;
+		}
+
+		JobSystem jobs(workers);
+		bench.run("AssetLoader::load", "workers=" + std::to_string(workers), modelPaths.size() + 6, [&]()
+		{
+			GeometryArena geometry;
+			ResourceRegistry resources{ geometry };
+			AssetLoader loader(jobs, resources);
+			for (const std::string& path : modelPaths)
+			{
+				loader.addModel(path);
+			}
+			unsigned int skybox = loader.addCubeMap(skyboxFaces);
+			loader.load();
+			glFinish();
+
+			unsigned int cubeMap = loader.getCubeMap(skybox);
+			glDeleteTextures(1, &cubeMap);
+		});
+	}
+}
+
+// the asteroid belt's instanced draw from float and packed vertices of the same (dequantized) geometry, glFinish so
+// the GPU's vertex fetch is what's measured
+static void benchVertexLayouts(Microbench& bench, const SceneDirectories& directories)
+{
+	const unsigned int instances = 50000;
+	std::string instancesParam = "instances=" + std::to_string(instances);
+	if (!bench.matches("asteroidDraw", "layout=float " + instancesParam) && !bench.matches("asteroidDraw", "layout=packed " + instancesParam))
+	{
+		return;
+	}
+
+	ModelData model;
+	if (!model.load(directories.models + "asteroid.obj") || model.getMeshes()[0].layout != VertexLayout::Packed)
+	{
+		std::cout << "Microbenchmark couldn't load a packed asteroid.obj, skipped" << std::endl;
+		return;
+	}
+
+	const MeshData& packed = model.getMeshes()[0];
+	std::vector<Vertex> vertices;
+	unpackVertices(packed, vertices);
+	MeshData unpacked = packed;
+	unpacked.vertices = vertices.data();
+	unpacked.layout = VertexLayout::Float;
+	unpacked.positionScale = glm::vec3(1.0f);
+	unpacked.positionOffset = glm::vec3(0.0f);
+
+	std::srand(1234u);
+	std::vector<glm::mat4> instanceMatrix = genAsteroidModels(instances, 530.0, 40.0);
+
+	Shader shader((directories.shaders + "asteroid.vert").c_str(), (directories.shaders + "asteroid.frag").c_str());
+	Camera camera(1280, 720, 45.0f, 0.1f, 5000.0f, glm::vec3(0.0f, 600.0f, 900.0f), glm::normalize(glm::vec3(0.0f, -600.0f, -900.0f)));
+	shader.bind();
+	camera.exportToShader(shader, "camMatrix");
+	ProgramSlot program = shader.getProgramSlot();
+
+	Framebuffer framebuffer(1280, 720);
+	framebuffer.bind();
+	glEnable(GL_DEPTH_TEST);
+
+	GeometryArena geometry;
+	ResourceRegistry resources(geometry);
+	GLStateCache stateCache;
+	RenderQueue queue;
+	FrameArena arena;
+	std::vector<CommandList> lists(1);
+
+	const MeshData* layouts[] = { &unpacked, &packed };
+	for (const MeshData* data : layouts)
+	{
+		Mesh mesh(resources, *data, Texture{ 0, "" }, float(instances), instanceMatrix);
+		size_t vertexBytes = size_t(data->vertexCount) * getVertexSize(data->layout);
+		std::string params = std::string("layout=") + (data->layout == VertexLayout::Packed ? "packed" : "float")
+			+ " vertexBytes=" + std::to_string(vertexBytes) + " " + instancesParam;
+
+		bench.run("asteroidDraw", params, instances, [&]()
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			lists[0].clear();
+			mesh.record(lists[0], program, RenderLayer::Opaque, RenderPass::Asteroids, nullptr, 0.0f);
+			stateCache.invalidate();
+			queue.submit(lists, stateCache, arena, nullptr);
+			arena.reset();
+			glFinish();
+		});
+	}
+}
+
+static void benchOrbits(Microbench& bench)
+{
+	OrbitalEllipse ellipse(650.0f, 640.0f);
+
+	const unsigned int vertexCounts[] = { 100, NUM_VERTICES };
+	for (unsigned int count : vertexCounts)
+	{
+		bench.run("OrbitalEllipse::initVertices", "vertices=" + std::to_string(count), count, [&]()
+		{
+			ellipse.initVertices(650.0f, 640.0f, count);
+		});
+	}
+}
+
+int runMicrobenchmarks(const AppOptions& options)
+{
+	HeadlessContext context;
+	if (!context.create())
+	{
+		return -1;
+	}
+
+	initGLDebugOutput(context.getLoader(), options.glDebugSynchronous, options.glGetErrorChecks);
+	initShaderCompile(context.getLoader());
+
+	SceneDirectories directories;
+	Shader shader((directories.shaders + "default.vert").c_str(), (directories.shaders + "default.frag").c_str());
+
+	Microbench bench(options.microbenchFilter);
+	benchSimulation(bench, shader);
+	benchCatalog(bench);
+	benchMinorPlanets(bench);
+	benchAsteroids(bench);
+	benchLoading(bench, directories);
+	benchVertexLayouts(bench, directories);
+	benchOrbits(bench);
+
+	if (bench.getResults().empty())
+	{
+		std::cout << "No microbenchmark matches: " << options.microbenchFilter << std::endl;
+		return -1;
+	}
+
+	return bench.write(options.timingsPath.empty() ? "microbench.tsv" : options.timingsPath) ? 0 : -1;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "CommandLine.h"
+#include "Profiler.h"
+
+// each sample runs the case for at least this long, iterations are doubled until it does
+#define MICROBENCH_SAMPLE_NS 20000000ull
+// samples per case, the median is reported
+#define MICROBENCH_SAMPLES 7
+#define MICROBENCH_MAX_ITERATIONS (1ull << 24)
+
+// timings of one case, per op is one call of the timed body
+struct MicrobenchResult
+{
+	std::string name;
+	std::string params;
+	unsigned long long items = 0;
+	unsigned long long iterations = 0;
+	double nsPerOp = 0.0;
+	double minNsPerOp = 0.0;
+};
+
+/*
+* Tiny benchmark harness for the simulation/loading hot paths
+* Cases are identified by name plus a parameter string ("bodies=256 workers=4"), results are written one line per
+* case in registration order with no timestamps, so two runs on the same machine can be diffed directly.
+* New implementations of a hot path should be added next to the case of the one they replace.
+*/
+class Microbench
+{
+private:
+	std::string m_filter;
+	std::vector<MicrobenchResult> m_results;
+
+	void record(const std::string& name, const std::string& params, unsigned long long items,
+		unsigned long long iterations, std::vector<double>& samples);
+
+public:
+	explicit Microbench(const std::string& filter) : m_filter(filter) {}
+
+	// whether the case passes the --filter, matched against "name params"
+	bool matches(const std::string& name, const std::string& params) const;
+
+	// times body(), which processes items items (bodies, instances, vertices...) per call
+	template <typename Function>
+	void run(const std::string& name, const std::string& params, unsigned long long items, Function body);
+
+	// keeps a result alive so the compiler can't drop the work that produced it
+	static void consume(float value);
+
+	const std::vector<MicrobenchResult>& getResults() const { return m_results; }
+
+	// tab separated, '#' header lines
+	void write(std::ostream& out) const;
+	bool write(const std::string& path) const;
+};
+
+template <typename Function>
+void Microbench::run(const std::string& name, const std::string& params, unsigned long long items, Function body)
+{
+	if (!matches(name, params))
+	{
+		return;
+	}
+
+	unsigned long long iterations = 1;
+	while (iterations < MICROBENCH_MAX_ITERATIONS)
+	{
+		uint64_t start = Profiler::now();
+		for (unsigned long long i = 0; i < iterations; i++)
+		{
+			body();
+		}
+		if (Profiler::now() - start >= MICROBENCH_SAMPLE_NS)
+		{
+			break;
+		}
+		iterations *= 2;
+	}
+
+	std::vector<double> samples;
+	for (int sample = 0; sample < MICROBENCH_SAMPLES; sample++)
+	{
+		uint64_t start = Profiler::now();
+		for (unsigned long long i = 0; i < iterations; i++)
+		{
+			body();
+		}
+		samples.push_back(double(Profiler::now() - start) / iterations);
+	}
+
+	record(name, params, items, iterations, samples);
+}
+
+// runs every case in a headless GL context (uploads are part of what's measured), returns the process exit code
+int runMicrobenchmarks(const AppOptions& options);
@@ -0,0 +1,390 @@
+#include "MinorPlanets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+#include "Profiler.h"
+#include "StartupTimeline.h"
+
+// 0-based start column and width of the fields that are kept, per the MPC orbit format
+#define MPC_H 8, 5
+#define MPC_MEAN_ANOMALY 26, 9
+#define MPC_PERIHELION 37, 9
+#define MPC_NODE 48, 9
+#define MPC_INCLINATION 59, 9
+#define MPC_ECCENTRICITY 70, 9
+#define MPC_SEMI_MAJOR_AXIS 92, 11
+// shortest line that holds all of them
+#define MPC_MIN_LINE 103
+
+// eccentricities of 0.9999924 and up would round to 65535, which comes back as exactly 1: a parabola, not an orbit
+#define PACKED_E_MAX 65534
+
+static uint16_t quantize(double value, double min, double max)
+{
+	double t = std::min(std::max((value - min) / (max - min), 0.0), 1.0);
+	return uint16_t(t * 65535.0 + 0.5);
+}
+
+static double dequantize(uint16_t value, double min, double max)
+{
+	return min + (max - min) * (value / 65535.0);
+}
+
+static uint16_t quantizeEccentricity(double e)
+{
+	return std::min(quantize(e, 0.0, 1.0), uint16_t(PACKED_E_MAX));
+}
+
+// fixed-width decimal field, blank padded, no exponents (the MPC format has none), false if it isn't one
+// hand rolled because it runs for every field of every line and strtod wants a terminated copy and the locale
+static bool parseField(const char* line, int start, int width, double& value)
+{
+	const char* p = line + start;
+	const char* end = p + width;
+
+	while (p < end && *p == ' ')
+	{
+		p++;
+	}
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	double result = 0.0;
+	int digits = 0;
+	for (; p < end && *p >= '0' && *p <= '9'; p++, digits++)
+	{
+		result = result * 10.0 + (*p - '0');
+	}
+
+	if (p < end && *p == '.')
+	{
+		double scale = 0.1;
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++, scale *= 0.1)
+		{
+			result += (*p - '0') * scale;
+		}
+	}
+
+	while (p < end && *p == ' ')
+	{
+		p++;
+	}
+
+	if (digits == 0 || p != end)
+	{
+		return false;
+	}
+
+	value = negative ? -result : result;
+	return true;
+}
+
+// input range of one job and what came out of it, reused across windows so the vectors keep their capacity
+struct IngestBlock
+{
+	const char* begin = nullptr;
+	const char* end = nullptr;
+	std::vector<PackedElements> elements;
+	uint32_t skippedLines = 0;
+	uint32_t rejected = 0;
+};
+
+static void parseLine(const char* line, size_t length, IngestBlock& block)
+{
+	OrbitalElements elements;
+	if (length < MPC_MIN_LINE
+		|| !parseField(line, MPC_MEAN_ANOMALY, elements.meanAnomaly)
+		|| !parseField(line, MPC_PERIHELION, elements.perihelion)
+		|| !parseField(line, MPC_NODE, elements.node)
+		|| !parseField(line, MPC_INCLINATION, elements.inclination)
+		|| !parseField(line, MPC_ECCENTRICITY, elements.e)
+		|| !parseField(line, MPC_SEMI_MAJOR_AXIS, elements.a))
+	{
+		block.skippedLines++;
+		return;
+	}
+
+	if (!parseField(line, MPC_H, elements.magnitude))
+	{
+		elements.magnitude = MINOR_PLANET_DEFAULT_H;
+	}
+
+	if (elements.e < 0.0 || elements.e >= 1.0 || elements.a < MINOR_PLANET_A_MIN || elements.a > MINOR_PLANET_A_MAX)
+	{
+		block.rejected++;
+		return;
+	}
+
+	PackedElements packed;
+	packed.a = quantize(std::log2(elements.a), std::log2(MINOR_PLANET_A_MIN), std::log2(MINOR_PLANET_A_MAX));
+	packed.e = quantizeEccentricity(elements.e);
+	packed.inclination = quantize(elements.inclination, 0.0, 180.0);
+	packed.node = quantize(elements.node, 0.0, 360.0);
+	packed.perihelion = quantize(elements.perihelion, 0.0, 360.0);
+	packed.meanAnomaly = quantize(elements.meanAnomaly, 0.0, 360.0);
+	packed.magnitude = quantize(elements.magnitude, MINOR_PLANET_H_MIN, MINOR_PLANET_H_MAX);
+	block.elements.push_back(packed);
+}
+
+static void ingestBlock(void* context, unsigned int index, unsigned int /*slot*/)
+{
+	PROFILE_ZONE("ingestBlock");
+
+	IngestBlock& block = ((IngestBlock*)context)[index];
+	block.elements.clear();
+	block.skippedLines = 0;
+	block.rejected = 0;
+
+	const char* line = block.begin;
+	while (line < block.end)
+	{
+		const char* newline = (const char*)std::memchr(line, '\n', block.end - line);
+		const char* lineEnd = newline != nullptr ? newline : block.end;
+		parseLine(line, lineEnd - line, block);
+		line = lineEnd + 1;
+	}
+}
+
+// first byte of the line following offset, so blocks split between lines
+static size_t nextLineStart(const char* data, size_t size, size_t offset)
+{
+	if (offset == 0 || offset >= size)
+	{
+		return std::min(offset, size);
+	}
+
+	const char* newline = (const char*)std::memchr(data + offset - 1, '\n', size - offset + 1);
+	return newline != nullptr ? size_t(newline - data) + 1 : size;
+}
+
+bool ingestMinorPlanets(const std::string& inputPath, const std::string& outputPath, JobSystem& jobs, IngestStats& stats)
+{
+	PROFILE_ZONE("ingestMinorPlanets");
+
+	uint64_t start = Profiler::now();
+	stats = IngestStats();
+
+	MappedFile input;
+	if (!input.open(inputPath))
+	{
+		return false;
+	}
+
+	std::ofstream out(outputPath, std::ios::binary);
+	if (!out)
+	{
+		std::cout << "Failed to write minor planets: " << outputPath << std::endl;
+		return false;
+	}
+
+	// the count is filled in once everything is written
+	MinorPlanetHeader header = { MINOR_PLANET_MAGIC, MINOR_PLANET_VERSION, 0, sizeof(PackedElements) };
+	out.write((const char*)&header, sizeof(header));
+
+	const char* data = (const char*)input.getData();
+	size_t size = input.getSize();
+	std::vector<IngestBlock> window(jobs.getNumSlots() * MINOR_PLANET_INGEST_WINDOW);
+
+	size_t offset = 0;
+	while (offset < size)
+	{
+		unsigned int blocks = 0;
+		for (; blocks < window.size() && offset < size; blocks++)
+		{
+			size_t end = nextLineStart(data, size, offset + MINOR_PLANET_INGEST_BLOCK);
+			window[blocks].begin = data + offset;
+			window[blocks].end = data + end;
+			offset = end;
+		}
+
+		jobs.parallelFor(blocks, ingestBlock, window.data());
+
+		// in input order, so the output is the same whatever the number of workers
+		for (unsigned int i = 0; i < blocks; i++)
+		{
+			const IngestBlock& block = window[i];
+			out.write((const char*)block.elements.data(), block.elements.size() * sizeof(PackedElements));
+			stats.objects += (uint32_t)block.elements.size();
+			stats.skippedLines += block.skippedLines;
+			stats.rejected += block.rejected;
+		}
+	}
+
+	header.count = stats.objects;
+	out.seekp(0);
+	out.write((const char*)&header, sizeof(header));
+	out.close();
+
+	if (!out)
+	{
+		std::cout << "Failed to write minor planets: " << outputPath << std::endl;
+		return false;
+	}
+
+	stats.inputBytes = size;
+	stats.outputBytes = sizeof(header) + uint64_t(stats.objects) * sizeof(PackedElements);
+	stats.seconds = double(Profiler::now() - start) * 1e-9;
+	return true;
+}
+
+void printIngestStats(const IngestStats& stats)
+{
+	double megabytes = stats.inputBytes / (1024.0 * 1024.0);
+	std::cout << "Ingested " << stats.objects << " minor planets (" << stats.skippedLines << " lines skipped, "
+		<< stats.rejected << " rejected) from " << megabytes << " MB in " << stats.seconds * 1000.0 << " ms: "
+		<< (stats.seconds > 0.0 ? megabytes / stats.seconds : 0.0) << " MB/s, "
+		<< (stats.objects > 0 ? double(stats.outputBytes) / stats.objects : 0.0) << " bytes per object" << std::endl;
+}
+
+bool synthesizeMinorPlanets(uint64_t count, const std::string& outputPath)
+{
+	PROFILE_ZONE("synthesizeMinorPlanets");
+
+	if (count > 0xFFFFFFFFull)
+	{
+		std::cout << "Too many minor planets for one file: " << count << std::endl;
+		return false;
+	}
+
+	std::ofstream out(outputPath, std::ios::binary);
+	if (!out)
+	{
+		std::cout << "Failed to write minor planets: " << outputPath << std::endl;
+		return false;
+	}
+
+	MinorPlanetHeader header = { MINOR_PLANET_MAGIC, MINOR_PLANET_VERSION, (uint32_t)count, sizeof(PackedElements) };
+	out.write((const char*)&header, sizeof(header));
+
+	// fixed seed, the same count always gives the same file
+	std::mt19937 random(1234u);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	std::vector<PackedElements> batch;
+	batch.reserve(65536);
+	for (uint64_t i = 0; i < count; i++)
+	{
+		// 2.1 to 3.3 AU, mostly low eccentricity and inclination, fainter objects far more common
+		double a = 2.1 + 1.2 * uniform(random);
+		double e = 0.3 * uniform(random) * uniform(random);
+		double inclination = 30.0 * uniform(random) * uniform(random);
+		double magnitude = 20.0 - 8.0 * uniform(random) * uniform(random);
+
+		PackedElements packed;
+		packed.a = quantize(std::log2(a), std::log2(MINOR_PLANET_A_MIN), std::log2(MINOR_PLANET_A_MAX));
+		packed.e = quantizeEccentricity(e);
+		packed.inclination = quantize(inclination, 0.0, 180.0);
+		packed.node = quantize(360.0 * uniform(random), 0.0, 360.0);
+		packed.perihelion = quantize(360.0 * uniform(random), 0.0, 360.0);
+		packed.meanAnomaly = quantize(360.0 * uniform(random), 0.0, 360.0);
+		packed.magnitude = quantize(magnitude, MINOR_PLANET_H_MIN, MINOR_PLANET_H_MAX);
+		batch.push_back(packed);
+
+		if (batch.size() == batch.capacity() || i + 1 == count)
+		{
+			out.write((const char*)batch.data(), batch.size() * sizeof(PackedElements));
+			batch.clear();
+		}
+	}
+
+	if (!out)
+	{
+		std::cout << "Failed to write minor planets: " << outputPath << std::endl;
+		return false;
+	}
+
+	std::cout << "Synthesized " << count << " minor planets: " << outputPath << std::endl;
+	return true;
+}
+
+bool MinorPlanetCatalog::load(const std::string& path)
+{
+	PROFILE_ZONE("MinorPlanetCatalog::load");
+	STARTUP_ASSET("MinorPlanetCatalog::load", path);
+
+	m_elements = nullptr;
+	m_count = 0;
+
+	if (!m_file.open(path))
+	{
+		return false;
+	}
+
+	const MinorPlanetHeader* header = (const MinorPlanetHeader*)m_file.getData();
+	if (m_file.getSize() < sizeof(MinorPlanetHeader) || header->magic != MINOR_PLANET_MAGIC
+		|| header->version != MINOR_PLANET_VERSION || header->elementSize != sizeof(PackedElements))
+	{
+		std::cout << "Not a minor planet file of this version: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	if (m_file.getSize() != sizeof(MinorPlanetHeader) + size_t(header->count) * sizeof(PackedElements))
+	{
+		std::cout << "Minor planet file size doesn't match its header: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	m_elements = (const PackedElements*)(m_file.getData() + sizeof(MinorPlanetHeader));
+	m_count = header->count;
+	return true;
+}
+
+OrbitalElements unpackElements(const PackedElements& packed)
+{
+	OrbitalElements elements;
+	elements.a = std::exp2(dequantize(packed.a, std::log2(MINOR_PLANET_A_MIN), std::log2(MINOR_PLANET_A_MAX)));
+	// binaries ingested before the clamp can still hold 65535
+	elements.e = dequantize(std::min(packed.e, uint16_t(PACKED_E_MAX)), 0.0, 1.0);
+	elements.inclination = dequantize(packed.inclination, 0.0, 180.0);
+	elements.node = dequantize(packed.node, 0.0, 360.0);
+	elements.perihelion = dequantize(packed.perihelion, 0.0, 360.0);
+	elements.meanAnomaly = dequantize(packed.meanAnomaly, 0.0, 360.0);
+	elements.magnitude = dequantize(packed.magnitude, MINOR_PLANET_H_MIN, MINOR_PLANET_H_MAX);
+	return elements;
+}
+
+glm::dvec3 getEclipticPosition(const OrbitalElements& elements)
+{
+	double e = elements.e;
+	double meanAnomaly = glm::radians(elements.meanAnomaly);
+
+	// Kepler's equation M = E - e sin(E) by Newton's method, starting from pi for very eccentric orbits
+	double eccentricAnomaly = e > 0.8 ? glm::pi<double>() : meanAnomaly;
+	for (int i = 0; i < 16; i++)
+	{
+		double step = (eccentricAnomaly - e * std::sin(eccentricAnomaly) - meanAnomaly) / (1.0 - e * std::cos(eccentricAnomaly));
+		eccentricAnomaly -= step;
+		if (std::abs(step) < 1e-10)
+		{
+			break;
+		}
+	}
+
+	// in the orbital plane, x towards perihelion
+	double x = elements.a * (std::cos(eccentricAnomaly) - e);
+	double y = elements.a * std::sqrt(1.0 - e * e) * std::sin(eccentricAnomaly);
+
+	double cosPerihelion = std::cos(glm::radians(elements.perihelion)), sinPerihelion = std::sin(glm::radians(elements.perihelion));
+	double cosNode = std::cos(glm::radians(elements.node)), sinNode = std::sin(glm::radians(elements.node));
+	double cosInclination = std::cos(glm::radians(elements.inclination)), sinInclination = std::sin(glm::radians(elements.inclination));
+
+	return glm::dvec3(
+		x * (cosPerihelion * cosNode - sinPerihelion * sinNode * cosInclination) - y * (sinPerihelion * cosNode + cosPerihelion * sinNode * cosInclination),
+		x * (cosPerihelion * sinNode + sinPerihelion * cosNode * cosInclination) - y * (sinPerihelion * sinNode - cosPerihelion * cosNode * cosInclination),
+		x * sinPerihelion * sinInclination + y * cosPerihelion * sinInclination);
+}
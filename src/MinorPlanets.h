@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "MappedFile.h"
+#include "JobSystem.h"
+
+// "MPLB" read as a little endian uint32_t, first thing in an ingested minor planet file
+#define MINOR_PLANET_MAGIC 0x424C504Du
+#define MINOR_PLANET_VERSION 1u
+
+// quantization ranges, semi-major axis is quantized logarithmically so near earth objects and the kuiper belt
+// both keep ~1e-4 relative precision, objects outside [A_MIN, A_MAX] AU are dropped at ingest
+#define MINOR_PLANET_A_MIN 0.1
+#define MINOR_PLANET_A_MAX 1000.0
+#define MINOR_PLANET_H_MIN -2.0
+#define MINOR_PLANET_H_MAX 34.0
+// absolute magnitude of objects whose H column is blank
+#define MINOR_PLANET_DEFAULT_H 18.0
+
+// input bytes parsed per job, and jobs per window (times the job slots) kept in memory before being written
+#define MINOR_PLANET_INGEST_BLOCK (1u << 20)
+#define MINOR_PLANET_INGEST_WINDOW 4
+
+// start of an ingested file, followed by count PackedElements
+struct MinorPlanetHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t elementSize;
+};
+
+// quantized orbital elements of one object, every field spans its whole range in 16 bits
+struct PackedElements
+{
+	uint16_t a;
+	uint16_t e;
+	uint16_t inclination;
+	uint16_t node;
+	uint16_t perihelion;
+	uint16_t meanAnomaly;
+	uint16_t magnitude;
+};
+
+static_assert(sizeof(MinorPlanetHeader) == 16, "minor planet file layout changed");
+static_assert(sizeof(PackedElements) == 14, "minor planet file layout changed");
+
+// dequantized elements, AU and degrees (J2000 ecliptic), H is the absolute magnitude
+// epochs aren't kept, every object starts at its mean anomaly at its own epoch
+struct OrbitalElements
+{
+	double a;
+	double e;
+	double inclination;
+	double node;
+	double perihelion;
+	double meanAnomaly;
+	double magnitude;
+};
+
+// what ingestMinorPlanets() read and wrote, and how fast
+struct IngestStats
+{
+	uint64_t inputBytes = 0;
+	uint64_t outputBytes = 0;
+	uint32_t objects = 0;
+	// header, blank or malformed lines
+	uint32_t skippedLines = 0;
+	// parsed but unbound (e >= 1) or outside the semi-major axis range
+	uint32_t rejected = 0;
+	double seconds = 0.0;
+};
+
+OrbitalElements unpackElements(const PackedElements& packed);
+
+/*
+* Ingested minor planet population, mapped and used in place
+* load() checks the header and size, after that elements are dequantized straight out of the mapping on demand.
+*/
+class MinorPlanetCatalog
+{
+private:
+	MappedFile m_file;
+	const PackedElements* m_elements = nullptr;
+	uint32_t m_count = 0;
+
+public:
+	// prints why and returns false if the file isn't a minor planet file of this version
+	bool load(const std::string& path);
+
+	uint32_t getCount() const { return m_count; }
+	const PackedElements* getPackedElements() const { return m_elements; }
+	OrbitalElements getElements(uint32_t index) const { return unpackElements(m_elements[index]); }
+};
+
+/*
+* MPCORB style fixed-width text (https://minorplanetcenter.net/iau/info/MPOrbitFormat.html) to the quantized binary
+* The input is mapped and split into blocks at line boundaries, a window of blocks is parsed on the job system, then
+* written in order, so memory stays bounded by the window whatever the input size. Lines that aren't orbit records
+* (the MPCORB.DAT preamble, blank lines) are skipped.
+*/
+bool ingestMinorPlanets(const std::string& inputPath, const std::string& outputPath, JobSystem& jobs, IngestStats& stats);
+
+// MB/s and bytes per object
+void printIngestStats(const IngestStats& stats);
+
+// main belt like population of count objects straight to the quantized binary, for populations far larger than any
+// real catalog, streamed out so memory doesn't grow with count
+bool synthesizeMinorPlanets(uint64_t count, const std::string& outputPath);
+
+// heliocentric position in AU at the epoch, x/y in the ecliptic plane
+glm::dvec3 getEclipticPosition(const OrbitalElements& elements);
@@ -0,0 +1,40 @@
+#include "NameTable.h"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+static std::mutex namesMutex;
+static std::unordered_map<std::string, NameId> nameIds;
+// a deque so references handed out by getName() stay valid while new names are added
+static std::deque<std::string> names;
+
+NameId internName(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(namesMutex);
+
+	auto it = nameIds.find(name);
+	if (it != nameIds.end())
+	{
+		return it->second;
+	}
+
+	NameId id = (NameId)names.size();
+	names.push_back(name);
+	nameIds.emplace(name, id);
+	return id;
+}
+
+NameId findName(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(namesMutex);
+
+	auto it = nameIds.find(name);
+	return it != nameIds.end() ? it->second : INVALID_NAME_ID;
+}
+
+const std::string& getName(NameId id)
+{
+	std::lock_guard<std::mutex> lock(namesMutex);
+	return names[id];
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// interned name, compares as an integer
+typedef uint32_t NameId;
+
+#define INVALID_NAME_ID 0xFFFFFFFFu
+
+// returns the id of the name, adding it to the global table the first time it's seen
+// takes a lock and may allocate, so intern at load time and keep the id around for per frame comparisons
+NameId internName(const std::string& name);
+
+// id of a name that was already interned, INVALID_NAME_ID if it never was (doesn't add it)
+NameId findName(const std::string& name);
+
+const std::string& getName(NameId id);
@@ -52,14 +52,32 @@ void OrbitalEllipse::initIndices(unsigned int numVertices)
     m_indices[(numVertices - 1) * 2 + 1] = 0;
 }
 
-void OrbitalEllipse::draw(Shader& shader, glm::mat4 model) {
+void OrbitalEllipse::exportColorToShader(Shader& shader) {
     shader.bind();
-    GLCall(glUniformMatrix4fv(glGetUniformLocation(shader.m_ID, "model"), 1, GL_FALSE, &model[0][0]));
-    GLCall(glUniform3fv(glGetUniformLocation(shader.m_ID, "color"), 1, &m_lineColor[0]));
+    GLCall(glUniform3fv(shader.getUniformLocation("color"), 1, &m_lineColor[0]));
+}
+
+void OrbitalEllipse::record(CommandList& list, const ProgramSlot& program, const glm::mat4& model) const {
+    DrawCommand command;
+    command.program = program.program;
+    command.geometry = m_VAO;
+    command.texture = 0;
+    command.instanceBuffer = 0;
+    command.modelSlot = program.modelSlot;
+    command.dequantizeSlot = -1;
+    command.dequantize = nullptr;
+    command.indexCount = m_numIndices;
+    command.indexType = GL_UNSIGNED_INT;
+    command.indexOffset = 0;
+    command.baseVertex = 0;
+    command.firstInstance = 0;
+    command.instanceCount = 1;
+    command.primitive = Primitive::Lines;
+    command.pass = RenderPass::Orbits;
 
-    GLCall(glBindVertexArray(m_VAO));
-    //glDrawArrays(GL_LINES, 0, 2);
-    GLCall(glDrawElements(GL_LINES, m_numIndices, GL_UNSIGNED_INT, 0));
+    // lines have no use for depth ordering, only group by program/VAO
+    command.sortKey = CommandList::makeSortKey(RenderLayer::Lines, program.program, 0.0f, 0, m_VAO);
+    list.push(command, &model);
 }
 
 OrbitalEllipse::~OrbitalEllipse() {
@@ -9,6 +9,7 @@
 
 #include "Shader.h"
 #include "GLErrors.h"
+#include "CommandList.h"
 
 #define PI 3.1415926
 #define NUM_VERTICES 1000
@@ -24,15 +25,19 @@ class OrbitalEllipse {
 
     glm::vec3 m_lineColor = glm::vec3(1.f, 1.f, 1.f);
 
-    // initialize vertices data
+public:
+    // initialize vertices data (public for the microbenchmarks, doesn't upload)
     void initVertices(float a, float b, unsigned int numVertices);
 
     // initialize indices data
     void initIndices(unsigned int numVertices);
 
-public:
     OrbitalEllipse(float a, float b);
     ~OrbitalEllipse();
 
-    void draw(Shader& shader, glm::mat4 model);
+    // line color is the same for every ellipse, set it once on the orbit shader
+    void exportColorToShader(Shader& shader);
+
+    // records a draw command for the ellipse around the given orbital focus, doesn't touch GL
+    void record(CommandList& list, const ProgramSlot& program, const glm::mat4& model) const;
 };
\ No newline at end of file
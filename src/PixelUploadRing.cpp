@@ -0,0 +1,109 @@
+#include "PixelUploadRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "GLErrors.h"
+#include "Profiler.h"
+#include "StartupTimeline.h"
+
+PixelUploadRing::~PixelUploadRing()
+{
+	for (Slot& slot : m_slots)
+	{
+		if (slot.fence != nullptr)
+		{
+			glDeleteSync(slot.fence);
+		}
+		if (slot.buffer != 0)
+		{
+			glDeleteBuffers(1, &slot.buffer);
+		}
+	}
+}
+
+bool PixelUploadRing::stage(const void* data, size_t size, size_t copySize)
+{
+	Slot& slot = m_slots[m_next];
+	m_next = (m_next + 1) % PIXEL_UPLOAD_BUFFERS;
+
+	// the copy out of this buffer from its last upload has to be done before it's written again
+	if (slot.fence != nullptr)
+	{
+		PROFILE_ZONE("PixelUploadRing::wait");
+		while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull) == GL_TIMEOUT_EXPIRED)
+		{
+		}
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+	}
+
+	if (slot.buffer == 0)
+	{
+		GLCall(glGenBuffers(1, &slot.buffer));
+	}
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer));
+	if (slot.capacity < size)
+	{
+		GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW));
+		slot.capacity = size;
+	}
+
+	void* mapped = size > 0 ? glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT) : nullptr;
+	if (mapped == nullptr)
+	{
+		// nothing to stage or the driver wouldn't map it, the caller uploads straight from the data
+		GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+		return false;
+	}
+
+	{
+		PROFILE_ZONE("PixelUploadRing::copy");
+		std::memcpy(mapped, data, std::min(size, copySize));
+	}
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	m_staged = &slot;
+	return true;
+}
+
+void PixelUploadRing::finish()
+{
+	GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+	m_staged->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_staged = nullptr;
+}
+
+void PixelUploadRing::texImage2D(GLenum target, int width, int height, const unsigned char* pixels, size_t size)
+{
+	PROFILE_ZONE("PixelUploadRing::texImage2D");
+
+	// what GL reads for GL_RGB rows padded to the default unpack alignment of 4
+	size_t row = (size_t(width) * 3 + 3) & ~size_t(3);
+	size_t needed = height > 0 ? row * size_t(height - 1) + size_t(width) * 3 : 0;
+	StartupTimeline::addBytesUploaded(needed);
+
+	if (!stage(pixels, needed, size))
+	{
+		GLCall(glTexImage2D(target, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels));
+		return;
+	}
+
+	// with a buffer bound the pointer is an offset into it
+	GLCall(glTexImage2D(target, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, (void*)0));
+	finish();
+}
+
+void PixelUploadRing::compressedTexImage2D(GLenum target, int level, GLenum format, int width, int height, const void* data, size_t size)
+{
+	PROFILE_ZONE("PixelUploadRing::compressedTexImage2D");
+	StartupTimeline::addBytesUploaded(size);
+
+	if (!stage(data, size, size))
+	{
+		GLCall(glCompressedTexImage2D(target, level, format, width, height, 0, GLsizei(size), data));
+		return;
+	}
+
+	GLCall(glCompressedTexImage2D(target, level, format, width, height, 0, GLsizei(size), (void*)0));
+	finish();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// buffers in the ring, one can be filled while the driver still copies out of the others
+#define PIXEL_UPLOAD_BUFFERS 3
+
+/*
+* Ring of pixel unpack buffers that texture uploads go through
+* The pixels are copied into a mapped buffer and glTexImage2D reads from it, so the driver copies to the texture
+* asynchronously instead of inside the call. A buffer is reused once the fence set after its last upload has passed,
+* so uploading several images in a row only waits when the ring has gone all the way around.
+* Buffers grow to the largest image they've held. Needs a current GL context.
+*/
+class PixelUploadRing
+{
+private:
+	struct Slot
+	{
+		unsigned int buffer = 0;
+		size_t capacity = 0;
+		GLsync fence = nullptr;
+	};
+
+	Slot m_slots[PIXEL_UPLOAD_BUFFERS];
+	unsigned int m_next = 0;
+	// the slot stage() filled last
+	Slot* m_staged = nullptr;
+
+	// maps the next buffer of the ring with room for size bytes, waiting for its last upload to be done, and copies up
+	// to copySize bytes of data in; leaves it bound to GL_PIXEL_UNPACK_BUFFER, false and unbound if it couldn't be mapped
+	bool stage(const void* data, size_t size, size_t copySize);
+	// fences the buffer staged last and unbinds it
+	void finish();
+
+public:
+	PixelUploadRing() = default;
+	~PixelUploadRing();
+
+	PixelUploadRing(const PixelUploadRing&) = delete;
+	PixelUploadRing& operator=(const PixelUploadRing&) = delete;
+
+	// glTexImage2D(target, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels) through the next buffer of
+	// the ring, into whatever texture is bound to target; size is how many bytes pixels holds
+	void texImage2D(GLenum target, int width, int height, const unsigned char* pixels, size_t size);
+
+	// glCompressedTexImage2D through the next buffer of the ring, size bytes of already compressed data
+	void compressedTexImage2D(GLenum target, int level, GLenum format, int width, int height, const void* data, size_t size);
+};
@@ -0,0 +1,502 @@
+#include "Population.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+#include <glm/gtc/constants.hpp>
+
+#include "imgui/imgui.h"
+
+#include "Profiler.h"
+#include "StartupTimeline.h"
+#include "GLErrors.h"
+
+#define INVALID_INDEX 0xFFFFFFFFu
+
+// semi-major axis band (it's quantized logarithmically already), then longitude and latitude of the scene position
+static uint32_t getCell(const PackedElements& packed, const glm::vec3& position)
+{
+	uint32_t band = uint32_t(packed.a) * POPULATION_BANDS / 65536u;
+
+	float longitude = std::atan2(position.z, position.x) / (2.0f * glm::pi<float>()) + 0.5f;
+	uint32_t sector = std::min(uint32_t(longitude * POPULATION_SECTORS), POPULATION_SECTORS - 1);
+
+	float latitude = glm::degrees(std::asin(glm::clamp(position.y / std::max(glm::length(position), 1e-6f), -1.0f, 1.0f)));
+	float layerPosition = float(latitude / POPULATION_LAYER_DEGREES) + POPULATION_LAYERS * 0.5f;
+	uint32_t layer = uint32_t(glm::clamp(layerPosition, 0.0f, float(POPULATION_LAYERS - 1)));
+
+	return (band * POPULATION_SECTORS + sector) * POPULATION_LAYERS + layer;
+}
+
+bool buildPopulationPages(const MinorPlanetCatalog& minorPlanets, const std::string& outputPath)
+{
+	PROFILE_ZONE("buildPopulationPages");
+
+	uint64_t start = Profiler::now();
+	const uint32_t cellCount = POPULATION_BANDS * POPULATION_SECTORS * POPULATION_LAYERS;
+	const PackedElements* objects = minorPlanets.getPackedElements();
+	uint32_t count = minorPlanets.getCount();
+	if (count == 0)
+	{
+		std::cout << "No minor planets to page" << std::endl;
+		return false;
+	}
+
+	// counting pass, then every cell knows where its objects and pages start
+	std::vector<uint64_t> cellCounts(cellCount, 0);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		cellCounts[getCell(objects[i], minorPlanetPosition(unpackElements(objects[i])))]++;
+	}
+
+	std::vector<uint64_t> cellStarts(cellCount);
+	std::vector<uint32_t> cellFirstPages(cellCount);
+	std::vector<PopulationPage> pages;
+	uint64_t cellStart = 0;
+	for (uint32_t cell = 0; cell < cellCount; cell++)
+	{
+		cellStarts[cell] = cellStart;
+		cellFirstPages[cell] = (uint32_t)pages.size();
+		for (uint64_t first = 0; first < cellCounts[cell]; first += POPULATION_PAGE_OBJECTS)
+		{
+			PopulationPage page = {};
+			page.firstObject = cellStart + first;
+			page.count = (uint32_t)std::min<uint64_t>(POPULATION_PAGE_OBJECTS, cellCounts[cell] - first);
+			page.cell = cell;
+			pages.push_back(page);
+		}
+		cellStart += cellCounts[cell];
+	}
+
+	PopulationHeader header = { POPULATION_MAGIC, POPULATION_VERSION, (uint32_t)pages.size(), POPULATION_PAGE_OBJECTS, count, 0 };
+	size_t tableEnd = sizeof(header) + pages.size() * sizeof(PopulationPage);
+	header.dataOffset = (tableEnd + POPULATION_DATA_ALIGNMENT - 1) / POPULATION_DATA_ALIGNMENT * POPULATION_DATA_ALIGNMENT;
+
+	std::ofstream out(outputPath, std::ios::binary);
+	if (!out)
+	{
+		std::cout << "Failed to write population: " << outputPath << std::endl;
+		return false;
+	}
+
+	// the table is written again once the bounds are known
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)pages.data(), pages.size() * sizeof(PopulationPage));
+
+	// scatter pass, each cell's buffer is written at its cursor when full, only occupied cells get one
+	std::vector<std::vector<PackedElements>> buffers(cellCount);
+	std::vector<uint64_t> cellWritten(cellCount, 0);
+	std::vector<uint64_t> cellFilled(cellCount, 0);
+	std::vector<glm::vec3> pageMin(pages.size(), glm::vec3(FLT_MAX));
+	std::vector<glm::vec3> pageMax(pages.size(), glm::vec3(-FLT_MAX));
+
+	auto flush = [&](uint32_t cell)
+	{
+		std::vector<PackedElements>& buffer = buffers[cell];
+		out.seekp(header.dataOffset + (cellStarts[cell] + cellWritten[cell]) * sizeof(PackedElements));
+		out.write((const char*)buffer.data(), buffer.size() * sizeof(PackedElements));
+		cellWritten[cell] += buffer.size();
+		buffer.clear();
+	};
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		OrbitalElements elements = unpackElements(objects[i]);
+		glm::vec3 position = minorPlanetPosition(elements);
+
+		uint32_t cell = getCell(objects[i], position);
+		uint32_t page = cellFirstPages[cell] + uint32_t(cellFilled[cell]++ / POPULATION_PAGE_OBJECTS);
+		pageMin[page] = glm::min(pageMin[page], position);
+		pageMax[page] = glm::max(pageMax[page], position);
+		pages[page].maxScale = std::max(pages[page].maxScale, minorPlanetScale(elements.magnitude));
+
+		std::vector<PackedElements>& buffer = buffers[cell];
+		if (buffer.capacity() == 0)
+		{
+			buffer.reserve(POPULATION_CELL_BUFFER);
+		}
+		buffer.push_back(objects[i]);
+		if (buffer.size() == POPULATION_CELL_BUFFER)
+		{
+			flush(cell);
+		}
+	}
+
+	for (uint32_t cell = 0; cell < cellCount; cell++)
+	{
+		if (!buffers[cell].empty())
+		{
+			flush(cell);
+		}
+	}
+
+	// bounding sphere around each page's box
+	for (size_t page = 0; page < pages.size(); page++)
+	{
+		glm::vec3 center = (pageMin[page] + pageMax[page]) * 0.5f;
+		pages[page].center[0] = center.x;
+		pages[page].center[1] = center.y;
+		pages[page].center[2] = center.z;
+		pages[page].radius = glm::length(pageMax[page] - center);
+	}
+
+	out.seekp(sizeof(header));
+	out.write((const char*)pages.data(), pages.size() * sizeof(PopulationPage));
+	out.close();
+
+	if (!out)
+	{
+		std::cout << "Failed to write population: " << outputPath << std::endl;
+		return false;
+	}
+
+	uint64_t bytes = header.dataOffset + uint64_t(count) * sizeof(PackedElements);
+	std::cout << "Paged " << count << " minor planets into " << pages.size() << " pages in "
+		<< double(Profiler::now() - start) * 1e-6 << " ms, " << bytes / (1024.0 * 1024.0) << " MB: " << outputPath << std::endl;
+	return true;
+}
+
+PopulationStreamer::~PopulationStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	for (auto& loader : m_loaders)
+	{
+		loader.join();
+	}
+}
+
+bool PopulationStreamer::open(const std::string& path, size_t budget)
+{
+	PROFILE_ZONE("PopulationStreamer::open");
+	STARTUP_ASSET("PopulationStreamer::open", path);
+
+	if (!m_loaders.empty() || !m_file.open(path))
+	{
+		return false;
+	}
+
+	const uint8_t* data = m_file.getData();
+	size_t size = m_file.getSize();
+	const PopulationHeader* header = (const PopulationHeader*)data;
+	if (size < sizeof(PopulationHeader) || header->magic != POPULATION_MAGIC || header->version != POPULATION_VERSION
+		|| header->pageObjects != POPULATION_PAGE_OBJECTS || header->pageCount == 0)
+	{
+		std::cout << "Not a population file of this version: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	if (header->dataOffset < sizeof(PopulationHeader) + size_t(header->pageCount) * sizeof(PopulationPage)
+		|| size < header->dataOffset + header->objectCount * sizeof(PackedElements))
+	{
+		std::cout << "Population file size doesn't match its header: " << path << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	const PopulationPage* pages = (const PopulationPage*)(data + sizeof(PopulationHeader));
+	for (uint32_t page = 0; page < header->pageCount; page++)
+	{
+		if (pages[page].count == 0 || pages[page].count > POPULATION_PAGE_OBJECTS
+			|| pages[page].firstObject + pages[page].count > header->objectCount)
+		{
+			std::cout << "Population page " << page << " is invalid: " << path << std::endl;
+			m_file.close();
+			return false;
+		}
+	}
+
+	m_pages = pages;
+	m_objects = (const PackedElements*)(data + header->dataOffset);
+	m_pageCount = header->pageCount;
+	m_objectCount = header->objectCount;
+
+	m_states.assign(m_pageCount, PageState::Absent);
+	m_pageSlots.assign(m_pageCount, INVALID_INDEX);
+	m_lastWanted.assign(m_pageCount, 0);
+	m_distances.assign(m_pageCount, 0.0f);
+	m_order.resize(m_pageCount);
+	std::iota(m_order.begin(), m_order.end(), 0u);
+
+	// no point in more slots than pages
+	size_t slotBytes = POPULATION_PAGE_OBJECTS * sizeof(glm::mat4);
+	uint32_t slots = (uint32_t)std::min<size_t>(std::max<size_t>(budget / slotBytes, 1), m_pageCount);
+	m_slotPages.assign(slots, INVALID_INDEX);
+	m_freeSlots.clear();
+	for (uint32_t slot = slots; slot > 0; slot--)
+	{
+		m_freeSlots.push_back(slot - 1);
+	}
+	m_chunks.reserve(slots);
+
+	m_staging.assign(POPULATION_MAX_IN_FLIGHT, std::vector<glm::mat4>(POPULATION_PAGE_OBJECTS));
+	for (uint32_t staging = 0; staging < POPULATION_MAX_IN_FLIGHT; staging++)
+	{
+		m_freeStaging.push_back(staging);
+	}
+
+	m_requests.reserve(POPULATION_MAX_IN_FLIGHT);
+	m_completed.reserve(POPULATION_MAX_IN_FLIGHT);
+	m_uploads.reserve(POPULATION_MAX_IN_FLIGHT);
+
+	for (uint32_t i = 0; i < POPULATION_LOADER_THREADS; i++)
+	{
+		m_loaders.emplace_back(&PopulationStreamer::loaderLoop, this);
+	}
+
+	std::cout << "Streaming " << m_objectCount << " minor planets in " << m_pageCount << " pages, " << slots
+		<< " resident at most: " << path << std::endl;
+	return true;
+}
+
+void PopulationStreamer::loaderLoop()
+{
+	Profiler::setThreadName("Population loader");
+
+	for (;;)
+	{
+		PageRequest request;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this]() { return m_quit || !m_requests.empty(); });
+			if (m_quit)
+			{
+				return;
+			}
+
+			// requested nearest first
+			request = m_requests.front();
+			m_requests.erase(m_requests.begin());
+		}
+
+		buildPage(request);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_completed.push_back(request);
+	}
+}
+
+void PopulationStreamer::buildPage(const PageRequest& request)
+{
+	PROFILE_ZONE("buildPage");
+
+	// first touch of the page's objects, this is where they're read from disk
+	const PopulationPage& page = m_pages[request.page];
+	glm::mat4* matrices = m_staging[request.staging].data();
+	for (uint32_t i = 0; i < page.count; i++)
+	{
+		uint64_t index = page.firstObject + i;
+		matrices[i] = minorPlanetModel(unpackElements(m_objects[index]), index);
+	}
+}
+
+void PopulationStreamer::update(const glm::vec3& cameraPosition)
+{
+	PROFILE_ZONE("PopulationStreamer::update");
+
+	m_frame++;
+	uploadCompleted();
+	requestPages(cameraPosition);
+
+	m_chunks.clear();
+	for (uint32_t slot = 0; slot < m_slotPages.size(); slot++)
+	{
+		uint32_t page = m_slotPages[slot];
+		if (page == INVALID_INDEX || m_states[page] != PageState::Resident)
+		{
+			continue;
+		}
+
+		BeltChunk chunk;
+		chunk.firstInstance = slot * POPULATION_PAGE_OBJECTS;
+		chunk.instanceCount = m_pages[page].count;
+		chunk.center = glm::vec3(m_pages[page].center[0], m_pages[page].center[1], m_pages[page].center[2]);
+		chunk.radius = m_pages[page].radius;
+		chunk.maxScale = m_pages[page].maxScale;
+		m_chunks.push_back(chunk);
+	}
+}
+
+void PopulationStreamer::uploadCompleted()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_uploads.swap(m_completed);
+	}
+
+	if (m_uploads.empty())
+	{
+		return;
+	}
+
+	PROFILE_ZONE("Upload pages");
+
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer));
+	for (const PageRequest& request : m_uploads)
+	{
+		size_t slotOffset = size_t(request.slot) * POPULATION_PAGE_OBJECTS * sizeof(glm::mat4);
+		GLCall(glBufferSubData(GL_ARRAY_BUFFER, slotOffset, m_pages[request.page].count * sizeof(glm::mat4),
+			m_staging[request.staging].data()));
+
+		m_states[request.page] = PageState::Resident;
+		m_freeStaging.push_back(request.staging);
+		m_inFlight--;
+		m_pageIns++;
+
+		// requested to uploaded, so it includes waiting behind other requests
+		double milliseconds = double(Profiler::now() - request.requestTime) * 1e-6;
+		int bucket = 0;
+		for (double bound = POPULATION_LATENCY_BASE_MS; milliseconds >= bound && bucket < POPULATION_LATENCY_BUCKETS - 1; bound *= 2.0)
+		{
+			bucket++;
+		}
+		m_latencyCounts[bucket]++;
+		m_latencyPlot[bucket] = float(m_latencyCounts[bucket]);
+	}
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+	m_uploads.clear();
+}
+
+void PopulationStreamer::requestPages(const glm::vec3& cameraPosition)
+{
+	for (uint32_t page = 0; page < m_pageCount; page++)
+	{
+		const PopulationPage& entry = m_pages[page];
+		glm::vec3 center(entry.center[0], entry.center[1], entry.center[2]);
+		m_distances[page] = std::max(glm::length(center - cameraPosition) - entry.radius, 0.0f);
+	}
+
+	// the region of interest is as many of the closest pages as fit, the order barely changes between frames
+	uint32_t wanted = (uint32_t)m_slotPages.size();
+	auto closer = [this](uint32_t lhs, uint32_t rhs) { return m_distances[lhs] < m_distances[rhs]; };
+	std::nth_element(m_order.begin(), m_order.begin() + wanted - 1, m_order.end(), closer);
+	std::sort(m_order.begin(), m_order.begin() + wanted, closer);
+
+	for (uint32_t i = 0; i < wanted; i++)
+	{
+		m_lastWanted[m_order[i]] = m_frame;
+	}
+
+	bool requested = false;
+	for (uint32_t i = 0; i < wanted && m_inFlight < POPULATION_MAX_IN_FLIGHT && !m_freeStaging.empty(); i++)
+	{
+		uint32_t page = m_order[i];
+		if (m_states[page] != PageState::Absent)
+		{
+			continue;
+		}
+
+		uint32_t slot;
+		if (!acquireSlot(slot))
+		{
+			break;
+		}
+
+		PageRequest request;
+		request.page = page;
+		request.slot = slot;
+		request.staging = m_freeStaging.back();
+		request.requestTime = Profiler::now();
+		m_freeStaging.pop_back();
+
+		m_states[page] = PageState::Loading;
+		m_pageSlots[page] = slot;
+		m_slotPages[slot] = page;
+		m_inFlight++;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_requests.push_back(request);
+		requested = true;
+	}
+
+	if (requested)
+	{
+		m_wake.notify_all();
+	}
+}
+
+bool PopulationStreamer::acquireSlot(uint32_t& slot)
+{
+	if (!m_freeSlots.empty())
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+		return true;
+	}
+
+	// pages wanted this frame are never picked, nor are ones still loading
+	uint32_t oldest = INVALID_INDEX;
+	for (uint32_t candidate = 0; candidate < m_slotPages.size(); candidate++)
+	{
+		uint32_t page = m_slotPages[candidate];
+		if (page != INVALID_INDEX && m_states[page] == PageState::Resident && m_lastWanted[page] < m_frame
+			&& (oldest == INVALID_INDEX || m_lastWanted[page] < m_lastWanted[m_slotPages[oldest]]))
+		{
+			oldest = candidate;
+		}
+	}
+
+	if (oldest == INVALID_INDEX)
+	{
+		return false;
+	}
+
+	uint32_t evicted = m_slotPages[oldest];
+	m_states[evicted] = PageState::Absent;
+	m_pageSlots[evicted] = INVALID_INDEX;
+	m_slotPages[oldest] = INVALID_INDEX;
+	m_evictions++;
+
+	slot = oldest;
+	return true;
+}
+
+double PopulationStreamer::getLatencyPercentile(double fraction) const
+{
+	uint64_t total = 0;
+	for (uint64_t count : m_latencyCounts)
+	{
+		total += count;
+	}
+
+	double bound = POPULATION_LATENCY_BASE_MS;
+	uint64_t cumulative = 0;
+	for (int bucket = 0; bucket < POPULATION_LATENCY_BUCKETS; bucket++, bound *= 2.0)
+	{
+		cumulative += m_latencyCounts[bucket];
+		if (total > 0 && cumulative >= fraction * total)
+		{
+			return bound;
+		}
+	}
+	return 0.0;
+}
+
+void PopulationStreamer::drawOverlay()
+{
+	ImGui::Begin("Population Streaming");
+
+	double slotMB = POPULATION_PAGE_OBJECTS * sizeof(glm::mat4) / (1024.0 * 1024.0);
+	ImGui::Text("Resident pages: %u / %u slots (%.1f / %.1f MB)", getResidentPages(), getSlotCount(),
+		getResidentPages() * slotMB, getSlotCount() * slotMB);
+	ImGui::Text("Population: %llu objects in %u pages", (unsigned long long)m_objectCount, m_pageCount);
+	ImGui::Text("Loading: %u, page-ins: %llu, evictions: %llu", m_inFlight, (unsigned long long)m_pageIns,
+		(unsigned long long)m_evictions);
+
+	ImGui::PlotHistogram("Page-in latency", m_latencyPlot, POPULATION_LATENCY_BUCKETS, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+	ImGui::Text("Buckets double from < %.2f ms, p50 < %.2f ms, p95 < %.2f ms", POPULATION_LATENCY_BASE_MS,
+		getLatencyPercentile(0.5), getLatencyPercentile(0.95));
+
+	ImGui::End();
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MappedFile.h"
+#include "MinorPlanets.h"
+#include "AsteroidBelt.h"
+
+// "MPPG" read as a little endian uint32_t, first thing in a paged population file
+#define POPULATION_MAGIC 0x4750504Du
+#define POPULATION_VERSION 1u
+
+// objects per page, the unit that is streamed in and evicted (57 KB on disk, 256 KB of instance matrices)
+#define POPULATION_PAGE_OBJECTS 4096u
+// pages never straddle a cell: a semi-major axis band (orbit), times a sector of longitude and a layer of ecliptic
+// latitude (where the object is at the epoch), layers are 8 degrees with the outermost ones open ended
+#define POPULATION_BANDS 64u
+#define POPULATION_SECTORS 64u
+#define POPULATION_LAYERS 8u
+#define POPULATION_LAYER_DEGREES 8.0
+// objects buffered per cell while scattering them into place
+#define POPULATION_CELL_BUFFER 256u
+// page data starts on a page boundary of the file
+#define POPULATION_DATA_ALIGNMENT 4096u
+
+// GPU memory for resident instance matrices
+#define POPULATION_DEFAULT_BUDGET (64ull * 1024 * 1024)
+// pages requested but not uploaded yet, each one holds a staging buffer
+#define POPULATION_MAX_IN_FLIGHT 16u
+#define POPULATION_LOADER_THREADS 2u
+// page-in latency histogram, bucket 0 is under 0.25 ms, each next one doubles, the last is everything slower
+#define POPULATION_LATENCY_BUCKETS 12
+#define POPULATION_LATENCY_BASE_MS 0.25
+
+// start of a paged population file, followed by pageCount PopulationPage, then the objects from dataOffset on
+struct PopulationHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t pageCount;
+	uint32_t pageObjects;
+	uint64_t objectCount;
+	uint64_t dataOffset;
+};
+
+// a page's objects are count PackedElements from firstObject on, bounds are in scene units
+struct PopulationPage
+{
+	uint64_t firstObject;
+	uint32_t count;
+	uint32_t cell;
+	float center[3];
+	float radius;
+	float maxScale;
+	uint32_t padding;
+};
+
+static_assert(sizeof(PopulationHeader) == 32, "population file layout changed");
+static_assert(sizeof(PopulationPage) == 40, "population file layout changed");
+
+/*
+* Ingested minor planets to a paged population file, for --page-population
+* Objects are counting-sorted into cells (similar orbits, nearby positions at the epoch) by scattering them through
+* small buffers of the occupied cells, so memory doesn't grow with the population size, then every cell is split into
+* pages with their bounding spheres in the table at the front. Positions are solved for in both passes rather than
+* kept, trading CPU for memory.
+*/
+bool buildPopulationPages(const MinorPlanetCatalog& minorPlanets, const std::string& outputPath);
+
+/*
+* Streams the pages of a population file around the camera into a fixed instance buffer
+* The buffer is split into residency slots of one page each. Every update the pages closest to the camera (as many
+* as there are slots) are the region of interest: missing ones are requested, nearest first, from loader threads that
+* read them through the mapping and build their instance matrices, then the GL thread uploads them into their slot.
+* When no slot is free the least recently wanted page is evicted. Resident pages are handed to the frame recorder as
+* belt chunks. Neither the file nor the whole population has to fit in memory, only the slots and staging buffers.
+*/
+class PopulationStreamer
+{
+private:
+	enum class PageState : uint8_t
+	{
+		Absent,
+		Loading,
+		Resident
+	};
+
+	struct PageRequest
+	{
+		uint32_t page;
+		uint32_t slot;
+		uint32_t staging;
+		uint64_t requestTime;
+	};
+
+	MappedFile m_file;
+	const PopulationPage* m_pages = nullptr;
+	const PackedElements* m_objects = nullptr;
+	uint32_t m_pageCount = 0;
+	uint64_t m_objectCount = 0;
+
+	// per page
+	std::vector<PageState> m_states;
+	std::vector<uint32_t> m_pageSlots;
+	// frame the page was last in the region of interest
+	std::vector<uint64_t> m_lastWanted;
+	std::vector<float> m_distances;
+	// page indices, partially sorted by distance every update
+	std::vector<uint32_t> m_order;
+
+	// per slot, the page in it or UINT32_MAX
+	std::vector<uint32_t> m_slotPages;
+	std::vector<uint32_t> m_freeSlots;
+	std::vector<BeltChunk> m_chunks;
+
+	// page sized matrices the loaders build into, owned by one request at a time
+	std::vector<std::vector<glm::mat4>> m_staging;
+	std::vector<uint32_t> m_freeStaging;
+
+	// loader side, guarded by m_mutex
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::vector<PageRequest> m_requests;
+	std::vector<PageRequest> m_completed;
+	bool m_quit = false;
+	std::vector<std::thread> m_loaders;
+
+	// swapped with m_completed so uploads happen outside the lock
+	std::vector<PageRequest> m_uploads;
+
+	unsigned int m_instanceBuffer = 0;
+	uint64_t m_frame = 0;
+
+	uint32_t m_inFlight = 0;
+	uint64_t m_pageIns = 0;
+	uint64_t m_evictions = 0;
+	uint64_t m_latencyCounts[POPULATION_LATENCY_BUCKETS] = {};
+	float m_latencyPlot[POPULATION_LATENCY_BUCKETS] = {};
+
+	void loaderLoop();
+	void buildPage(const PageRequest& request);
+
+	void uploadCompleted();
+	void requestPages(const glm::vec3& cameraPosition);
+	// a free slot, or the one of the least recently wanted resident page, false if every slot is wanted or loading
+	bool acquireSlot(uint32_t& slot);
+
+public:
+	PopulationStreamer() = default;
+	~PopulationStreamer();
+
+	PopulationStreamer(const PopulationStreamer&) = delete;
+	PopulationStreamer& operator=(const PopulationStreamer&) = delete;
+
+	// maps the file and starts the loaders, budget is the bytes of instance matrices allowed on the GPU
+	bool open(const std::string& path, size_t budget);
+
+	// instances the instance buffer has to hold, every slot's worth
+	uint32_t getCapacity() const { return (uint32_t)m_slotPages.size() * POPULATION_PAGE_OBJECTS; }
+	// where pages are uploaded to, must hold getCapacity() matrices
+	void setInstanceBuffer(unsigned int buffer) { m_instanceBuffer = buffer; }
+
+	// uploads the pages that finished loading, then requests/evicts for the region around the camera
+	// GL thread, doesn't allocate
+	void update(const glm::vec3& cameraPosition);
+
+	// resident pages as chunks of the instance buffer
+	const std::vector<BeltChunk>& getChunks() const { return m_chunks; }
+
+	uint32_t getResidentPages() const { return (uint32_t)m_chunks.size(); }
+	uint32_t getSlotCount() const { return (uint32_t)m_slotPages.size(); }
+	uint32_t getPageCount() const { return m_pageCount; }
+	// upper bound of the histogram bucket holding the given fraction of page-ins, in ms
+	double getLatencyPercentile(double fraction) const;
+
+	// residency, page-in/eviction counts and the latency histogram in its own window
+	void drawOverlay();
+};
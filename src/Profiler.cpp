@@ -0,0 +1,143 @@
+#include "Profiler.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+struct ProfileEvent
+{
+	const char* name;
+	uint64_t start;
+	uint64_t end;
+};
+
+// one per thread that ever recorded, kept alive after the thread exits so its events still end up in the trace
+struct ProfileThreadBuffer
+{
+	unsigned int threadIndex = 0;
+	std::string threadName;
+
+	// the ring, allocated by the first event recorded, so threads that are only named (every worker) cost nothing
+	// while profiling is off; only read once written says there are events in it
+	std::unique_ptr<ProfileEvent[]> events;
+	// total events ever written, the ring position is this modulo the capacity
+	std::atomic<uint64_t> written{ 0 };
+};
+
+std::atomic<bool> Profiler::s_enabled{ false };
+
+static std::mutex buffersMutex;
+static std::vector<std::unique_ptr<ProfileThreadBuffer>> buffers;
+
+// timestamps in the trace are relative to this, so they stay small
+static const uint64_t profilerEpoch = Profiler::now();
+
+static thread_local ProfileThreadBuffer* threadBuffer = nullptr;
+
+static ProfileThreadBuffer& getThreadBuffer()
+{
+	if (threadBuffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffers.push_back(std::make_unique<ProfileThreadBuffer>());
+		threadBuffer = buffers.back().get();
+		threadBuffer->threadIndex = (unsigned int)buffers.size();
+		threadBuffer->threadName = "Thread " + std::to_string(threadBuffer->threadIndex);
+	}
+	return *threadBuffer;
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const char* name)
+{
+	ProfileThreadBuffer& buffer = getThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	buffer.threadName = name;
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end)
+{
+	ProfileThreadBuffer& buffer = getThreadBuffer();
+	if (buffer.events == nullptr)
+	{
+		buffer.events.reset(new ProfileEvent[PROFILER_EVENTS_PER_THREAD]);
+	}
+
+	uint64_t index = buffer.written.load(std::memory_order_relaxed);
+	buffer.events[index % PROFILER_EVENTS_PER_THREAD] = { name, start, end };
+	buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::clear()
+{
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	for (auto& buffer : buffers)
+	{
+		buffer->written.store(0, std::memory_order_relaxed);
+	}
+}
+
+// names are literals in the code, but keep the JSON valid whatever they contain
+static void writeEscaped(std::ofstream& out, const char* text)
+{
+	for (const char* c = text; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			out << '\\';
+		}
+		out << *c;
+	}
+}
+
+bool Profiler::writeChromeTrace(const std::string& path)
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cout << "Failed to write trace: " << path << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(buffersMutex);
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\"traceEvents\":[\n";
+	bool first = true;
+
+	for (const auto& buffer : buffers)
+	{
+		out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadIndex
+			<< ",\"args\":{\"name\":\"";
+		writeEscaped(out, buffer->threadName.c_str());
+		out << "\"}}";
+		first = false;
+
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		uint64_t begin = written > PROFILER_EVENTS_PER_THREAD ? written - PROFILER_EVENTS_PER_THREAD : 0;
+
+		for (uint64_t i = begin; i < written; i++)
+		{
+			const ProfileEvent& event = buffer->events[i % PROFILER_EVENTS_PER_THREAD];
+
+			// complete events, timestamps in microseconds
+			out << ",\n{\"name\":\"";
+			writeEscaped(out, event.name);
+			out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadIndex
+				<< ",\"ts\":" << (event.start - profilerEpoch) / 1000.0
+				<< ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+		}
+	}
+
+	out << "\n]}\n";
+
+	std::cout << "Wrote trace: " << path << std::endl;
+	return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/*
+* Low overhead scoped-zone CPU profiler
+* PROFILE_ZONE("name") times the enclosing scope on whichever thread runs it, events go into a ring buffer owned by
+* that thread so recording never locks. Names must be string literals, only the pointer is stored.
+* While disabled a zone costs one relaxed atomic load, defining DISABLE_PROFILER compiles zones out entirely.
+* writeChromeTrace() dumps the ring buffers as Chrome trace_event JSON (open with chrome://tracing or ui.perfetto.dev)
+*/
+
+#ifndef DISABLE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+// events kept per thread, the oldest ones are overwritten once it's full
+#define PROFILER_EVENTS_PER_THREAD (1 << 16)
+
+class Profiler
+{
+private:
+	static std::atomic<bool> s_enabled;
+
+public:
+	static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+	static void setEnabled(bool enabled);
+
+	// name shown for the calling thread in the trace, copied
+	static void setThreadName(const char* name);
+
+	// nanoseconds on the steady clock
+	static uint64_t now()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// appends a finished zone to the calling thread's ring buffer
+	static void record(const char* name, uint64_t start, uint64_t end);
+
+	// drops everything recorded so far
+	static void clear();
+
+	// writes every thread's ring buffer as Chrome trace_event JSON
+	// call between frames, threads still recording at the same time may tear their newest events
+	static bool writeChromeTrace(const std::string& path);
+};
+
+// times the enclosing scope, use through PROFILE_ZONE
+class ProfileZone
+{
+private:
+	const char* m_name;
+	uint64_t m_start;
+
+public:
+	explicit ProfileZone(const char* name)
+		: m_name(name), m_start(Profiler::isEnabled() ? Profiler::now() : 0)
+	{
+	}
+
+	~ProfileZone()
+	{
+		if (m_start != 0)
+		{
+			Profiler::record(m_name, m_start, Profiler::now());
+		}
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+};
@@ -0,0 +1,188 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+#include "Profiler.h"
+
+void GLStateCache::useProgram(unsigned int program)
+{
+	if (m_programValid && m_program == program)
+	{
+		if (m_stats) m_stats->redundantStateChanges++;
+		return;
+	}
+
+	glUseProgram(program);
+	m_program = program;
+	m_programValid = true;
+	if (m_stats) m_stats->stateChanges++;
+}
+
+void GLStateCache::bindVertexArray(unsigned int VAO)
+{
+	if (m_VAOValid && m_VAO == VAO)
+	{
+		if (m_stats) m_stats->redundantStateChanges++;
+		return;
+	}
+
+	glBindVertexArray(VAO);
+	m_VAO = VAO;
+	m_VAOValid = true;
+	if (m_stats) m_stats->stateChanges++;
+}
+
+void GLStateCache::bindTexture2D(unsigned int texture)
+{
+	if (m_textureValid && m_texture == texture)
+	{
+		if (m_stats) m_stats->redundantStateChanges++;
+		return;
+	}
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	m_texture = texture;
+	m_textureValid = true;
+	if (m_stats) m_stats->stateChanges++;
+}
+
+void GLStateCache::setFirstInstance(unsigned int VAO, unsigned int instanceBuffer, unsigned int firstInstance)
+{
+	// attribute pointers are VAO state, a VAO not re-pointed since invalidate() could be pointing anywhere
+	auto it = std::find_if(m_instanceOffsets.begin(), m_instanceOffsets.end(), [VAO](const std::pair<unsigned int, unsigned int>& offset)
+	{
+		return offset.first == VAO;
+	});
+	if (it != m_instanceOffsets.end() && it->second == firstInstance)
+	{
+		return;
+	}
+
+	GLCall(glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer));
+	size_t offset = size_t(firstInstance) * sizeof(glm::mat4);
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		GLCall(glVertexAttribPointer(INSTANCE_MATRIX_ATTRIB + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+			(void*)(offset + i * sizeof(glm::vec4))));
+	}
+
+	if (it != m_instanceOffsets.end())
+	{
+		it->second = firstInstance;
+	}
+	else
+	{
+		m_instanceOffsets.emplace_back(VAO, firstInstance);
+	}
+	if (m_stats) m_stats->stateChanges++;
+}
+
+void GLStateCache::setDequantize(int slot, const glm::vec3* dequantize)
+{
+	if (m_programValid && m_dequantizeProgram == m_program && m_dequantize == dequantize)
+	{
+		if (m_stats) m_stats->redundantStateChanges++;
+		return;
+	}
+
+	GLCall(glUniform3fv(slot, 2, &dequantize[0][0]));
+	m_dequantize = dequantize;
+	m_dequantizeProgram = m_program;
+	if (m_stats) m_stats->stateChanges++;
+}
+
+void GLStateCache::invalidate()
+{
+	m_programValid = false;
+	m_VAOValid = false;
+	m_textureValid = false;
+	m_dequantize = nullptr;
+	m_instanceOffsets.clear();
+}
+
+void RenderQueue::submit(const std::vector<CommandList>& lists, GLStateCache& stateCache, FrameArena& arena, GpuTimer* timer)
+{
+	PROFILE_ZONE("Submit");
+
+	m_stats = RenderStats();
+	stateCache.m_stats = &m_stats;
+
+	// merge every list into one order, which only lives for this frame
+	size_t count = 0;
+	for (const auto& list : lists)
+	{
+		count += list.m_commands.size();
+	}
+
+	SortEntry* order = arena.allocateArray<SortEntry>(count);
+	SortEntry* end = order;
+	for (uint32_t list = 0; list < lists.size(); list++)
+	{
+		const auto& commands = lists[list].m_commands;
+		for (uint32_t i = 0; i < commands.size(); i++)
+		{
+			*end++ = SortEntry{ commands[i].sortKey, list << 24 | i };
+		}
+	}
+
+	{
+		PROFILE_ZONE("SortCommands");
+		std::sort(order, end);
+	}
+
+	for (const SortEntry* entry = order; entry != end; entry++)
+	{
+		const CommandList& list = lists[entry->command >> 24];
+		const DrawCommand& command = list.m_commands[entry->command & 0xFFFFFF];
+
+		if (timer != nullptr)
+		{
+			timer->beginPass(command.pass);
+		}
+
+		stateCache.useProgram(command.program);
+		stateCache.bindVertexArray(command.geometry);
+		if (command.texture != 0)
+		{
+			stateCache.bindTexture2D(command.texture);
+		}
+
+		if (command.dequantize != nullptr && command.dequantizeSlot >= 0)
+		{
+			stateCache.setDequantize(command.dequantizeSlot, command.dequantize);
+		}
+
+		if (command.matrixIndex != NO_MATRIX && command.modelSlot >= 0)
+		{
+			GLCall(glUniformMatrix4fv(command.modelSlot, 1, GL_FALSE, &list.m_matrices[command.matrixIndex][0][0]));
+		}
+
+		GLenum mode = command.primitive == Primitive::Lines ? GL_LINES : GL_TRIANGLES;
+
+		const void* indices = (const void*)(uintptr_t)command.indexOffset;
+		if (command.instanceCount == 1 && command.instanceBuffer == 0)
+		{
+			GLCall(glDrawElementsBaseVertex(mode, command.indexCount, command.indexType, indices, command.baseVertex));
+		}
+		else
+		{
+			stateCache.setFirstInstance(command.geometry, command.instanceBuffer, command.firstInstance);
+			GLCall(glDrawElementsInstancedBaseVertex(mode, command.indexCount, command.indexType, indices, command.instanceCount,
+				command.baseVertex));
+		}
+
+		m_stats.drawCalls++;
+		if (command.primitive == Primitive::Triangles)
+		{
+			m_stats.triangles += (unsigned long long)(command.indexCount / 3) * command.instanceCount;
+		}
+	}
+
+	if (timer != nullptr)
+	{
+		timer->endPass();
+	}
+
+	stateCache.m_stats = nullptr;
+}
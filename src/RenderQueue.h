@@ -0,0 +1,94 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+#include "CommandList.h"
+#include "FrameArena.h"
+#include "GLErrors.h"
+#include "GpuTimer.h"
+
+// instanced meshes put their per-instance model matrix in attributes 3-6
+#define INSTANCE_MATRIX_ATTRIB 3
+
+// counters from the last submit, to see how much the cache saved
+struct RenderStats
+{
+	unsigned int drawCalls = 0;
+	unsigned long long triangles = 0;
+	unsigned int stateChanges = 0;
+	unsigned int redundantStateChanges = 0;
+};
+
+// remembers what is currently bound so redundant glUseProgram/glBindTexture/glBindVertexArray calls are dropped
+// anything that binds state behind its back (imgui, skybox, shader.bind()) means it must be invalidated
+class GLStateCache
+{
+private:
+	unsigned int m_program = 0;
+	unsigned int m_VAO = 0;
+	unsigned int m_texture = 0;
+
+	// false until the first bind after invalidate(), nothing is trusted until then
+	bool m_programValid = false;
+	bool m_VAOValid = false;
+	bool m_textureValid = false;
+
+	// VAO and the first instance its instance attributes point at, for the VAOs re-pointed since invalidate(); a VAO
+	// name is reused once deleted, so nothing is remembered past it. Few instanced VAOs, cleared every frame without
+	// freeing, so a flat list
+	std::vector<std::pair<unsigned int, unsigned int>> m_instanceOffsets;
+
+	// last dequantization set and the program it was set on, uniforms are per program
+	const glm::vec3* m_dequantize = nullptr;
+	unsigned int m_dequantizeProgram = 0;
+
+public:
+	RenderStats* m_stats = nullptr;
+
+	void useProgram(unsigned int program);
+	void bindVertexArray(unsigned int VAO);
+	// only texture unit 0 is ever used for 2D textures
+	void bindTexture2D(unsigned int texture);
+
+	// GL 3.3 has no base instance, so drawing a sub range of instances re-points the instance matrix attributes
+	// of the bound VAO at the first instance's matrix
+	void setFirstInstance(unsigned int VAO, unsigned int instanceBuffer, unsigned int firstInstance);
+
+	// position scale/offset of packed meshes for the bound program, skipped while the program and mesh stay the same
+	void setDequantize(int slot, const glm::vec3* dequantize);
+
+	// forget the bindings and instance offsets, the next bind of each kind always reaches GL
+	void invalidate();
+};
+
+// merges the command lists recorded for a frame, then sorts and replays them through a GLStateCache
+class RenderQueue
+{
+private:
+	// sorted instead of the commands themselves
+	struct SortEntry
+	{
+		uint64_t key;
+		// list index << 24 | command index
+		uint32_t command;
+
+		bool operator<(const SortEntry& other) const
+		{
+			return key < other.key || (key == other.key && command < other.command);
+		}
+	};
+
+	RenderStats m_stats;
+
+public:
+	// must be called on the GL thread, timer (optional) gets a pass switch whenever the pass of the commands changes
+	// the merged order is allocated from arena, so it has to outlive the call only
+	void submit(const std::vector<CommandList>& lists, GLStateCache& stateCache, FrameArena& arena, GpuTimer* timer = nullptr);
+
+	const RenderStats& getStats() const { return m_stats; }
+};
@@ -0,0 +1,190 @@
+#include "ResourceRegistry.h"
+
+#include <iostream>
+
+#include "Hash.h"
+#include "LoadModel.h"
+#include "Profiler.h"
+#include "StartupTimeline.h"
+
+ResourceRegistry::~ResourceRegistry()
+{
+	for (const auto& texture : m_textures)
+	{
+		glDeleteTextures(1, &texture.first);
+	}
+}
+
+// everything the arena range depends on, so equal keys can share a range and a dequantize uniform
+static uint64_t hashGeometry(const MeshData& data)
+{
+	uint32_t counts[4] = { uint32_t(data.layout), data.vertexCount, data.indexCount, data.indexSize };
+	float dequantize[6] = { data.positionScale.x, data.positionScale.y, data.positionScale.z,
+		data.positionOffset.x, data.positionOffset.y, data.positionOffset.z };
+
+	uint64_t hash = hashBytes(counts, sizeof(counts));
+	hash = hashBytes(dequantize, sizeof(dequantize), hash);
+	hash = hashBytes(data.vertices, size_t(data.vertexCount) * getVertexSize(data.layout), hash);
+	return hashBytes(data.indices, size_t(data.indexCount) * data.indexSize, hash);
+}
+
+GeometryHandle ResourceRegistry::acquireGeometry(const MeshData& data, uint64_t& key)
+{
+	PROFILE_ZONE("ResourceRegistry::acquireGeometry");
+
+	key = hashGeometry(data);
+	size_t bytes = size_t(data.vertexCount) * getVertexSize(data.layout) + size_t(data.indexCount) * data.indexSize;
+	m_stats.geometryRequests++;
+	m_stats.geometryBytesRequested += bytes;
+
+	GeometryEntry& entry = m_geometry[key];
+	if (entry.references++ == 0)
+	{
+		entry.geometry = m_arena.allocate(data);
+		m_stats.geometryUploads++;
+		m_stats.geometryBytesUploaded += bytes;
+	}
+	return entry.geometry;
+}
+
+void ResourceRegistry::releaseGeometry(uint64_t key)
+{
+	auto it = m_geometry.find(key);
+	if (it == m_geometry.end())
+	{
+		return;
+	}
+
+	if (--it->second.references == 0)
+	{
+		m_arena.free(it->second.geometry);
+		m_geometry.erase(it);
+	}
+}
+
+unsigned int ResourceRegistry::acquireTexture(const std::string& path)
+{
+	PROFILE_ZONE("ResourceRegistry::acquireTexture");
+
+	// the same file again, no need to decode it to find out
+	auto known = m_texturePaths.find(path);
+	if (known != m_texturePaths.end())
+	{
+		TextureEntry& entry = m_textures[known->second];
+		entry.references++;
+		m_stats.textureRequests++;
+		m_stats.textureBytesRequested += entry.bytes;
+		m_stats.texturePathHits++;
+		return known->second;
+	}
+
+	STARTUP_ASSET("ResourceRegistry::acquireTexture", path);
+	CompressedTexture compressed;
+	if (m_compressTextures && compressed.load(path, true))
+	{
+		return acquireTexture(path, compressed);
+	}
+
+	int width, height, channels;
+	unsigned char* bytes;
+	stbi_set_flip_vertically_on_load(false);
+	{
+		PROFILE_ZONE("stbi_load");
+		StartupTimeline::addFileRead(path);
+		bytes = stbi_load(path.c_str(), &width, &height, &channels, 0);
+	}
+
+	if (bytes == nullptr)
+	{
+		std::cout << "Failed to load texture: " << path << std::endl;
+		m_stats.textureRequests++;
+		return 0;
+	}
+
+	unsigned int texture = acquireTexture(path, bytes, width, height, channels);
+	stbi_image_free(bytes);
+	return texture;
+}
+
+template <typename Upload>
+unsigned int ResourceRegistry::shareTexture(const std::string& path, uint64_t hash, size_t bytes, Upload upload)
+{
+	m_stats.textureRequests++;
+	m_stats.textureBytesRequested += bytes;
+
+	// a different name for content already on the GPU
+	unsigned int texture;
+	auto shared = m_textureHashes.find(hash);
+	if (shared != m_textureHashes.end())
+	{
+		texture = shared->second;
+		m_textures[texture].references++;
+	}
+	else
+	{
+		texture = upload();
+		m_textureHashes.emplace(hash, texture);
+		m_textures[texture] = { hash, 1, bytes };
+		m_stats.textureUploads++;
+		m_stats.textureBytesUploaded += bytes;
+	}
+
+	m_texturePaths.emplace(path, texture);
+	return texture;
+}
+
+unsigned int ResourceRegistry::acquireTexture(const std::string& path, const unsigned char* pixels, int width, int height, int channels,
+	PixelUploadRing* ring)
+{
+	int size[3] = { width, height, channels };
+	size_t pixelBytes = size_t(width) * height * channels;
+	uint64_t hash = hashBytes(pixels, pixelBytes, hashBytes(size, sizeof(size)));
+
+	return shareTexture(path, hash, pixelBytes, [&]() { return uploadTexture(pixels, width, height, ring, pixelBytes); });
+}
+
+unsigned int ResourceRegistry::acquireTexture(const std::string& path, const CompressedTexture& texture, PixelUploadRing* ring)
+{
+	// the cache is keyed by the image file, as good a content hash as the pixels' and free to have
+	return shareTexture(path, texture.getSourceHash(), texture.getDataSize(), [&]()
+	{
+		m_stats.textureCompressedUploads++;
+		return uploadCompressedTexture(texture, ring);
+	});
+}
+
+void ResourceRegistry::releaseTexture(unsigned int texture)
+{
+	auto it = m_textures.find(texture);
+	if (texture == 0 || it == m_textures.end())
+	{
+		return;
+	}
+
+	if (--it->second.references > 0)
+	{
+		return;
+	}
+
+	// every path that led to it goes too, the next request decodes the file again
+	for (auto path = m_texturePaths.begin(); path != m_texturePaths.end();)
+	{
+		path = path->second == texture ? m_texturePaths.erase(path) : std::next(path);
+	}
+	m_textureHashes.erase(it->second.hash);
+	m_textures.erase(it);
+	glDeleteTextures(1, &texture);
+}
+
+void ResourceRegistry::printReport() const
+{
+	auto toMB = [](size_t bytes) { return double(bytes) / (1024.0 * 1024.0); };
+
+	std::cout << "Resources: geometry " << m_stats.geometryUploads << "/" << m_stats.geometryRequests << " uploaded, "
+		<< toMB(m_stats.geometryBytesUploaded) << " of " << toMB(m_stats.geometryBytesRequested) << " MB; textures "
+		<< m_stats.textureUploads << "/" << m_stats.textureRequests << " uploaded (" << m_stats.textureCompressedUploads << " compressed, "
+		<< m_stats.texturePathHits << " by path), "
+		<< toMB(m_stats.textureBytesUploaded) << " of " << toMB(m_stats.textureBytesRequested) << " MB; saved "
+		<< toMB(m_stats.geometryBytesRequested - m_stats.geometryBytesUploaded + m_stats.textureBytesRequested - m_stats.textureBytesUploaded)
+		<< " MB" << std::endl;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "GeometryArena.h"
+#include "PixelUploadRing.h"
+#include "TextureCache.h"
+#include "Vertex.h"
+
+// what was asked of the registry against what it actually put on the GPU, counted since it was created
+struct ResourceStats
+{
+	unsigned int geometryRequests = 0;
+	unsigned int geometryUploads = 0;
+	size_t geometryBytesRequested = 0;
+	size_t geometryBytesUploaded = 0;
+
+	unsigned int textureRequests = 0;
+	unsigned int textureUploads = 0;
+	size_t textureBytesRequested = 0;
+	size_t textureBytesUploaded = 0;
+	// requests answered by path without decoding the file again
+	unsigned int texturePathHits = 0;
+	// uploads from the texture cache, block compressed with their mip chain
+	unsigned int textureCompressedUploads = 0;
+};
+
+/*
+* Shared, reference counted GPU resources keyed by a hash of their content
+* Two models with byte-identical meshes or textures (a generic rock reused by many moons, the same image under two
+* names) get the same arena range or texture object. Every acquire has to be matched by a release, the last release
+* frees the range or deletes the texture.
+* Textures seen before under the same path aren't decoded again. Where the context supports it textures are loaded
+* block compressed from the texture cache (see CompressedTexture) and only decoded when that fails.
+*/
+class ResourceRegistry
+{
+private:
+	struct GeometryEntry
+	{
+		GeometryHandle geometry;
+		uint32_t references = 0;
+	};
+
+	struct TextureEntry
+	{
+		uint64_t hash = 0;
+		uint32_t references = 0;
+		size_t bytes = 0;
+	};
+
+	GeometryArena& m_arena;
+
+	std::unordered_map<uint64_t, GeometryEntry> m_geometry;
+	// by texture name, plus content hash and path to texture name
+	std::unordered_map<unsigned int, TextureEntry> m_textures;
+	std::unordered_map<uint64_t, unsigned int> m_textureHashes;
+	std::unordered_map<std::string, unsigned int> m_texturePaths;
+
+	ResourceStats m_stats;
+	bool m_compressTextures;
+
+	// the texture with this content hash, uploaded by upload() unless it's on the GPU already, taking a reference
+	template <typename Upload>
+	unsigned int shareTexture(const std::string& path, uint64_t hash, size_t bytes, Upload upload);
+
+public:
+	explicit ResourceRegistry(GeometryArena& arena) : m_arena(arena), m_compressTextures(isTextureCompressionSupported()) {}
+	// deletes textures that were never released, the arena frees its buffers on its own
+	~ResourceRegistry();
+
+	ResourceRegistry(const ResourceRegistry&) = delete;
+	ResourceRegistry& operator=(const ResourceRegistry&) = delete;
+
+	// arena range holding the data, key is what to release it with
+	GeometryHandle acquireGeometry(const MeshData& data, uint64_t& key);
+	void releaseGeometry(uint64_t key);
+
+	// loaded compressed or decoded and uploaded like TextureFromFile() unless the path or the content were seen before
+	unsigned int acquireTexture(const std::string& path);
+	// pixels decoded elsewhere (see AssetLoader), uploaded through the ring if one is given and they weren't seen before
+	unsigned int acquireTexture(const std::string& path, const unsigned char* pixels, int width, int height, int channels,
+		PixelUploadRing* ring = nullptr);
+	// a texture loaded from the texture cache elsewhere, same as above
+	unsigned int acquireTexture(const std::string& path, const CompressedTexture& texture, PixelUploadRing* ring = nullptr);
+	// 0 is ignored
+	void releaseTexture(unsigned int texture);
+
+	GeometryArena& getArena() { return m_arena; }
+	// false when the context can't sample the texture cache's format and textures are uploaded uncompressed
+	bool compressesTextures() const { return m_compressTextures; }
+	const ResourceStats& getStats() const { return m_stats; }
+
+	// requested against uploaded counts and bytes, and what sharing saved
+	void printReport() const;
+};
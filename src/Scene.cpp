@@ -0,0 +1,364 @@
+#include "Scene.h"
+
+#include "Profiler.h"
+#include "AssetLoader.h"
+#include "BodyCatalog.h"
+#include "MinorPlanets.h"
+#include "Population.h"
+#include "StartupTimeline.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+SceneDirectories getSceneDirectories(const AppOptions& options)
+{
+	SceneDirectories directories;
+	if (!options.catalogPath.empty())
+	{
+		directories.catalog = options.catalogPath;
+	}
+	if (!options.beltPath.empty())
+	{
+		directories.minorPlanets = options.beltPath;
+	}
+	if (!options.populationPath.empty())
+	{
+		directories.population = options.populationPath;
+	}
+	return directories;
+}
+
+Scene::Scene(const SceneDirectories& directories, size_t populationBudget)
+	: m_frameRecorder(m_jobs),
+	m_defaultShader((directories.shaders + "default.vert").c_str(), (directories.shaders + "default.frag").c_str()),
+	m_skyboxShader((directories.shaders + "skybox.vert").c_str(), (directories.shaders + "skybox.frag").c_str()),
+	m_lightSourceShader((directories.shaders + "lightSource.vert").c_str(), (directories.shaders + "lightSource.frag").c_str()),
+	m_asteroidShader((directories.shaders + "asteroid.vert").c_str(), (directories.shaders + "asteroid.frag").c_str()),
+	m_orbitShader((directories.shaders + "orbit.vert").c_str(), (directories.shaders + "orbit.frag").c_str())
+{
+	m_startup.start = Profiler::now();
+	m_startup.process = StartupTimeline::isRecording() ? StartupTimeline::getBeginTime() : m_startup.start;
+	STARTUP_PHASE("Scene::Scene");
+
+	// the shaders above only issued their compiles and links, the driver works on them while the rest is set up and
+	// they're first waited for when their uniforms are set below
+
+	// the models, their textures and the skybox faces stream in on the workers while frames are already drawn (see
+	// stream()): bodies start out as placeholder spheres, the belt is missing and the sky is black until they're in;
+	// a scene without a catalog still gets the belt and skybox. The workers only start once the first frame is out
+	// (framePresented()), so they don't compete with it for the cores
+	BodyCatalog catalog;
+	bool hasCatalog = catalog.load(directories.catalog);
+	std::vector<PlaceholderModel> placeholders;
+	if (hasCatalog)
+	{
+		addCatalogBodies(m_bodies, m_resources, catalog, directories.models, nullptr, &placeholders);
+	}
+	std::string skyboxFaces[6];
+	Skybox::getTexturePaths(directories.skybox, skyboxFaces);
+
+	m_modelsDirectory = directories.models;
+	m_loadJobs = std::make_unique<JobSystem>();
+	m_assets = std::make_unique<AssetLoader>(*m_loadJobs, m_resources);
+	m_asteroidAsset = m_assets->addModel(directories.models + "asteroid.obj");
+	m_asteroidPending = true;
+	for (const PlaceholderModel& placeholder : placeholders)
+	{
+		m_pendingModels.push_back({ placeholder, m_assets->addModel(placeholder.path) });
+	}
+	m_skyboxAsset = m_assets->addCubeMap(skyboxFaces);
+
+	// a paged population too large to load is streamed around the camera into the asteroid mesh's instances
+	auto population = std::make_unique<PopulationStreamer>();
+	if (std::ifstream(directories.population).good() && population->open(directories.population, populationBudget))
+	{
+		m_pendingPopulation = std::move(population);
+	}
+	else
+	{
+		// the real minor planet population when it has been ingested (--ingest-mpcorb), randomized asteroids
+		// otherwise, instancing enabled
+		MinorPlanetCatalog minorPlanets;
+		if (std::ifstream(directories.minorPlanets).good() && minorPlanets.load(directories.minorPlanets))
+		{
+			m_asteroidInstances = genMinorPlanetModels(minorPlanets);
+		}
+		else
+		{
+			const unsigned int numberAsteroids = 500;
+			float radius = 530.0f;
+			float radiusDeviation = 40.0f;
+			m_asteroidInstances = genAsteroidModels(numberAsteroids, radius, radiusDeviation);
+		}
+
+		// reorders the instances, so must happen before they're uploaded, arcs of a few thousand asteroids each
+		m_beltChunks = buildBeltChunks(m_asteroidInstances, std::max(16u, (unsigned int)m_asteroidInstances.size() / BELT_CHUNK_INSTANCES));
+	}
+
+	// light never moves, so the light uniforms only need to be set once per shader that uses them
+	for (Shader* shader : { &m_defaultShader, &m_asteroidShader })
+	{
+		shader->bind();
+		glUniform3f(shader->getUniformLocation("lightColor"), m_lightColor.x, m_lightColor.y, m_lightColor.z);
+		glUniform3f(shader->getUniformLocation("lightPosition"), m_lightPosition.x, m_lightPosition.y, m_lightPosition.z);
+	}
+
+	// all textured shaders sample from texture unit 0
+	for (Shader* shader : { &m_defaultShader, &m_lightSourceShader, &m_asteroidShader })
+	{
+		shader->bind();
+		glUniform1i(shader->getUniformLocation("tex0"), 0);
+	}
+
+	// necessary so depth in 3D models rendered properly
+	glEnable(GL_DEPTH_TEST);
+}
+
+// how much of the screen a sphere takes up, more or less, the larger the sooner what it's drawn with is streamed in
+static float getScreenSize(const glm::vec3& center, float radius, const Camera& camera)
+{
+	return radius / std::max(glm::length(center - camera.m_position), radius);
+}
+
+void Scene::startLoading()
+{
+	m_assets->start();
+	m_assets->setCubeMapPriority(m_skyboxAsset, SKYBOX_STREAM_PRIORITY);
+	m_skybox = std::make_unique<Skybox>(m_assets->getCubeMap(m_skyboxAsset));
+}
+
+void Scene::resolveShaders(bool wait)
+{
+	if (!m_skyboxShaderReady && (wait || m_skyboxShader.isReady()))
+	{
+		m_skyboxShader.resolve();
+		m_skyboxShaderReady = true;
+	}
+
+	if (!m_orbitShaderReady && (wait || m_orbitShader.isReady()))
+	{
+		m_orbitShader.resolve();
+		// every orbit line has the same color
+		if (m_bodies.getOrbitVisuals().size() > 0)
+		{
+			m_bodies.getOrbitVisuals()[0].ellipse->exportColorToShader(m_orbitShader);
+		}
+		m_orbitShaderReady = true;
+	}
+}
+
+void Scene::stream(const Camera* camera, uint64_t budget, bool wait)
+{
+	PROFILE_ZONE("Scene::stream");
+
+	// a model is as important as the largest body drawn with it, the belt as its largest chunk
+	if (camera != nullptr)
+	{
+		const ComponentArray<RenderProxy>& proxies = m_bodies.getRenderProxies();
+		for (const PendingModel& pending : m_pendingModels)
+		{
+			float priority = 0.0f;
+			for (size_t slot = 0; slot < proxies.size(); slot++)
+			{
+				if (proxies[slot].mesh == pending.model.placeholder)
+				{
+					const Transform& transform = m_bodies.getTransform(proxies.getOwner(slot));
+					priority = std::max(priority, getScreenSize(transform.world, proxies[slot].boundingRadius, *camera));
+				}
+			}
+			m_assets->setModelPriority(pending.asset, priority);
+		}
+
+		if (m_asteroidPending)
+		{
+			float priority = 0.0f;
+			for (const BeltChunk& chunk : m_pendingPopulation ? m_pendingPopulation->getChunks() : m_beltChunks)
+			{
+				priority = std::max(priority, getScreenSize(chunk.center, chunk.radius, *camera));
+			}
+			m_assets->setModelPriority(m_asteroidAsset, priority);
+		}
+	}
+
+	bool finished = m_assets->poll(budget, wait);
+	resolveShaders(finished);
+
+	// whatever is complete replaces its placeholder, the rest keeps waiting
+	for (size_t i = 0; i < m_pendingModels.size();)
+	{
+		PendingModel& pending = m_pendingModels[i];
+		if (!m_assets->isModelReady(pending.asset))
+		{
+			i++;
+			continue;
+		}
+
+		std::vector<std::unique_ptr<Mesh>> meshes;
+		loadModel(pending.model.path, m_resources, meshes, m_assets.get());
+		if (!meshes.empty())
+		{
+			m_bodies.replaceMesh(pending.model.placeholder, m_bodies.addMesh(std::move(meshes[0])));
+		}
+		pending = m_pendingModels.back();
+		m_pendingModels.pop_back();
+	}
+
+	if (m_asteroidPending && m_assets->isModelReady(m_asteroidAsset))
+	{
+		m_asteroidPending = false;
+		if (m_pendingPopulation)
+		{
+			m_asteroid = loadAsteroidModel(m_resources, m_modelsDirectory, (int)m_pendingPopulation->getCapacity(), {}, m_assets.get());
+			if (m_asteroid)
+			{
+				m_pendingPopulation->setInstanceBuffer(m_asteroid->getInstanceBuffer());
+				m_population = std::move(m_pendingPopulation);
+			}
+		}
+		else
+		{
+			m_asteroid = loadAsteroidModel(m_resources, m_modelsDirectory, (int)m_asteroidInstances.size(), m_asteroidInstances, m_assets.get());
+			std::vector<glm::mat4>().swap(m_asteroidInstances);
+		}
+	}
+
+	if (!finished)
+	{
+		return;
+	}
+
+	m_startup.fullQuality = Profiler::now();
+	std::cout << "Full quality " << double(m_startup.fullQuality - m_startup.process) / 1e6 << " ms after startup ("
+		<< double(m_startup.fullQuality - m_startup.start) / 1e6 << " ms after the scene started loading)" << std::endl;
+	StartupTimeline::mark("Full quality");
+	Shader::printReport();
+	m_assets->printTimes();
+	m_resources.printReport();
+
+	// the meshes hold references of their own to the textures the loader acquired
+	m_assets.reset();
+	m_loadJobs.reset();
+
+	// headless runs load everything before their first frame unless they stream, framePresented() ends it then
+	if (m_startup.firstFrame != 0)
+	{
+		StartupTimeline::end();
+	}
+}
+
+void Scene::finishLoading()
+{
+	if (m_assets != nullptr && m_skybox == nullptr)
+	{
+		startLoading();
+	}
+	while (m_assets != nullptr)
+	{
+		stream(nullptr, UINT64_MAX, true);
+	}
+}
+
+void Scene::update(double daysElapsed)
+{
+	PROFILE_ZONE("Simulation");
+
+	if (enableRotationalMotion)
+	{
+		m_bodies.updateSpins(daysElapsed);
+	}
+
+	// only bodies that orbit something have an orbit, so the sun isn't even visited
+	if (enableOrbitalMotion)
+	{
+		m_bodies.updateOrbits(daysElapsed);
+		m_bodies.updateTransforms();
+	}
+}
+
+void Scene::render(Camera& camera, GpuTimer* timer)
+{
+	m_frameArena.reset();
+
+	// the first frame goes out with placeholders only, any upload would come out of the time to it
+	if (m_assets != nullptr && m_startup.firstFrame != 0)
+	{
+		uint64_t now = Profiler::now();
+		uint64_t budget = std::max(uint64_t(STREAM_UPLOAD_BUDGET_MS * 1000000ull), uint64_t((now - m_lastStream) * STREAM_UPLOAD_SHARE));
+		m_lastStream = now;
+		stream(&camera, budget, false);
+	}
+
+	// binds the instance buffer to upload pages, before the state cache is invalidated below
+	if (m_population)
+	{
+		m_population->update(camera.m_position);
+	}
+
+	{
+		PROFILE_ZONE("Camera");
+		camera.exportToShader(m_defaultShader, "camMatrix");
+		camera.exportToShader(m_lightSourceShader, "camMatrix");
+		camera.exportToShader(m_asteroidShader, "camMatrix");
+		if (m_orbitShaderReady)
+		{
+			camera.exportToShader(m_orbitShader, "camMatrix");
+		}
+	}
+
+	// record the sun, planets, satellites/moons, orbits and visible belt chunks
+	{
+		PROFILE_ZONE("Record");
+		FrameView view;
+		view.camera = &camera;
+		view.frustum = Frustum::fromMatrix(camera.getCamMatrix());
+		view.drawOrbits = enableOrbitalPath && m_orbitShaderReady;
+		view.sunProgram = m_lightSourceShader.getProgramSlot();
+		view.bodyProgram = m_defaultShader.getProgramSlot();
+		view.orbitProgram = m_orbitShaderReady ? m_orbitShader.getProgramSlot() : ProgramSlot();
+		view.asteroidProgram = m_asteroidShader.getProgramSlot();
+		m_frameRecorder.record(view, m_bodies, m_asteroid.get(), m_population ? m_population->getChunks() : m_beltChunks);
+	}
+
+	// exportToShader() above bound programs behind the cache's back, so start from a clean slate
+	m_stateCache.invalidate();
+	m_renderQueue.submit(m_frameRecorder.getLists(), m_stateCache, m_frameArena, timer);
+
+	if (m_skyboxShaderReady)
+	{
+		PROFILE_ZONE("Skybox");
+		if (timer != nullptr)
+		{
+			timer->beginPass(RenderPass::Skybox);
+		}
+		m_skybox->draw(m_skyboxShader, camera);
+		if (timer != nullptr)
+		{
+			timer->endPass();
+		}
+	}
+}
+
+void Scene::framePresented()
+{
+	if (m_startup.firstFrame != 0)
+	{
+		return;
+	}
+
+	m_startup.firstFrame = Profiler::now();
+	m_lastStream = m_startup.firstFrame;
+	if (m_assets != nullptr)
+	{
+		startLoading();
+	}
+	double milliseconds = double(m_startup.firstFrame - m_startup.process) / 1e6;
+	std::cout << "First frame " << milliseconds << " ms after startup (" << double(m_startup.firstFrame - m_startup.start) / 1e6
+		<< " ms after the scene started loading), " << FIRST_FRAME_TARGET_MS << " ms target "
+		<< (milliseconds <= FIRST_FRAME_TARGET_MS ? "met" : "missed") << std::endl;
+	StartupTimeline::mark("First frame");
+	if (m_startup.fullQuality != 0)
+	{
+		StartupTimeline::end();
+	}
+}
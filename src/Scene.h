@@ -0,0 +1,178 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <string>
+
+#include "Shader.h"
+#include "Mesh.h"
+#include "LoadModel.h"
+#include "Bodies.h"
+#include "AsteroidBelt.h"
+#include "Population.h"
+#include "Skybox.h"
+#include "Camera.h"
+#include "JobSystem.h"
+#include "FrameRecorder.h"
+#include "RenderQueue.h"
+#include "FrameArena.h"
+#include "GpuTimer.h"
+#include "GUIParams.h"
+#include "CommandLine.h"
+#include "AssetLoader.h"
+#include "BodyCatalog.h"
+#include "AllocationTracker.h"
+
+// where the scene loads its shaders/models/skybox from, directories end with '/'
+struct SceneDirectories
+{
+	std::string shaders = "./src/shaders/";
+	std::string models = "./resources/models/";
+	std::string skybox = "./resources/milky_way_skybox/";
+	// bodies of the scene, text or compiled, see BodyCatalog.h
+	std::string catalog = "./resources/solar_system.catalog";
+	// ingested minor planets for the belt, see MinorPlanets.h, a random belt is generated when there is no such file
+	std::string minorPlanets = "./resources/minor_planets.bin";
+	// paged minor planets streamed around the camera (see Population.h), preferred over the above when it exists
+	std::string population = "./resources/minor_planets.pages";
+};
+
+// GL thread time per frame given to uploading streamed assets: this share of the time since the previous frame's
+// uploads, but at least STREAM_UPLOAD_BUDGET_MS, so slow frames don't stretch loading out over seconds and fast ones
+// at most halve their rate while loading
+#define STREAM_UPLOAD_SHARE 0.5
+#define STREAM_UPLOAD_BUDGET_MS 4
+// the sky stays black until every model is in, bodies and the belt are what the camera looks at
+#define SKYBOX_STREAM_PRIORITY -1.0f
+
+// what the progressive start aims for, from StartupTimeline::begin() in main(), before the window is created, to the
+// first frame presented
+#define FIRST_FRAME_TARGET_MS 100
+
+// how far a progressive start has come, Profiler::now() timestamps, 0 until reached
+struct StartupTimes
+{
+	// StartupTimeline::begin() in main() when the scene is the one started with the process, otherwise as start
+	uint64_t process = 0;
+	// the scene started loading
+	uint64_t start = 0;
+	// the first frame was presented, with placeholders for whatever wasn't loaded
+	uint64_t firstFrame = 0;
+	// every model, texture and the skybox were in
+	uint64_t fullQuality = 0;
+};
+
+// the defaults, with the catalog, belt and population given on the command line if there are any
+SceneDirectories getSceneDirectories(const AppOptions& options);
+
+// everything that gets drawn: the sun, planets, satellites, asteroid belt and skybox, plus what it takes to draw them
+// shared by the windowed app and the headless renderer, needs a current GL context to construct
+class Scene
+{
+private:
+	// light information
+	glm::vec3 m_lightPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+	glm::vec4 m_lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+	// draw commands for the sun, planets, satellites, orbits and asteroid belt chunks are recorded on worker threads,
+	// then merged and submitted in sorted order on the GL thread
+	JobSystem m_jobs;
+	FrameRecorder m_frameRecorder;
+	RenderQueue m_renderQueue;
+	GLStateCache m_stateCache;
+
+	// transient per frame data, reset at the start of render()
+	FrameArena m_frameArena;
+
+	// a model of the catalog drawn as its placeholder until the loader has it
+	struct PendingModel
+	{
+		PlaceholderModel model;
+		unsigned int asset;
+	};
+
+	StartupTimes m_startup;
+	std::string m_modelsDirectory;
+	// when the previous frame streamed, the upload budget is a share of the time since
+	uint64_t m_lastStream = 0;
+
+	// what's still streaming in, see stream()
+	std::vector<PendingModel> m_pendingModels;
+	unsigned int m_asteroidAsset = 0;
+	bool m_asteroidPending = false;
+	unsigned int m_skyboxAsset = 0;
+	// what the asteroid mesh is made with once its model is in: the instances, or the population it streams
+	std::vector<glm::mat4> m_asteroidInstances;
+	std::unique_ptr<PopulationStreamer> m_pendingPopulation;
+
+	// the skybox and orbits aren't needed for a first frame, so their programs aren't waited for while streaming:
+	// their passes are skipped until the driver is done with them
+	bool m_skyboxShaderReady = false;
+	bool m_orbitShaderReady = false;
+
+	// starts the loader's workers and makes the skybox of the cube map they fill in
+	void startLoading();
+	// resolves the skybox's and orbits' programs once they're ready, or right away with wait
+	void resolveShaders(bool wait);
+	// sets the loader's priorities by how large each pending asset is on screen (camera nullptr leaves them), uploads
+	// for up to budget nanoseconds (or until everything is in with wait) and swaps in whatever is complete
+	void stream(const Camera* camera, uint64_t budget, bool wait);
+
+public:
+	Shader m_defaultShader; // planets/satellites
+	Shader m_skyboxShader; // background
+	Shader m_lightSourceShader; // the sun
+	Shader m_asteroidShader; // asteroid belt
+	Shader m_orbitShader; // orbit trajectory
+
+	// every mesh's vertices and indices, and the textures and geometry shared between meshes, declared ahead of the
+	// meshes so they outlive them
+	GeometryArena m_geometry;
+	ResourceRegistry m_resources{ m_geometry };
+
+	std::unique_ptr<Mesh> m_asteroid;
+	std::vector<BeltChunk> m_beltChunks;
+	// when streaming, the asteroid mesh's instances are the streamer's slots and m_beltChunks is unused
+	std::unique_ptr<PopulationStreamer> m_population;
+
+	// sun, planets and satellites, and whatever else the catalog lists
+	BodyStore m_bodies;
+
+	std::unique_ptr<Skybox> m_skybox;
+
+	// the loader streaming the models, textures and skybox in, on a job system of its own since a frame's recording
+	// can't share one with it; both go once everything is in, declared after the registry and meshes so they go first
+	std::unique_ptr<JobSystem> m_loadJobs;
+	std::unique_ptr<AssetLoader> m_assets;
+
+	// populationBudget is the GPU memory for streamed minor planets, if there are any
+	// returns as soon as something can be drawn, the models, textures, belt and skybox stream in over the next frames
+	explicit Scene(const SceneDirectories& directories, size_t populationBudget = POPULATION_DEFAULT_BUDGET);
+
+	Scene(const Scene&) = delete;
+	Scene& operator=(const Scene&) = delete;
+
+	// advances rotations/orbits by the given number of days, honouring the GUI toggles
+	void update(double daysElapsed);
+
+	// records, sorts and submits the bodies, orbits and belt, then draws the skybox
+	// timer (optional) gets the GPU time of each pass
+	void render(Camera& camera, GpuTimer* timer);
+	// once the frame render() drew was swapped (or finished offscreen), the first call is the startup's first frame
+	void framePresented();
+
+	const RenderStats& getRenderStats() const { return m_renderQueue.getStats(); }
+	const FrameArena& getFrameArena() const { return m_frameArena; }
+	// nullptr unless the belt is streamed
+	PopulationStreamer* getPopulation() const { return m_population.get(); }
+
+	// blocks until every asset has streamed in, for renders that have to be complete from their first frame
+	void finishLoading();
+	bool isLoading() const { return m_assets != nullptr; }
+	// heap allocations of the calling thread and of the frame's recording workers, the asset loader's aren't included
+	uint64_t getAllocationCount() const { return AllocationTracker::getThreadCount() + m_jobs.getAllocationCount(); }
+	const StartupTimes& getStartupTimes() const { return m_startup; }
+};
@@ -1,8 +1,22 @@
 #include "Shader.h"
 
+#include <cstring>
+
+#include "AssetArchive.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "StartupTimeline.h"
+
 // reads text file and converts to string
 static std::string getFileContents(const char* filename)
 {
+	const uint8_t* archived;
+	size_t archivedSize;
+	if (findArchivedFile(filename, archived, archivedSize))
+	{
+		return std::string((const char*)archived, archivedSize);
+	}
+
 	std::ifstream in(filename, std::ios::binary);
 	if (in)
 	{
@@ -12,48 +26,140 @@ static std::string getFileContents(const char* filename)
 		in.seekg(0, std::ios::beg);
 		in.read(&contents[0], contents.size());
 		in.close();
+		StartupTimeline::addBytesRead(contents.size());
 		return(contents);
 	}
 	throw (errno);
 }
 
+ShaderStats Shader::s_stats;
+
 Shader::Shader(const char* vertexFile, const char* fragmentFile)
 {
+	PROFILE_ZONE("Shader::Shader");
+	STARTUP_ASSET("Shader::Shader", vertexFile);
+
+	uint64_t start = Profiler::now();
+	s_stats.programs++;
+
 	// read the files into strings
-	std::string vertexCode = getFileContents(vertexFile);
-	std::string fragmentCode = getFileContents(fragmentFile);
-	const char* vertexSource = vertexCode.c_str();
-	const char* fragmentSource = fragmentCode.c_str();
+	m_vertexCode = getFileContents(vertexFile);
+	m_fragmentCode = getFileContents(fragmentFile);
+
+	// the driver's own binary skips compiling and linking, it's only good for the sources and driver it came from
+	m_cachePath = std::string(vertexFile) + PROGRAM_CACHE_EXTENSION;
+	m_ID = glCreateProgram();
+	if (isProgramBinaryCacheActive())
+	{
+		m_sourceHash = hashProgramSources(m_vertexCode, m_fragmentCode);
+		m_fromBinary = loadProgramBinary(m_ID, m_cachePath, m_sourceHash);
+	}
+
+	if (!m_fromBinary)
+	{
+		compileProgram();
+	}
+	s_stats.issueMilliseconds += double(Profiler::now() - start) / 1e6;
+}
+
+void Shader::compileProgram()
+{
+	const char* vertexSource = m_vertexCode.c_str();
+	const char* fragmentSource = m_fragmentCode.c_str();
 
 	// create vertex shader object
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexSource, NULL);
-	glCompileShader(vertexShader);
-	compileErrors(vertexShader, "VERTEX");
+	m_vertexShader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(m_vertexShader, 1, &vertexSource, NULL);
+	glCompileShader(m_vertexShader);
 
 	// create fragment shader object
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-	glCompileShader(fragmentShader);
-	compileErrors(fragmentShader, "FRAGMENT");
-
-	// create composites shader object
-	m_ID = glCreateProgram();
+	m_fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(m_fragmentShader, 1, &fragmentSource, NULL);
+	glCompileShader(m_fragmentShader);
 
-	// attach vertex + fragment shaders and link together
-	glAttachShader(m_ID, vertexShader);
-	glAttachShader(m_ID, fragmentShader);
+	// attach vertex + fragment shaders and link together, the link waits for the compiles inside the driver
+	setProgramRetrievable(m_ID);
+	glAttachShader(m_ID, m_vertexShader);
+	glAttachShader(m_ID, m_fragmentShader);
 	glLinkProgram(m_ID);
-	compileErrors(m_ID, "PROGRAM");
+}
+
+bool Shader::checkProgram()
+{
+	// the shaders' logs say more than the link's when a compile failed
+	bool compiled = compileErrors(m_vertexShader, "VERTEX");
+	compiled = compileErrors(m_fragmentShader, "FRAGMENT") && compiled;
+	bool linked = compileErrors(m_ID, "PROGRAM");
 
 	// clean up
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	glDetachShader(m_ID, m_vertexShader);
+	glDetachShader(m_ID, m_fragmentShader);
+	glDeleteShader(m_vertexShader);
+	glDeleteShader(m_fragmentShader);
+	m_vertexShader = 0;
+	m_fragmentShader = 0;
+
+	return compiled && linked;
+}
+
+bool Shader::resolve()
+{
+	if (!m_pending)
+	{
+		return m_linked;
+	}
+
+	PROFILE_ZONE("Shader::resolve");
+	STARTUP_ASSET("Shader::resolve", m_cachePath);
+	uint64_t start = Profiler::now();
+	m_pending = false;
+
+	if (m_fromBinary)
+	{
+		// the driver is free to refuse any binary, it isn't an error
+		GLint linked = GL_FALSE;
+		glGetProgramiv(m_ID, GL_LINK_STATUS, &linked);
+		m_linked = linked == GL_TRUE;
+		if (m_linked)
+		{
+			s_stats.binaryHits++;
+		}
+		else
+		{
+			// a program the binary failed to load into can't be reliably linked again
+			s_stats.binaryRejects++;
+			glDeleteProgram(m_ID);
+			m_ID = glCreateProgram();
+			compileProgram();
+		}
+	}
+
+	if (!m_linked)
+	{
+		m_linked = checkProgram();
+		if (m_linked && isProgramBinaryCacheActive())
+		{
+			writeProgramBinary(m_ID, m_cachePath, m_sourceHash);
+		}
+	}
 
+	m_vertexCode.clear();
+	m_vertexCode.shrink_to_fit();
+	m_fragmentCode.clear();
+	m_fragmentCode.shrink_to_fit();
+
+	s_stats.waitMilliseconds += double(Profiler::now() - start) / 1e6;
+	return m_linked;
+}
+
+bool Shader::isReady() const
+{
+	return !m_pending || isProgramComplete(m_ID);
 }
 
 void Shader::bind()
 {
+	resolve();
 	glUseProgram(m_ID);
 }
 
@@ -62,13 +168,39 @@ void Shader::unbind()
 	glDeleteProgram(m_ID);
 }
 
-void Shader::compileErrors(unsigned int shader, const char* type)
+int Shader::getUniformLocation(const char* name)
+{
+	auto it = m_uniformLocations.find(name);
+	if (it != m_uniformLocations.end())
+	{
+		return it->second;
+	}
+
+	resolve();
+	int location = glGetUniformLocation(m_ID, name);
+	m_uniformLocations.emplace(name, location);
+	return location;
+}
+
+ProgramSlot Shader::getProgramSlot()
+{
+	// a rejected binary gives the program a new name
+	resolve();
+
+	ProgramSlot slot;
+	slot.program = m_ID;
+	slot.modelSlot = getUniformLocation("model");
+	slot.dequantizeSlot = getUniformLocation("dequantize");
+	return slot;
+}
+
+bool Shader::compileErrors(unsigned int shader, const char* type)
 {
 	// status of compilation
 	GLint hasCompiled;
 	// array to store error message in
 	char infoLog[1024];
-	if (type != "PROGRAM")
+	if (std::strcmp(type, "PROGRAM") != 0)
 	{
 		glGetShaderiv(shader, GL_COMPILE_STATUS, &hasCompiled);
 		if (hasCompiled == GL_FALSE)
@@ -86,4 +218,24 @@ void Shader::compileErrors(unsigned int shader, const char* type)
 			std::cout << "SHADER_LINKING_ERROR for:" << type << "\n" << infoLog << std::endl;
 		}
 	}
-}
\ No newline at end of file
+	return hasCompiled == GL_TRUE;
+}
+
+void Shader::printReport()
+{
+	std::cout << "Shaders: " << s_stats.programs << " programs, " << s_stats.issueMilliseconds << " ms issuing them, "
+		<< s_stats.waitMilliseconds << " ms waiting for them, " << s_stats.binaryHits << " from the program cache";
+	if (s_stats.binaryRejects > 0)
+	{
+		std::cout << ", " << s_stats.binaryRejects << " cached binaries rejected by the driver";
+	}
+	if (!isProgramBinaryCacheActive())
+	{
+		std::cout << " (no program binary support)";
+	}
+	if (isParallelShaderCompileActive())
+	{
+		std::cout << " (parallel compile)";
+	}
+	std::cout << std::endl;
+}
@@ -7,22 +7,88 @@
 #include<sstream>
 #include<iostream>
 #include<cerrno>
+#include <unordered_map>
+
+#include "CommandList.h"
 
 // reads text file and converts to string
 static std::string getFileContents(const char* filename);
 
+// what building the programs at startup took, for the startup report
+struct ShaderStats
+{
+	unsigned int programs = 0;
+	// linked straight from a cached binary
+	unsigned int binaryHits = 0;
+	// cached binaries the driver turned down, compiled from source instead
+	unsigned int binaryRejects = 0;
+	// reading the sources and issuing the compiles and links or handing over the binary, of every program
+	double issueMilliseconds = 0.0;
+	// blocked on the driver finishing them when each program was first used
+	double waitMilliseconds = 0.0;
+};
+
+/*
+* Program built from a vertex and a fragment shader
+* The constructor only issues the work: it hands the driver the cached binary (see ShaderCache.h) or starts compiling
+* and linking from source, without asking how it went. Status is checked by resolve() on first use (bind() and the
+* uniform lookups call it), so constructing every program up front lets the driver compile them all at once, on its
+* own threads with KHR_parallel_shader_compile, while the caller goes on loading assets.
+*/
 class Shader
 {
 private:
-	// checks for correct compilation
-	void compileErrors(unsigned int shader, const char* type);
+	// uniform locations looked up so far, glGetUniformLocation is a round trip to the driver
+	std::unordered_map<std::string, int> m_uniformLocations;
+
+	// issued by the constructor, not yet checked by resolve()
+	bool m_pending = true;
+	bool m_linked = false;
+	// handed a cached binary rather than compiled
+	bool m_fromBinary = false;
+	unsigned int m_vertexShader = 0;
+	unsigned int m_fragmentShader = 0;
+	// kept until resolved, compiling them is the way out when the driver rejects the binary
+	std::string m_vertexCode;
+	std::string m_fragmentCode;
+	std::string m_cachePath;
+	uint64_t m_sourceHash = 0;
+
+	// of every Shader constructed so far, only ever touched on the GL thread
+	static ShaderStats s_stats;
+
+	// checks for correct compilation, prints the log and returns false on failure
+	bool compileErrors(unsigned int shader, const char* type);
+	// starts compiling the sources and linking them into m_ID, nothing waits for the driver
+	void compileProgram();
+	// checks the shaders and the program compileProgram() issued and deletes the shaders, returns whether it linked
+	bool checkProgram();
 
 public:
 	unsigned int m_ID;
 
 	// constructor, build the shader from vertex + fragment shaders
+	// linked from the program cache next to the vertex shader when it was built from the same sources by the same
+	// driver, compiled and cached otherwise
 	Shader(const char* vertShader, const char* fragShader);
 
+	// waits for what the constructor issued, prints any errors and caches a freshly linked binary, returns whether
+	// the program linked; does nothing after the first call
+	bool resolve();
+	// whether resolve() would return without waiting, always true when the driver can't tell without waiting
+	// (no KHR_parallel_shader_compile)
+	bool isReady() const;
+
 	void bind();
 	void unbind();
+
+	// cached glGetUniformLocation
+	int getUniformLocation(const char* name);
+
+	// program + "model" uniform location, for recording draw commands off the GL thread
+	ProgramSlot getProgramSlot();
+
+	static const ShaderStats& getStats() { return s_stats; }
+	// one line: programs, how many came from the cache, time issuing them and waiting for them
+	static void printReport();
 };
\ No newline at end of file
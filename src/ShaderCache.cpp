@@ -0,0 +1,224 @@
+#include "ShaderCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "Hash.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+
+// ARB_get_program_binary is not part of the 3.3 core profile glad was generated for
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// neither is KHR_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+// let the driver pick how many threads it compiles on
+#define SHADER_COMPILER_THREADS_ANY 0xFFFFFFFFu
+
+typedef void (APIENTRYP PFNGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+// null until initShaderCompile() found them, the cache is then skipped
+static PFNGETPROGRAMBINARYPROC getProgramBinaryProc = nullptr;
+static PFNPROGRAMBINARYPROC programBinaryProc = nullptr;
+static PFNPROGRAMPARAMETERIPROC programParameteriProc = nullptr;
+// GL_COMPLETION_STATUS_KHR can be asked for once the driver compiles in parallel
+static bool parallelCompile = false;
+
+static bool hasExtension(const char* name)
+{
+	GLint numExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+	for (GLint i = 0; i < numExtensions; i++)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, GLuint(i));
+		if (extension != nullptr && std::strcmp(extension, name) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool initProgramBinaries(GLADloadproc loadProc)
+{
+	// core since 4.1 under the same names
+	if (GLVersion.major < 4 || (GLVersion.major == 4 && GLVersion.minor < 1))
+	{
+		if (!hasExtension("GL_ARB_get_program_binary"))
+		{
+			return false;
+		}
+	}
+
+	// some drivers expose the entry points but can't hand out a binary in any format
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if (formats <= 0)
+	{
+		return false;
+	}
+
+	getProgramBinaryProc = (PFNGETPROGRAMBINARYPROC)loadProc("glGetProgramBinary");
+	programBinaryProc = (PFNPROGRAMBINARYPROC)loadProc("glProgramBinary");
+	programParameteriProc = (PFNPROGRAMPARAMETERIPROC)loadProc("glProgramParameteri");
+	return getProgramBinaryProc != nullptr && programBinaryProc != nullptr && programParameteriProc != nullptr;
+}
+
+static bool initParallelCompile(GLADloadproc loadProc)
+{
+	// the ARB extension is the same with a suffixed entry point
+	PFNMAXSHADERCOMPILERTHREADSPROC maxShaderCompilerThreadsProc = nullptr;
+	if (hasExtension("GL_KHR_parallel_shader_compile"))
+	{
+		maxShaderCompilerThreadsProc = (PFNMAXSHADERCOMPILERTHREADSPROC)loadProc("glMaxShaderCompilerThreadsKHR");
+	}
+	else if (hasExtension("GL_ARB_parallel_shader_compile"))
+	{
+		maxShaderCompilerThreadsProc = (PFNMAXSHADERCOMPILERTHREADSPROC)loadProc("glMaxShaderCompilerThreadsARB");
+	}
+
+	if (maxShaderCompilerThreadsProc == nullptr)
+	{
+		return false;
+	}
+	maxShaderCompilerThreadsProc(SHADER_COMPILER_THREADS_ANY);
+	return true;
+}
+
+void initShaderCompile(GLADloadproc loadProc)
+{
+	if (!initProgramBinaries(loadProc))
+	{
+		getProgramBinaryProc = nullptr;
+		programBinaryProc = nullptr;
+		programParameteriProc = nullptr;
+	}
+	parallelCompile = initParallelCompile(loadProc);
+}
+
+bool isProgramBinaryCacheActive()
+{
+	return getProgramBinaryProc != nullptr;
+}
+
+bool isParallelShaderCompileActive()
+{
+	return parallelCompile;
+}
+
+bool isProgramComplete(unsigned int program)
+{
+	if (!parallelCompile)
+	{
+		return true;
+	}
+
+	GLint complete = GL_TRUE;
+	glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+static uint64_t hashString(const GLubyte* text, uint64_t hash)
+{
+	// the terminator too, so "ab" + "c" and "a" + "bc" differ
+	return text != nullptr ? hashBytes(text, std::strlen((const char*)text) + 1, hash) : hash;
+}
+
+uint64_t hashProgramSources(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	uint64_t hash = hashBytes(vertexSource.c_str(), vertexSource.size() + 1);
+	hash = hashBytes(fragmentSource.c_str(), fragmentSource.size() + 1, hash);
+	hash = hashString(glGetString(GL_VENDOR), hash);
+	hash = hashString(glGetString(GL_RENDERER), hash);
+	return hashString(glGetString(GL_VERSION), hash);
+}
+
+bool loadProgramBinary(unsigned int program, const std::string& cachePath, uint64_t sourceHash)
+{
+	PROFILE_ZONE("loadProgramBinary");
+
+	MappedFile file;
+	if (programBinaryProc == nullptr || !std::ifstream(cachePath).good() || !file.open(cachePath))
+	{
+		return false;
+	}
+
+	// a stale cache isn't an error, the shader or the driver just changed
+	const ProgramCacheHeader* header = (const ProgramCacheHeader*)file.getData();
+	if (file.getSize() < sizeof(ProgramCacheHeader) || header->magic != PROGRAM_CACHE_MAGIC || header->version != PROGRAM_CACHE_VERSION
+		|| header->sourceHash != sourceHash || header->binarySize != file.getSize() - sizeof(ProgramCacheHeader))
+	{
+		return false;
+	}
+
+	// GL copies the binary before returning, the mapping can go
+	programBinaryProc(program, GLenum(header->binaryFormat), file.getData() + sizeof(ProgramCacheHeader), GLsizei(header->binarySize));
+	return true;
+}
+
+void setProgramRetrievable(unsigned int program)
+{
+	if (programParameteriProc != nullptr)
+	{
+		programParameteriProc(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+}
+
+bool writeProgramBinary(unsigned int program, const std::string& cachePath, uint64_t sourceHash)
+{
+	PROFILE_ZONE("writeProgramBinary");
+
+	if (getProgramBinaryProc == nullptr)
+	{
+		return false;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> binary((size_t)length);
+	GLsizei written = 0;
+	GLenum format = 0;
+	getProgramBinaryProc(program, length, &written, &format, binary.data());
+	if (written <= 0)
+	{
+		return false;
+	}
+
+	ProgramCacheHeader header = {};
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.version = PROGRAM_CACHE_VERSION;
+	header.binaryFormat = format;
+	header.binarySize = uint32_t(written);
+	header.sourceHash = sourceHash;
+
+	// shaders read from the archive may have no directory to write next to, the program is just compiled again then
+	std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+	if (!out)
+	{
+		return false;
+	}
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)binary.data(), written);
+	if (!out)
+	{
+		std::cout << "Failed to write program cache: " << cachePath << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+
+#define PROGRAM_CACHE_MAGIC 0x43505348u // "HSPC" little-endian
+// bump whenever ProgramCacheHeader changes
+#define PROGRAM_CACHE_VERSION 1u
+// next to the vertex shader the program was linked from
+#define PROGRAM_CACHE_EXTENSION ".programcache"
+
+// followed by binarySize bytes of what glGetProgramBinary returned
+struct ProgramCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t binaryFormat;
+	uint32_t binarySize;
+	// hashProgramSources() of the sources and driver it was linked with
+	uint64_t sourceHash;
+};
+
+static_assert(sizeof(ProgramCacheHeader) == 24, "program cache header layout is part of the file format");
+
+// loads the program binary entry points if the context has them (4.1 or ARB_get_program_binary) and reports at least
+// one binary format, and lets the driver compile on as many threads as it likes if it has KHR_parallel_shader_compile
+// (or the ARB one); call once the context is current, before the first Shader
+void initShaderCompile(GLADloadproc loadProc);
+// whether Shader caches its programs
+bool isProgramBinaryCacheActive();
+bool isParallelShaderCompileActive();
+// whether the driver is done compiling or linking program, without waiting for it; true when it can't tell
+bool isProgramComplete(unsigned int program);
+
+// of both sources and the GL vendor, renderer and version strings, a binary is only good for the driver that made it
+uint64_t hashProgramSources(const std::string& vertexSource, const std::string& fragmentSource);
+
+// hands program the cached binary if it was made from the same sources and driver, false if there's none
+// the driver may still turn it down, which GL_LINK_STATUS tells, and a program that refused one can't be reused
+bool loadProgramBinary(unsigned int program, const std::string& cachePath, uint64_t sourceHash);
+// asks the driver to keep the binary of program retrievable, before it's linked
+void setProgramRetrievable(unsigned int program);
+// the binary of a linked program, for the next start
+bool writeProgramBinary(unsigned int program, const std::string& cachePath, uint64_t sourceHash);
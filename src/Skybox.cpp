@@ -1,13 +1,22 @@
 #include "Skybox.h"
 
+#include "Profiler.h"
+#include "StartupTimeline.h"
+
 
 Skybox::Skybox(std::string directory)
 {
 	initSkybox();
-	getTexturePaths(directory);
+	getTexturePaths(directory, m_cubemapPaths);
 	createCubeMap();
 }
 
+Skybox::Skybox(unsigned int cubemapTexID)
+	: m_cubemapTexID(cubemapTexID)
+{
+	initSkybox();
+}
+
 void Skybox::initSkybox() {
 	// create VAO, VBO, EBO for the skybox
 	glGenVertexArrays(1, &m_vao);
@@ -34,7 +43,7 @@ void Skybox::initSkybox() {
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-void Skybox::getTexturePaths(std::string directory)
+void Skybox::getTexturePaths(const std::string& directory, std::string paths[6])
 {
 	// faces of the cubemap
 	std::string cubemapPaths[6] =
@@ -48,13 +57,15 @@ void Skybox::getTexturePaths(std::string directory)
 	};
 
 	// copy the data in
-	std::copy(cubemapPaths, cubemapPaths + 6, m_cubemapPaths);
+	std::copy(cubemapPaths, cubemapPaths + 6, paths);
 }
 
-void Skybox::createCubeMap() {
+unsigned int Skybox::createCubeMapTexture()
+{
 	// create cubemap texture object
-	glGenTextures(1, &m_cubemapTexID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubemapTexID);
+	unsigned int cubemapTexID;
+	glGenTextures(1, &cubemapTexID);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexID);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
@@ -65,13 +76,26 @@ void Skybox::createCubeMap() {
 	// apparently useful to prevent seams on some systems
 	//glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
+	return cubemapTexID;
+}
+
+void Skybox::createCubeMap() {
+	PROFILE_ZONE("Skybox::createCubeMap");
+	STARTUP_PHASE("Skybox::createCubeMap");
+
+	// stays bound for the faces
+	m_cubemapTexID = createCubeMapTexture();
+
 	// cycle through and attaches all textures to cubemap
 	for (unsigned int i = 0; i < 6; i++)
 	{
+		STARTUP_ASSET("Cube map face", m_cubemapPaths[i]);
+		StartupTimeline::addFileRead(m_cubemapPaths[i]);
 		int width, height, nrChannels;
 		unsigned char* data = stbi_load(m_cubemapPaths[i].c_str(), &width, &height, &nrChannels, 0);
 		if (data)
 		{
+			StartupTimeline::addBytesUploaded(uint64_t(width) * height * 3);
 			stbi_set_flip_vertically_on_load(false);
 			//stbi_set_flip_vertically_on_load(true);
 			glTexImage2D
@@ -110,7 +134,7 @@ void Skybox::draw(Shader& shader, const Camera& camera)
 	// last row and column affect the translation of the skybox, don't want to change
 	view = glm::mat4(glm::mat3(glm::lookAt(camera.m_position, camera.m_position + camera.m_orientation, camera.m_upDirection)));
 	projection = glm::perspective(camera.m_FOVdeg, (float)camera.m_width / camera.m_height, camera.m_nearPlane, camera.m_farPlane);
-	glUniformMatrix4fv(glGetUniformLocation(shader.m_ID, "camMatrix"), 1, GL_FALSE, glm::value_ptr(projection * view));
+	glUniformMatrix4fv(shader.getUniformLocation("camMatrix"), 1, GL_FALSE, glm::value_ptr(projection * view));
 
 	// draw the cubemap as the last object to save a bit of performance by discarding all fragments
 	// where an object is present (a depth of 1.0f will always fail against any object's depth value)
@@ -63,14 +63,20 @@ private:
 	// initializes and send vertices and indices data to buffers
 	void initSkybox();
 
-	// fills in array of filepaths
-	void getTexturePaths(std::string directory);
-
 	// uses skybox textures to create cubemap
 	void createCubeMap();
 
 public:
+	// decodes and uploads the faces in the directory
 	Skybox(std::string directory);
+	// with faces loaded elsewhere (see AssetLoader), takes over the cubemap texture
+	explicit Skybox(unsigned int cubemapTexID);
+
+	// fills in array of filepaths, in the order of the cubemap's faces
+	static void getTexturePaths(const std::string& directory, std::string paths[6]);
+
+	// empty cubemap texture object with the skybox's filtering and wrapping, faces still to be uploaded
+	static unsigned int createCubeMapTexture();
 
 	void draw(Shader& shader, const Camera& camera);
 };
\ No newline at end of file
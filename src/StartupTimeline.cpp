@@ -0,0 +1,357 @@
+#include "StartupTimeline.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "imgui/imgui.h"
+#include "Profiler.h"
+
+// a scope that hasn't closed yet, counting the bytes of whatever is nested in it too
+struct OpenStartupScope
+{
+	const char* name;
+	std::string asset;
+	uint64_t start;
+	uint64_t cpuStart;
+	uint64_t bytesRead;
+	uint64_t bytesUploaded;
+};
+
+std::atomic<bool> StartupTimeline::s_recording{ false };
+
+static std::mutex timelineMutex;
+static std::vector<StartupEntry> entries;
+static std::vector<StartupMark> marks;
+static std::string jsonPath;
+// Profiler::now() of begin() and end(), 0 until they were called
+static uint64_t timelineStart = 0;
+static uint64_t timelineEnd = 0;
+static std::atomic<unsigned int> nextThread{ 1 };
+
+static thread_local std::vector<OpenStartupScope> openScopes;
+static thread_local unsigned int threadIndex = 0;
+static thread_local bool threadNumbered = false;
+
+static unsigned int getThreadIndex()
+{
+	if (!threadNumbered)
+	{
+		threadIndex = nextThread.fetch_add(1, std::memory_order_relaxed);
+		threadNumbered = true;
+	}
+	return threadIndex;
+}
+
+// nested entries are already part of the outermost ones
+static void getTotalBytes(const std::vector<StartupEntry>& finished, uint64_t& bytesRead, uint64_t& bytesUploaded)
+{
+	bytesRead = 0;
+	bytesUploaded = 0;
+	for (const StartupEntry& entry : finished)
+	{
+		if (entry.depth == 0)
+		{
+			bytesRead += entry.bytesRead;
+			bytesUploaded += entry.bytesUploaded;
+		}
+	}
+}
+
+void StartupTimeline::begin(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(timelineMutex);
+	entries.clear();
+	marks.clear();
+	jsonPath = path;
+	timelineStart = Profiler::now();
+	timelineEnd = 0;
+
+	threadIndex = 0;
+	threadNumbered = true;
+	s_recording.store(true, std::memory_order_relaxed);
+}
+
+void StartupTimeline::end()
+{
+	{
+		std::lock_guard<std::mutex> lock(timelineMutex);
+		if (!s_recording.load(std::memory_order_relaxed))
+		{
+			return;
+		}
+		s_recording.store(false, std::memory_order_relaxed);
+		timelineEnd = Profiler::now();
+	}
+
+	uint64_t bytesRead, bytesUploaded;
+	std::vector<StartupEntry> finished = getEntries();
+	getTotalBytes(finished, bytesRead, bytesUploaded);
+	std::cout << "Startup: " << double(timelineEnd - timelineStart) / 1e6 << " ms, " << finished.size() << " phases and assets, "
+		<< bytesRead / 1024 << " KB read, " << bytesUploaded / 1024 << " KB uploaded" << std::endl;
+
+	if (!jsonPath.empty())
+	{
+		writeJSON(jsonPath);
+	}
+}
+
+void StartupTimeline::mark(const char* name)
+{
+	if (!isRecording())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(timelineMutex);
+	marks.push_back({ name, Profiler::now() - timelineStart });
+}
+
+void StartupTimeline::open(const char* name, const std::string& asset)
+{
+	openScopes.push_back({ name, asset, Profiler::now(), getThreadCpuTime(), 0, 0 });
+}
+
+void StartupTimeline::close()
+{
+	OpenStartupScope scope = std::move(openScopes.back());
+	openScopes.pop_back();
+
+	if (!openScopes.empty())
+	{
+		openScopes.back().bytesRead += scope.bytesRead;
+		openScopes.back().bytesUploaded += scope.bytesUploaded;
+	}
+
+	// opened before end(), closed after it
+	if (!isRecording())
+	{
+		return;
+	}
+
+	uint64_t end = Profiler::now();
+	uint64_t cpu = getThreadCpuTime() - scope.cpuStart;
+	std::lock_guard<std::mutex> lock(timelineMutex);
+	entries.push_back({ scope.name, std::move(scope.asset), getThreadIndex(), (unsigned int)openScopes.size(),
+		scope.start - std::min(scope.start, timelineStart), end - scope.start, cpu, scope.bytesRead, scope.bytesUploaded });
+}
+
+void StartupTimeline::addBytesRead(uint64_t bytes)
+{
+	if (isRecording() && !openScopes.empty())
+	{
+		openScopes.back().bytesRead += bytes;
+	}
+}
+
+void StartupTimeline::addBytesUploaded(uint64_t bytes)
+{
+	if (isRecording() && !openScopes.empty())
+	{
+		openScopes.back().bytesUploaded += bytes;
+	}
+}
+
+void StartupTimeline::addFileRead(const std::string& path)
+{
+	if (!isRecording() || openScopes.empty())
+	{
+		return;
+	}
+
+	std::error_code error;
+	uintmax_t size = std::filesystem::file_size(path, error);
+	if (!error)
+	{
+		openScopes.back().bytesRead += uint64_t(size);
+	}
+}
+
+uint64_t StartupTimeline::getThreadCpuTime()
+{
+#ifdef _WIN32
+	// in 100 ns units, though only updated every scheduler tick
+	FILETIME creation, exit, kernel, user;
+	if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+	{
+		return 0;
+	}
+	uint64_t kernelTime = (uint64_t(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+	uint64_t userTime = (uint64_t(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+	return (kernelTime + userTime) * 100;
+#else
+	timespec time;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+	{
+		return 0;
+	}
+	return uint64_t(time.tv_sec) * 1000000000ull + uint64_t(time.tv_nsec);
+#endif
+}
+
+uint64_t StartupTimeline::getBeginTime()
+{
+	std::lock_guard<std::mutex> lock(timelineMutex);
+	return timelineStart;
+}
+
+std::vector<StartupEntry> StartupTimeline::getEntries()
+{
+	std::vector<StartupEntry> copy;
+	{
+		std::lock_guard<std::mutex> lock(timelineMutex);
+		copy = entries;
+	}
+
+	// recorded as they close, so nested scopes come before the ones around them
+	std::stable_sort(copy.begin(), copy.end(), [](const StartupEntry& a, const StartupEntry& b)
+	{
+		return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+	});
+	return copy;
+}
+
+std::vector<StartupMark> StartupTimeline::getMarks()
+{
+	std::lock_guard<std::mutex> lock(timelineMutex);
+	return marks;
+}
+
+// paths are Windows paths on Windows, keep the JSON valid whatever they contain
+static void writeEscaped(std::ofstream& out, const char* text)
+{
+	for (const char* c = text; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			out << '\\';
+		}
+		out << *c;
+	}
+}
+
+bool StartupTimeline::writeJSON(const std::string& path)
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		std::cout << "Failed to write startup timeline: " << path << std::endl;
+		return false;
+	}
+
+	std::vector<StartupEntry> finished = getEntries();
+	std::vector<StartupMark> points = getMarks();
+	uint64_t total = timelineEnd != 0 ? timelineEnd - timelineStart : Profiler::now() - timelineStart;
+	auto toMs = [](uint64_t nanoseconds) { return double(nanoseconds) / 1e6; };
+
+	uint64_t bytesRead, bytesUploaded;
+	getTotalBytes(finished, bytesRead, bytesUploaded);
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\n  \"total_ms\": " << toMs(total) << ",\n  \"complete\": " << (timelineEnd != 0 ? "true" : "false")
+		<< ",\n  \"bytes_read\": " << bytesRead << ",\n  \"bytes_uploaded\": " << bytesUploaded << ",\n  \"marks\": [";
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		out << (i == 0 ? "\n    {\"name\":\"" : ",\n    {\"name\":\"");
+		writeEscaped(out, points[i].name);
+		out << "\",\"ms\":" << toMs(points[i].time) << "}";
+	}
+	out << "\n  ],\n  \"entries\": [";
+	for (size_t i = 0; i < finished.size(); i++)
+	{
+		const StartupEntry& entry = finished[i];
+		out << (i == 0 ? "\n    {\"name\":\"" : ",\n    {\"name\":\"");
+		writeEscaped(out, entry.name);
+		out << "\",\"asset\":\"";
+		writeEscaped(out, entry.asset.c_str());
+		out << "\",\"thread\":" << entry.thread << ",\"depth\":" << entry.depth << ",\"start_ms\":" << toMs(entry.start)
+			<< ",\"wall_ms\":" << toMs(entry.wall) << ",\"cpu_ms\":" << toMs(entry.cpu) << ",\"bytes_read\":" << entry.bytesRead
+			<< ",\"bytes_uploaded\":" << entry.bytesUploaded << "}";
+	}
+	out << "\n  ]\n}\n";
+
+	std::cout << "Wrote startup timeline: " << path << std::endl;
+	return true;
+}
+
+void StartupTimeline::drawOverlay()
+{
+	ImGui::Begin("Startup Timeline");
+
+	std::vector<StartupEntry> finished = getEntries();
+	std::vector<StartupMark> points = getMarks();
+	uint64_t total = timelineEnd != 0 ? timelineEnd - timelineStart : Profiler::now() - timelineStart;
+
+	uint64_t bytesRead, bytesUploaded;
+	getTotalBytes(finished, bytesRead, bytesUploaded);
+
+	ImGui::Text("%s %.1f ms, %.1f MB read, %.1f MB uploaded", timelineEnd != 0 ? "Startup" : "Still starting up,", total / 1e6,
+		bytesRead / (1024.0 * 1024.0), bytesUploaded / (1024.0 * 1024.0));
+	for (const StartupMark& point : points)
+	{
+		ImGui::Text("%s at %.1f ms", point.name, point.time / 1e6);
+	}
+
+	if (ImGui::Button("Export JSON"))
+	{
+		writeJSON(STARTUP_TIMELINE_DEFAULT_PATH);
+	}
+
+	ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable;
+	if (ImGui::BeginTable("entries", 8, flags, ImVec2(0.0f, 400.0f)))
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("phase");
+		ImGui::TableSetupColumn("asset");
+		ImGui::TableSetupColumn("thread");
+		ImGui::TableSetupColumn("wall ms");
+		ImGui::TableSetupColumn("cpu ms");
+		ImGui::TableSetupColumn("read KB");
+		ImGui::TableSetupColumn("uploaded KB");
+		ImGui::TableSetupColumn("when", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableHeadersRow();
+
+		for (const StartupEntry& entry : finished)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%*s%s", int(entry.depth * 2), "", entry.name);
+			// the file name, the directories are in the tooltip
+			ImGui::TableNextColumn(); ImGui::TextUnformatted(entry.asset.c_str() + entry.asset.find_last_of("/\\") + 1);
+			if (!entry.asset.empty() && ImGui::IsItemHovered())
+			{
+				ImGui::SetTooltip("%s", entry.asset.c_str());
+			}
+			ImGui::TableNextColumn(); ImGui::Text("%u", entry.thread);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", entry.wall / 1e6);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", entry.cpu / 1e6);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", entry.bytesRead / 1024.0);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", entry.bytesUploaded / 1024.0);
+
+			// where in the whole startup it ran, at least a pixel wide
+			ImGui::TableNextColumn();
+			ImVec2 position = ImGui::GetCursorScreenPos();
+			float width = ImGui::GetContentRegionAvail().x;
+			float height = ImGui::GetTextLineHeight();
+			float from = total > 0 ? float(double(entry.start) / double(total)) * width : 0.0f;
+			float length = total > 0 ? std::max(float(double(entry.wall) / double(total)) * width, 1.0f) : 1.0f;
+			ImGui::GetWindowDrawList()->AddRectFilled(ImVec2(position.x + from, position.y),
+				ImVec2(position.x + from + length, position.y + height), IM_COL32(90, 160, 230, 255));
+			ImGui::Dummy(ImVec2(width, height));
+		}
+
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
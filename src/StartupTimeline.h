@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+* Where cold start goes, phase by phase and asset by asset
+* STARTUP_PHASE("name") times the enclosing scope, STARTUP_ASSET("name", path) does the same for the one file the scope
+* loads. Each records its wall time, the CPU time of the thread it ran on, and the bytes read from disk and uploaded
+* to the GPU inside it, which the loaders report through addBytesRead() and addBytesUploaded(). A scope includes the
+* bytes of the scopes nested in it on the same thread, as it includes their time.
+* Recording runs from begin() in main() until end() once the scene is at full quality, scopes cost one relaxed atomic
+* load afterwards. The result is shown by drawOverlay() and written as JSON by writeJSON().
+*/
+
+#define STARTUP_CONCAT_INNER(a, b) a##b
+#define STARTUP_CONCAT(a, b) STARTUP_CONCAT_INNER(a, b)
+#define STARTUP_PHASE(name) StartupZone STARTUP_CONCAT(startupZone, __LINE__)(name)
+#define STARTUP_ASSET(name, path) StartupZone STARTUP_CONCAT(startupZone, __LINE__)(name, path)
+
+// where the overlay's "Export JSON" writes to
+#define STARTUP_TIMELINE_DEFAULT_PATH "startup_timeline.json"
+
+// one finished phase or asset
+struct StartupEntry
+{
+	// a string literal
+	const char* name;
+	// empty for a phase that isn't about one file
+	std::string asset;
+	// 0 is the thread that called begin(), the rest are numbered as they first record
+	unsigned int thread;
+	// scopes open on the same thread around it
+	unsigned int depth;
+	// nanoseconds, the start since begin()
+	uint64_t start;
+	uint64_t wall;
+	uint64_t cpu;
+	uint64_t bytesRead;
+	uint64_t bytesUploaded;
+};
+
+// a point in time rather than a span, such as the first frame
+struct StartupMark
+{
+	const char* name;
+	// nanoseconds since begin()
+	uint64_t time;
+};
+
+class StartupTimeline
+{
+private:
+	static std::atomic<bool> s_recording;
+
+	static void open(const char* name, const std::string& asset);
+	static void close();
+
+	friend class StartupZone;
+
+public:
+	static bool isRecording() { return s_recording.load(std::memory_order_relaxed); }
+
+	// starts recording with the calling thread as thread 0, end() writes the JSON to jsonPath when it's not empty
+	static void begin(const std::string& jsonPath = std::string());
+	// stops recording and prints the totals, only the first call after begin() does anything
+	static void end();
+
+	// when something the timeline should show happened, on whichever thread
+	static void mark(const char* name);
+	// Profiler::now() of the last begin(), 0 before any
+	static uint64_t getBeginTime();
+
+	// counted in the innermost scope open on the calling thread, dropped outside of any
+	static void addBytesRead(uint64_t bytes);
+	static void addBytesUploaded(uint64_t bytes);
+	// for a file read whole by a library that doesn't say how much it read (stb_image), its size on disk
+	static void addFileRead(const std::string& path);
+
+	// nanoseconds of CPU time the calling thread has used, user and kernel
+	static uint64_t getThreadCpuTime();
+
+	// copies of what was recorded so far, by start
+	static std::vector<StartupEntry> getEntries();
+	static std::vector<StartupMark> getMarks();
+
+	static bool writeJSON(const std::string& path);
+	// window with the totals, the marks and one row per entry with a bar of when it ran
+	static void drawOverlay();
+};
+
+// times the enclosing scope, use through STARTUP_PHASE or STARTUP_ASSET
+class StartupZone
+{
+private:
+	bool m_recording;
+
+public:
+	explicit StartupZone(const char* name)
+		: m_recording(StartupTimeline::isRecording())
+	{
+		if (m_recording)
+		{
+			StartupTimeline::open(name, std::string());
+		}
+	}
+
+	StartupZone(const char* name, const std::string& asset)
+		: m_recording(StartupTimeline::isRecording())
+	{
+		if (m_recording)
+		{
+			StartupTimeline::open(name, asset);
+		}
+	}
+
+	~StartupZone()
+	{
+		if (m_recording)
+		{
+			StartupTimeline::close();
+		}
+	}
+
+	StartupZone(const StartupZone&) = delete;
+	StartupZone& operator=(const StartupZone&) = delete;
+};
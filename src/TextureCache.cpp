@@ -0,0 +1,540 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <stb/stb_image.h>
+
+#include "AssetArchive.h"
+#include "GLErrors.h"
+#include "Hash.h"
+#include "Profiler.h"
+#include "StartupTimeline.h"
+
+uint64_t hashImageSource(const std::string& path, bool mipmaps)
+{
+	PROFILE_ZONE("hashImageSource");
+
+	MappedFile image;
+	if (!std::ifstream(path).good() || !image.open(path))
+	{
+		return 0;
+	}
+
+	uint64_t hash = hashBytes(image.getData(), image.getSize(), HASH_SEED ^ (mipmaps ? 1 : 0));
+	return hash != 0 ? hash : 1;
+}
+
+// 8-bit color to RGB565 and back, the way decoders expand it (bits replicated into the low bits)
+static uint16_t toRGB565(const float color[3])
+{
+	int r = std::clamp(int(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+	int g = std::clamp(int(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+	int b = std::clamp(int(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+	return uint16_t((r << 11) | (g << 5) | b);
+}
+
+static void fromRGB565(uint16_t color, int out[3])
+{
+	int r = (color >> 11) & 31;
+	int g = (color >> 5) & 63;
+	int b = color & 31;
+	out[0] = (r << 3) | (r >> 2);
+	out[1] = (g << 2) | (g >> 4);
+	out[2] = (b << 3) | (b >> 2);
+}
+
+// picks the closest of the 4 colors between the endpoints for every texel, returns the squared error
+// color0 must be greater than color1 (4 color mode), equal endpoints make every index 0
+static int selectIndicesBC1(const int block[16][3], uint16_t color0, uint16_t color1, uint32_t& indices)
+{
+	int palette[4][3];
+	fromRGB565(color0, palette[0]);
+	fromRGB565(color1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	int candidates = color0 == color1 ? 1 : 4;
+	int error = 0;
+	indices = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int best = 0, bestError = 0x7FFFFFFF;
+		for (int p = 0; p < candidates; p++)
+		{
+			int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+			int distance = dr * dr + dg * dg + db * db;
+			if (distance < bestError)
+			{
+				best = p;
+				bestError = distance;
+			}
+		}
+		indices |= uint32_t(best) << (2 * i);
+		error += bestError;
+	}
+	return error;
+}
+
+// endpoints in 4 color order with their indices, returns the squared error
+static int evaluateBC1(const int block[16][3], uint16_t& color0, uint16_t& color1, uint32_t& indices)
+{
+	if (color0 < color1)
+	{
+		std::swap(color0, color1);
+	}
+	return selectIndicesBC1(block, color0, color1, indices);
+}
+
+static void encodeBlockBC1(const int block[16][3], uint8_t out[8])
+{
+	// endpoints at the extremes of the block's principal axis
+	float mean[3] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			mean[c] += block[i][c] / 16.0f;
+		}
+	}
+
+	float covariance[6] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		float r = block[i][0] - mean[0], g = block[i][1] - mean[1], b = block[i][2] - mean[2];
+		covariance[0] += r * r;
+		covariance[1] += r * g;
+		covariance[2] += r * b;
+		covariance[3] += g * g;
+		covariance[4] += g * b;
+		covariance[5] += b * b;
+	}
+
+	// power iteration, a few steps are plenty to separate the endpoints
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 4; iteration++)
+	{
+		float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+		float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+		float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+		float length = std::max({ std::fabs(x), std::fabs(y), std::fabs(z) });
+		if (length < 1e-6f)
+		{
+			break;
+		}
+		axis[0] = x / length;
+		axis[1] = y / length;
+		axis[2] = z / length;
+	}
+
+	int minTexel = 0, maxTexel = 0;
+	float minProjection = 1e30f, maxProjection = -1e30f;
+	for (int i = 0; i < 16; i++)
+	{
+		float projection = block[i][0] * axis[0] + block[i][1] * axis[1] + block[i][2] * axis[2];
+		if (projection < minProjection)
+		{
+			minProjection = projection;
+			minTexel = i;
+		}
+		if (projection > maxProjection)
+		{
+			maxProjection = projection;
+			maxTexel = i;
+		}
+	}
+
+	float high[3] = { float(block[maxTexel][0]), float(block[maxTexel][1]), float(block[maxTexel][2]) };
+	float low[3] = { float(block[minTexel][0]), float(block[minTexel][1]), float(block[minTexel][2]) };
+	uint16_t color0 = toRGB565(high), color1 = toRGB565(low);
+	uint32_t indices;
+	int error = evaluateBC1(block, color0, color1, indices);
+
+	// least squares endpoints for the chosen indices, kept while they lower the error
+	const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	for (int iteration = 0; iteration < 2 && error > 0 && color0 != color1; iteration++)
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[3] = {}, bx[3] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float a = weights[(indices >> (2 * i)) & 3], b = 1.0f - a;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < 3; c++)
+			{
+				ax[c] += a * block[i][c];
+				bx[c] += b * block[i][c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f)
+		{
+			break;
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			high[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+			low[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+		}
+
+		uint16_t refined0 = toRGB565(high), refined1 = toRGB565(low);
+		uint32_t refinedIndices;
+		int refinedError = evaluateBC1(block, refined0, refined1, refinedIndices);
+		if (refinedError >= error)
+		{
+			break;
+		}
+		color0 = refined0;
+		color1 = refined1;
+		indices = refinedIndices;
+		error = refinedError;
+	}
+
+	// little endian: both endpoints, then 2 bits per texel in row order
+	out[0] = uint8_t(color0);
+	out[1] = uint8_t(color0 >> 8);
+	out[2] = uint8_t(color1);
+	out[3] = uint8_t(color1 >> 8);
+	out[4] = uint8_t(indices);
+	out[5] = uint8_t(indices >> 8);
+	out[6] = uint8_t(indices >> 16);
+	out[7] = uint8_t(indices >> 24);
+}
+
+size_t compressedSizeBC1(int width, int height)
+{
+	return size_t((width + 3) / 4) * size_t((height + 3) / 4) * BC1_BLOCK_BYTES;
+}
+
+void compressBC1(const unsigned char* pixels, int width, int height, int channels, uint8_t* out)
+{
+	PROFILE_ZONE("compressBC1");
+
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	for (int blockY = 0; blockY < blocksY; blockY++)
+	{
+		for (int blockX = 0; blockX < blocksX; blockX++)
+		{
+			int block[16][3];
+			for (int i = 0; i < 16; i++)
+			{
+				int x = std::min(blockX * 4 + i % 4, width - 1);
+				int y = std::min(blockY * 4 + i / 4, height - 1);
+				const unsigned char* texel = pixels + (size_t(y) * width + x) * channels;
+				for (int c = 0; c < 3; c++)
+				{
+					block[i][c] = channels >= 3 ? texel[c] : texel[0];
+				}
+			}
+			encodeBlockBC1(block, out + (size_t(blockY) * blocksX + blockX) * BC1_BLOCK_BYTES);
+		}
+	}
+}
+
+void downsampleRGB(const unsigned char* pixels, int width, int height, std::vector<unsigned char>& out)
+{
+	int halfWidth = std::max(1, width / 2), halfHeight = std::max(1, height / 2);
+	out.resize(size_t(halfWidth) * halfHeight * 3);
+
+	for (int y = 0; y < halfHeight; y++)
+	{
+		const unsigned char* row0 = pixels + size_t(std::min(2 * y, height - 1)) * width * 3;
+		const unsigned char* row1 = pixels + size_t(std::min(2 * y + 1, height - 1)) * width * 3;
+		for (int x = 0; x < halfWidth; x++)
+		{
+			int x0 = std::min(2 * x, width - 1) * 3, x1 = std::min(2 * x + 1, width - 1) * 3;
+			for (int c = 0; c < 3; c++)
+			{
+				out[(size_t(y) * halfWidth + x) * 3 + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+			}
+		}
+	}
+}
+
+bool isTextureCompressionSupported()
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+	std::vector<GLint> formats(size_t(std::max(count, 0)));
+	if (count > 0)
+	{
+		glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+	}
+	if (std::find(formats.begin(), formats.end(), GLint(GL_COMPRESSED_RGB_S3TC_DXT1_EXT)) != formats.end())
+	{
+		return true;
+	}
+
+	// some drivers only list the formats of core extensions, the s3tc extension is checked by name too
+	GLint extensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+	for (GLint i = 0; i < extensions; i++)
+	{
+		const char* name = (const char*)glGetStringi(GL_EXTENSIONS, GLuint(i));
+		if (name != nullptr && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CompressedTexture::setBlob(const uint8_t* data, size_t size, uint64_t sourceHash)
+{
+	const TextureCacheHeader* header = (const TextureCacheHeader*)data;
+	bool valid = size >= sizeof(TextureCacheHeader) && header->magic == TEXTURE_CACHE_MAGIC && header->version == TEXTURE_CACHE_VERSION
+		&& header->format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT && (sourceHash == 0 || header->sourceHash == sourceHash) && header->size == size
+		&& header->levelCount > 0 && header->levelCount <= TEXTURE_CACHE_MAX_LEVELS
+		&& header->levelCount <= (size - sizeof(TextureCacheHeader)) / sizeof(TextureCacheLevel);
+
+	const TextureCacheLevel* levels = (const TextureCacheLevel*)(data + sizeof(TextureCacheHeader));
+	for (uint32_t i = 0; valid && i < header->levelCount; i++)
+	{
+		const TextureCacheLevel& level = levels[i];
+		valid = level.width == std::max(1u, header->width >> i) && level.height == std::max(1u, header->height >> i)
+			&& level.size == compressedSizeBC1(int(level.width), int(level.height))
+			&& level.offset % TEXTURE_CACHE_ALIGNMENT == 0 && level.offset <= size && size - level.offset >= level.size;
+	}
+
+	if (!valid)
+	{
+		return false;
+	}
+
+	m_header = header;
+	m_levels = levels;
+	return true;
+}
+
+bool CompressedTexture::mapCache(const std::string& cachePath, uint64_t sourceHash)
+{
+	if (!std::ifstream(cachePath).good() || !m_file.open(cachePath))
+	{
+		return false;
+	}
+
+	// a stale cache isn't an error, the image just changed
+	if (!setBlob(m_file.getData(), m_file.getSize(), sourceHash))
+	{
+		m_file.close();
+		return false;
+	}
+	return true;
+}
+
+bool CompressedTexture::load(const std::string& path, bool mipmaps)
+{
+	PROFILE_ZONE("CompressedTexture::load");
+
+	m_file.close();
+	m_blob.clear();
+	m_header = nullptr;
+	m_levels = nullptr;
+
+	// packed by packAssets() with the levels this load asks for, there's no image next to it to check against
+	const uint8_t* archived;
+	size_t archivedSize;
+	if (findArchivedFile(path + TEXTURE_CACHE_EXTENSION, archived, archivedSize))
+	{
+		return setBlob(archived, archivedSize, 0);
+	}
+
+	uint64_t sourceHash = hashImageSource(path, mipmaps);
+	if (sourceHash == 0)
+	{
+		return false;
+	}
+
+	std::string cachePath = path + TEXTURE_CACHE_EXTENSION;
+	if (mapCache(cachePath, sourceHash))
+	{
+		return true;
+	}
+
+	int width, height, channels;
+	unsigned char* pixels;
+	{
+		PROFILE_ZONE("stbi_load");
+		StartupTimeline::addFileRead(path);
+		pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+	}
+	if (pixels == nullptr)
+	{
+		return false;
+	}
+
+	bool compressed = compress(pixels, width, height, channels, mipmaps, sourceHash);
+	stbi_image_free(pixels);
+	if (!compressed)
+	{
+		return false;
+	}
+
+	// a rebuild is rare enough to be worth telling about
+	std::cout << "Compressed " << path << ": " << width << "x" << height << ", " << getLevelCount() << " levels, "
+		<< size_t(width) * height * 3 << " -> " << getDataSize() << " bytes" << std::endl;
+
+	// serve this load from memory either way, the cache is for the next one
+	write(cachePath);
+	return true;
+}
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + TEXTURE_CACHE_ALIGNMENT - 1) / TEXTURE_CACHE_ALIGNMENT * TEXTURE_CACHE_ALIGNMENT;
+}
+
+bool CompressedTexture::compress(const unsigned char* pixels, int width, int height, int channels, bool mipmaps, uint64_t sourceHash)
+{
+	PROFILE_ZONE("CompressedTexture::compress");
+
+	if (width <= 0 || height <= 0 || channels <= 0)
+	{
+		return false;
+	}
+
+	uint32_t levelCount = 1;
+	while (mipmaps && std::max(width, height) >> levelCount > 0 && levelCount < TEXTURE_CACHE_MAX_LEVELS)
+	{
+		levelCount++;
+	}
+
+	TextureCacheHeader header = {};
+	header.magic = TEXTURE_CACHE_MAGIC;
+	header.version = TEXTURE_CACHE_VERSION;
+	header.format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	header.width = uint32_t(width);
+	header.height = uint32_t(height);
+	header.levelCount = levelCount;
+	header.sourceHash = sourceHash;
+
+	std::vector<TextureCacheLevel> levels(levelCount);
+	uint64_t offset = sizeof(TextureCacheHeader) + levelCount * sizeof(TextureCacheLevel);
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		levels[i].width = std::max(1u, header.width >> i);
+		levels[i].height = std::max(1u, header.height >> i);
+		levels[i].size = compressedSizeBC1(int(levels[i].width), int(levels[i].height));
+		levels[i].offset = alignOffset(offset);
+		offset = levels[i].offset + levels[i].size;
+	}
+	header.size = offset;
+
+	m_file.close();
+	m_blob.assign(size_t(offset), 0);
+	std::memcpy(m_blob.data(), &header, sizeof(header));
+	std::memcpy(m_blob.data() + sizeof(header), levels.data(), levels.size() * sizeof(TextureCacheLevel));
+
+	// every level below the first is downsampled from the one above it, in RGB
+	std::vector<unsigned char> level, next;
+	const unsigned char* source = pixels;
+	int sourceChannels = channels;
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		compressBC1(source, int(levels[i].width), int(levels[i].height), sourceChannels, m_blob.data() + levels[i].offset);
+		if (i + 1 == levelCount)
+		{
+			break;
+		}
+
+		if (sourceChannels != 3)
+		{
+			// the first level's pixels as RGB, so downsampling only deals with one layout
+			level.resize(size_t(width) * height * 3);
+			for (size_t texel = 0; texel < size_t(width) * height; texel++)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					level[texel * 3 + c] = channels >= 3 ? pixels[texel * channels + c] : pixels[texel * channels];
+				}
+			}
+			source = level.data();
+			sourceChannels = 3;
+		}
+
+		downsampleRGB(source, int(levels[i].width), int(levels[i].height), next);
+		level.swap(next);
+		source = level.data();
+	}
+
+	return setBlob(m_blob.data(), m_blob.size(), sourceHash);
+}
+
+bool CompressedTexture::write(const std::string& cachePath) const
+{
+	PROFILE_ZONE("CompressedTexture::write");
+
+	std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+	if (!out || m_header == nullptr)
+	{
+		std::cout << "Failed to write texture cache: " << cachePath << std::endl;
+		return false;
+	}
+
+	out.write((const char*)m_header, std::streamsize(m_header->size));
+	if (!out)
+	{
+		std::cout << "Failed to write texture cache: " << cachePath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+size_t CompressedTexture::getDataSize() const
+{
+	size_t size = 0;
+	for (uint32_t i = 0; i < m_header->levelCount; i++)
+	{
+		size += size_t(m_levels[i].size);
+	}
+	return size;
+}
+
+void uploadCompressedLevels(GLenum target, const CompressedTexture& texture, PixelUploadRing* ring)
+{
+	PROFILE_ZONE("uploadCompressedLevels");
+
+	for (uint32_t i = 0; i < texture.getLevelCount(); i++)
+	{
+		const TextureCacheLevel& level = texture.getLevel(i);
+		if (ring != nullptr)
+		{
+			ring->compressedTexImage2D(target, int(i), texture.getFormat(), int(level.width), int(level.height), texture.getLevelData(i), size_t(level.size));
+		}
+		else
+		{
+			GLCall(glCompressedTexImage2D(target, GLint(i), texture.getFormat(), GLsizei(level.width), GLsizei(level.height), 0, GLsizei(level.size), texture.getLevelData(i)));
+			StartupTimeline::addBytesUploaded(level.size);
+		}
+	}
+}
+
+unsigned int uploadCompressedTexture(const CompressedTexture& texture, PixelUploadRing* ring)
+{
+	PROFILE_ZONE("uploadCompressedTexture");
+
+	unsigned int textureID;
+	GLCall(glGenTextures(1, &textureID));
+	GLCall(glActiveTexture(GL_TEXTURE0));
+	GLCall(glBindTexture(GL_TEXTURE_2D, textureID));
+
+	// the mip chain comes with the texture, nothing to generate
+	uploadCompressedLevels(GL_TEXTURE_2D, texture, ring);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(texture.getLevelCount() - 1)));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	return textureID;
+}
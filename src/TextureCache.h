@@ -0,0 +1,128 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "PixelUploadRing.h"
+
+// not part of the core profile glad was generated for, but every desktop driver has it
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#define TEXTURE_CACHE_MAGIC 0x43584554u // "TEXC"
+#define TEXTURE_CACHE_VERSION 1u
+// level data starts on this boundary in the blob
+#define TEXTURE_CACHE_ALIGNMENT 16u
+// appended to the image path, the cache sits next to the image it was built from
+#define TEXTURE_CACHE_EXTENSION ".texcache"
+// enough for a 32768 texel wide texture
+#define TEXTURE_CACHE_MAX_LEVELS 16u
+// bytes of a 4x4 texel BC1 block
+#define BC1_BLOCK_BYTES 8u
+
+// start of a cache blob, followed by levelCount level entries and the aligned level data
+struct TextureCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	// GL internal format of the levels
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	// hashImageSource() of the image it was built from
+	uint64_t sourceHash;
+	// of the whole blob, catches a truncated write
+	uint64_t size;
+};
+
+// one per mip level, largest first, offset from the start of the blob
+struct TextureCacheLevel
+{
+	uint64_t offset;
+	uint64_t size;
+	uint32_t width;
+	uint32_t height;
+};
+
+static_assert(sizeof(TextureCacheHeader) == 40, "texture cache header layout changed, bump TEXTURE_CACHE_VERSION");
+static_assert(sizeof(TextureCacheLevel) == 24, "texture cache level layout changed, bump TEXTURE_CACHE_VERSION");
+
+// hash of the image file as the texture cache is keyed by it, whether the cache has a mip chain is part of it
+// 0 if the file can't be read
+uint64_t hashImageSource(const std::string& path, bool mipmaps);
+
+// BC1 (DXT1) blocks of 8-bit pixels, rows of 4x4 blocks with the edge texels repeated to fill partial blocks
+// channels other than 3 are read as gray (1-2) or with alpha ignored (4); out gets compressedSizeBC1() bytes
+void compressBC1(const unsigned char* pixels, int width, int height, int channels, uint8_t* out);
+size_t compressedSizeBC1(int width, int height);
+
+// next mip level of 8-bit RGB pixels, half the size rounded down (at least 1) with each texel the average of 2x2
+void downsampleRGB(const unsigned char* pixels, int width, int height, std::vector<unsigned char>& out);
+
+// whether the current context can sample the cache's format, textures are uploaded uncompressed otherwise
+bool isTextureCompressionSupported();
+
+/*
+* Block compressed texture with its whole mip chain, ready to be uploaded
+* load() maps the cache next to the image, so the levels go from the page cache to glCompressedTexImage2D without
+* decoding or generating mipmaps. When the cache is missing or was built from a different image the image is decoded,
+* downsampled and compressed to BC1 (a sixth of the RGB8 size) and the cache written for the next start.
+* The level data stays valid as long as the CompressedTexture.
+*/
+class CompressedTexture
+{
+private:
+	MappedFile m_file;
+	// the blob when it was built here rather than mapped, laid out exactly like the file
+	std::vector<uint8_t> m_blob;
+	const TextureCacheHeader* m_header = nullptr;
+	const TextureCacheLevel* m_levels = nullptr;
+
+	// false if the blob doesn't exist, is damaged or was built from another image
+	bool mapCache(const std::string& cachePath, uint64_t sourceHash);
+	// the header and levels of the blob, false if they don't describe a valid texture
+	// sourceHash 0 takes a blob built from any image, the archive's have no image to compare with
+	bool setBlob(const uint8_t* data, size_t size, uint64_t sourceHash);
+
+public:
+	CompressedTexture() = default;
+
+	CompressedTexture(const CompressedTexture&) = delete;
+	CompressedTexture& operator=(const CompressedTexture&) = delete;
+
+	// views the cache in the mounted archive, or maps the cache or builds it from the image, mipmaps false keeps only
+	// the full size level (cube map faces)
+	bool load(const std::string& path, bool mipmaps);
+	// compresses decoded pixels into memory
+	bool compress(const unsigned char* pixels, int width, int height, int channels, bool mipmaps, uint64_t sourceHash);
+	bool write(const std::string& cachePath) const;
+
+	bool isLoaded() const { return m_header != nullptr; }
+	// viewed from a cache file or the archive rather than built by this load
+	bool isCached() const { return m_header != nullptr && m_blob.empty(); }
+	uint32_t getFormat() const { return m_header->format; }
+	uint32_t getWidth() const { return m_header->width; }
+	uint32_t getHeight() const { return m_header->height; }
+	uint32_t getLevelCount() const { return m_header->levelCount; }
+	uint64_t getSourceHash() const { return m_header->sourceHash; }
+	const TextureCacheLevel& getLevel(uint32_t level) const { return m_levels[level]; }
+	const uint8_t* getLevelData(uint32_t level) const { return (const uint8_t*)m_header + m_levels[level].offset; }
+	// header, levels and data laid out exactly like the cache file
+	const uint8_t* getBlob() const { return (const uint8_t*)m_header; }
+	size_t getBlobSize() const { return size_t(m_header->size); }
+	// of every level together, what it takes on the GPU
+	size_t getDataSize() const;
+};
+
+// uploads every level into the texture bound to target, through the ring if one is given
+void uploadCompressedLevels(GLenum target, const CompressedTexture& texture, PixelUploadRing* ring = nullptr);
+
+// mipmapped 2D texture with the same wrapping and filtering uploadTexture() sets
+unsigned int uploadCompressedTexture(const CompressedTexture& texture, PixelUploadRing* ring = nullptr);
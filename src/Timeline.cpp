@@ -0,0 +1,99 @@
+#include "Timeline.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+bool Timeline::load(const std::string& path)
+{
+	std::ifstream in(path);
+	if (!in)
+	{
+		std::cout << "Failed to open timeline: " << path << std::endl;
+		return false;
+	}
+
+	m_keys.clear();
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(in, line))
+	{
+		lineNumber++;
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream fields(line);
+		CameraKey key;
+		if (!(fields >> key.time >> key.position.x >> key.position.y >> key.position.z
+			>> key.orientation.x >> key.orientation.y >> key.orientation.z))
+		{
+			std::cout << path << ":" << lineNumber << ": expected 'time posX posY posZ dirX dirY dirZ'" << std::endl;
+			return false;
+		}
+
+		if (!m_keys.empty() && key.time <= m_keys.back().time)
+		{
+			std::cout << path << ":" << lineNumber << ": keyframe times must increase" << std::endl;
+			return false;
+		}
+
+		key.orientation = glm::normalize(key.orientation);
+		m_keys.push_back(key);
+	}
+
+	return !m_keys.empty();
+}
+
+void Timeline::addKey(const CameraKey& key)
+{
+	CameraKey normalized = key;
+	normalized.orientation = glm::normalize(key.orientation);
+	m_keys.push_back(normalized);
+}
+
+// uniform Catmull-Rom between p1 and p2, p0 and p3 are the neighbouring keys
+static glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2
+		+ (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+void Timeline::sample(float time, glm::vec3& position, glm::vec3& orientation) const
+{
+	if (m_keys.empty())
+	{
+		return;
+	}
+
+	if (time <= m_keys.front().time)
+	{
+		position = m_keys.front().position;
+		orientation = m_keys.front().orientation;
+		return;
+	}
+
+	for (size_t i = 1; i < m_keys.size(); i++)
+	{
+		if (time < m_keys[i].time)
+		{
+			// the end keys are repeated as their own neighbours
+			const CameraKey& before = m_keys[i > 1 ? i - 2 : 0];
+			const CameraKey& from = m_keys[i - 1];
+			const CameraKey& to = m_keys[i];
+			const CameraKey& after = m_keys[i + 1 < m_keys.size() ? i + 1 : i];
+			float t = (time - from.time) / (to.time - from.time);
+
+			position = catmullRom(before.position, from.position, to.position, after.position, t);
+			orientation = glm::normalize(catmullRom(before.orientation, from.orientation, to.orientation, after.orientation, t));
+			return;
+		}
+	}
+
+	position = m_keys.back().position;
+	orientation = m_keys.back().orientation;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+
+// camera keyframe, time in seconds from the start of the timeline
+struct CameraKey
+{
+	float time;
+	glm::vec3 position;
+	glm::vec3 orientation;
+};
+
+/*
+* Scripted camera for headless runs, loaded from a text file with one keyframe per line:
+*   time posX posY posZ dirX dirY dirZ
+* lines starting with '#' are comments, keyframes must be in increasing time order
+* the camera follows a Catmull-Rom spline through the keyframes and holds the last one after the end
+*/
+class Timeline
+{
+private:
+	std::vector<CameraKey> m_keys;
+
+public:
+	bool load(const std::string& path);
+
+	// appends a keyframe, for built in paths (benchmark scenes), time must be after the last key's
+	void addKey(const CameraKey& key);
+
+	bool empty() const { return m_keys.empty(); }
+	float getDuration() const { return m_keys.empty() ? 0.0f : m_keys.back().time; }
+
+	// camera position and (normalized) orientation at the given time
+	void sample(float time, glm::vec3& position, glm::vec3& orientation) const;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+struct Vertex
+{
+	glm::vec3 Position;
+	glm::vec2 TexCoor;
+	glm::vec3 Normal;
+};
+
+// half the size of Vertex: position quantized to the mesh's bounding box (unorm16, the 4th is padding), uv unorm16
+// and the normal as snorm 10:10:10:2 (GL_INT_2_10_10_10_REV)
+struct PackedVertex
+{
+	uint16_t position[4];
+	uint16_t texCoord[2];
+	uint32_t normal;
+};
+
+static_assert(sizeof(Vertex) == 32 && sizeof(PackedVertex) == 16, "vertex layouts changed");
+
+enum class VertexLayout : uint32_t
+{
+	// Vertex
+	Float = 0,
+	// PackedVertex
+	Packed = 1
+};
+
+inline size_t getVertexSize(VertexLayout layout)
+{
+	return layout == VertexLayout::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+// vertex/index arrays of a mesh that live somewhere else (a mapped cache, an import), uploaded without a copy
+struct MeshData
+{
+	// Vertex or PackedVertex, by layout
+	const void* vertices = nullptr;
+	uint32_t vertexCount = 0;
+	VertexLayout layout = VertexLayout::Float;
+	// position = stored position * positionScale + positionOffset, identity for float vertices
+	glm::vec3 positionScale = glm::vec3(1.0f);
+	glm::vec3 positionOffset = glm::vec3(0.0f);
+	// 16 or 32-bit
+	const void* indices = nullptr;
+	uint32_t indexCount = 0;
+	uint32_t indexSize = sizeof(uint32_t);
+};
@@ -13,13 +13,16 @@ out vec2 texCoord;
 // input matrices needed for 3D viewing
 uniform mat4 camMatrix; // proj * view
 
+// scale and offset from packed (unorm16) positions to model space, identity for float positions
+uniform vec3 dequantize[2] = vec3[2](vec3(1.0f), vec3(0.0f));
+
 // pass to fragmant shader
 out vec3 Normal;
 out vec3 FragPosition;
 
 void main()
 {
-	vec4 tempPosition = instanceMatrix * vec4(position, 1.0f);
+	vec4 tempPosition = instanceMatrix * vec4(position * dequantize[0] + dequantize[1], 1.0f);
 
 	// final vertex position
 	gl_Position = camMatrix * tempPosition;
@@ -11,13 +11,16 @@ out vec2 texCoord;
 uniform mat4 model;
 uniform mat4 camMatrix; // proj * view
 
+// scale and offset from packed (unorm16) positions to model space, identity for float positions
+uniform vec3 dequantize[2] = vec3[2](vec3(1.0f), vec3(0.0f));
+
 // need to pass to fragment shader
 out vec3 Normal;
 out vec3 FragPosition;
 
 void main()
 {
-	vec4 tempPosition = model * vec4(position, 1.0f);
+	vec4 tempPosition = model * vec4(position * dequantize[0] + dequantize[1], 1.0f);
 
 	// final vertix position
 	gl_Position = camMatrix * tempPosition;
@@ -11,11 +11,14 @@ out vec2 texCoord;
 uniform mat4 model;
 uniform mat4 camMatrix; // proj * view
 
+// scale and offset from packed (unorm16) positions to model space, identity for float positions
+uniform vec3 dequantize[2] = vec3[2](vec3(1.0), vec3(0.0));
+
 
 void main()
 {
 	// final vertex position
-	gl_Position = camMatrix * model * vec4(position, 1.0);
+	gl_Position = camMatrix * model * vec4(position * dequantize[0] + dequantize[1], 1.0);
 
 	// pass uvs to fragment shader
 	texCoord = texCoor;